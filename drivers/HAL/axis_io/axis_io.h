@@ -0,0 +1,91 @@
+#ifndef AXIS_IO_H //header guard
+#define AXIS_IO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Motor and encoder access of one axis, behind a small driver interface so the
+ * control stack does not depend on the hardware it runs against:
+ *
+ *   axis_io_esp32   LEDC PWM + encoder_reader (ESP-IDF builds only)
+ *   axis_io_sim     first-order speed model, no hardware needed
+ *   axis_io_replay  measured speeds played back from a recorded trace
+ *
+ * Host builds add a DC motor plant backend (host/axis_io_plant.h). Every axis
+ * picks its backend in its configuration, so axes with different backends can
+ * run side by side.
+ */
+
+// Axes each built-in backend can hand out.
+#define AXIS_IO_MAX_AXES 4
+
+/**
+ * @brief Pins and filter of one axis (what the ESP32 backend needs; the other
+ * backends only use the filter, if anything).
+ */
+typedef struct {
+    int pwm_pin;            // GPIO that drives the motor.
+    int pwm_channel;        // LEDC channel, unique per axis.
+    int enc_a_pin;          // Encoder channel A.
+    int enc_b_pin;          // Encoder channel B.
+    float filter_alpha;     // Smoothing factor of the RPM EMA filter.
+    uint32_t period_ms;     // Control period (the speed observer is discretized for it).
+} axis_io_config_t;
+
+/**
+ * @brief Common interface of a motor + encoder backend.
+ *
+ * The instance is opaque to the caller. Apart from create(), every function
+ * runs in the control task of the axis once per period and must not block.
+ */
+typedef struct {
+    const char *name;  // Short name used in reports.
+
+    /**
+     * @brief Takes an instance from the backend's static pool and sets up the
+     * axis (startup only). Returns NULL when the pool is exhausted.
+     */
+    void *(*create)(uint8_t axis, const axis_io_config_t *config);
+
+    /**
+     * @brief Start of a new run: clears whatever state the backend simulates.
+     * Real hardware keeps running.
+     */
+    void (*reset)(void *instance);
+
+    /**
+     * @brief Filtered speed measured over the period that just ended.
+     * @param period_ms The time since the previous call.
+     * @return The speed in RPM.
+     */
+    float (*read_rpm)(void *instance, uint32_t period_ms);
+
+    /**
+     * @brief Drives the motor until the next call.
+     * @param percentage Duty cycle, clamped to DUTY_CYCLE_MIN..DUTY_CYCLE_MAX.
+     * @return The duty cycle actually applied.
+     */
+    float (*set_duty)(void *instance, float percentage);
+} axis_io_ops_t;
+
+// --- Built-in Backends ---
+#ifdef ESP_PLATFORM
+extern const axis_io_ops_t axis_io_esp32;
+#endif
+extern const axis_io_ops_t axis_io_sim;
+extern const axis_io_ops_t axis_io_replay;
+
+/**
+ * @brief Gives the replay backend of one axis the speeds to play back, one
+ * per period. After the last one the speed holds; a reset rewinds.
+ * @param rpm The trace (it must stay valid while it is played).
+ */
+void axis_io_replay_load(uint8_t axis, const float *rpm, size_t count);
+
+/**
+ * @brief Periods of the trace of one axis played since the last reset.
+ */
+size_t axis_io_replay_position(uint8_t axis);
+
+#endif //header guard
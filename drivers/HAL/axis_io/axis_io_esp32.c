@@ -0,0 +1,53 @@
+#include "axis_io.h"
+#include "motor_control.h"
+#include "encoder_reader.h"
+
+// ===================================================================
+// ===== ESP32 BACKEND: LEDC PWM + encoder_reader ====================
+typedef struct {
+    uint8_t axis;
+    int pwm_channel;
+} esp32_instance_t;
+
+static esp32_instance_t esp32_pool[AXIS_IO_MAX_AXES];
+static uint8_t esp32_used = 0;
+
+static void *esp32_create(uint8_t axis, const axis_io_config_t *config) {
+    if (esp32_used >= AXIS_IO_MAX_AXES || axis >= ENCODER_MAX_AXES) {
+        return NULL;
+    }
+    esp32_instance_t *inst = &esp32_pool[esp32_used++];
+    inst->axis = axis;
+    inst->pwm_channel = config->pwm_channel;
+    motor_init_channel(config->pwm_pin, config->pwm_channel);
+    encoder_init_axis(axis, config->enc_a_pin, config->enc_b_pin, config->filter_alpha);
+#if ENCODER_OBSERVER
+    const encoder_observer_model_t model = ENCODER_OBSERVER_MODEL;
+    encoder_setup_observer_axis(axis, &model, config->period_ms);
+#endif
+    return inst;
+}
+
+static void esp32_reset(void *instance) {
+    // The motor and the encoder filter keep running across runs.
+    (void)instance;
+}
+
+static float esp32_read_rpm(void *instance, uint32_t period_ms) {
+    return encoder_get_rpm_axis(((esp32_instance_t *)instance)->axis, (long)period_ms);
+}
+
+static float esp32_set_duty(void *instance, float percentage) {
+    esp32_instance_t *inst = instance;
+    float applied = motor_set_duty_cycle_channel(inst->pwm_channel, percentage);
+    encoder_set_duty_axis(inst->axis, applied);
+    return applied;
+}
+
+const axis_io_ops_t axis_io_esp32 = {
+    .name = "esp32",
+    .create = esp32_create,
+    .reset = esp32_reset,
+    .read_rpm = esp32_read_rpm,
+    .set_duty = esp32_set_duty,
+};
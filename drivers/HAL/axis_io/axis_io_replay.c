@@ -0,0 +1,74 @@
+#include "axis_io.h"
+#include "motor_control.h"
+
+// ===================================================================
+// ===== REPLAY BACKEND: recorded speeds, one per period =============
+typedef struct {
+    const float *rpm;
+    size_t count;
+    size_t position;
+    float duty;              // Last duty cycle commanded
+} replay_instance_t;
+
+// Indexed by axis, so a trace can be loaded before or after create().
+static replay_instance_t replay_pool[AXIS_IO_MAX_AXES];
+
+static float clamp_duty(float percentage) {
+    if (percentage < DUTY_CYCLE_MIN) return DUTY_CYCLE_MIN;
+    if (percentage > DUTY_CYCLE_MAX) return DUTY_CYCLE_MAX;
+    return percentage;
+}
+
+static void *replay_create(uint8_t axis, const axis_io_config_t *config) {
+    (void)config;
+    if (axis >= AXIS_IO_MAX_AXES) {
+        return NULL;
+    }
+    replay_instance_t *inst = &replay_pool[axis];
+    inst->position = 0;
+    inst->duty = DUTY_CYCLE_MIN;
+    return inst;
+}
+
+static void replay_reset(void *instance) {
+    ((replay_instance_t *)instance)->position = 0;
+}
+
+static float replay_read_rpm(void *instance, uint32_t period_ms) {
+    (void)period_ms;
+    replay_instance_t *inst = instance;
+    if (inst->count == 0) {
+        return 0.0f;
+    }
+    if (inst->position < inst->count) {
+        return inst->rpm[inst->position++];
+    }
+    return inst->rpm[inst->count - 1];
+}
+
+static float replay_set_duty(void *instance, float percentage) {
+    replay_instance_t *inst = instance;
+    inst->duty = clamp_duty(percentage);
+    return inst->duty;
+}
+
+const axis_io_ops_t axis_io_replay = {
+    .name = "replay",
+    .create = replay_create,
+    .reset = replay_reset,
+    .read_rpm = replay_read_rpm,
+    .set_duty = replay_set_duty,
+};
+
+void axis_io_replay_load(uint8_t axis, const float *rpm, size_t count) {
+    if (axis >= AXIS_IO_MAX_AXES) {
+        return;
+    }
+    replay_pool[axis].rpm = rpm;
+    replay_pool[axis].count = count;
+    replay_pool[axis].position = 0;
+}
+
+size_t axis_io_replay_position(uint8_t axis) {
+    return axis < AXIS_IO_MAX_AXES ? replay_pool[axis].position : 0;
+}
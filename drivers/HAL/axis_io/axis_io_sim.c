@@ -0,0 +1,58 @@
+#include "axis_io.h"
+#include "motor_control.h"
+
+// ===================================================================
+// ===== SIMULATED BACKEND: first-order speed model ==================
+// rpm(k+1) = 0.95 rpm(k) + 25 u(k), with u the duty cycle mapped back to
+// 0..1 over DUTY_CYCLE_MIN..DUTY_CYCLE_MAX (500 RPM at u = 1).
+#define SIM_POLE 0.95f
+#define SIM_GAIN 25.0f
+
+typedef struct {
+    float rpm;
+} sim_instance_t;
+
+static sim_instance_t sim_pool[AXIS_IO_MAX_AXES];
+static uint8_t sim_used = 0;
+
+static float clamp_duty(float percentage) {
+    if (percentage < DUTY_CYCLE_MIN) return DUTY_CYCLE_MIN;
+    if (percentage > DUTY_CYCLE_MAX) return DUTY_CYCLE_MAX;
+    return percentage;
+}
+
+static void *sim_create(uint8_t axis, const axis_io_config_t *config) {
+    (void)axis;
+    (void)config;
+    if (sim_used >= AXIS_IO_MAX_AXES) {
+        return NULL;
+    }
+    sim_instance_t *inst = &sim_pool[sim_used++];
+    inst->rpm = 0.0f;
+    return inst;
+}
+
+static void sim_reset(void *instance) {
+    ((sim_instance_t *)instance)->rpm = 0.0f;
+}
+
+static float sim_read_rpm(void *instance, uint32_t period_ms) {
+    (void)period_ms;
+    return ((sim_instance_t *)instance)->rpm;
+}
+
+static float sim_set_duty(void *instance, float percentage) {
+    sim_instance_t *inst = instance;
+    float duty = clamp_duty(percentage);
+    float u = (duty - DUTY_CYCLE_MIN) / (DUTY_CYCLE_MAX - DUTY_CYCLE_MIN);
+    inst->rpm = (SIM_POLE * inst->rpm) + (SIM_GAIN * u);
+    return duty;
+}
+
+const axis_io_ops_t axis_io_sim = {
+    .name = "sim",
+    .create = sim_create,
+    .reset = sim_reset,
+    .read_rpm = sim_read_rpm,
+    .set_duty = sim_set_duty,
+};
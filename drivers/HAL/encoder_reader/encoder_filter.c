@@ -0,0 +1,146 @@
+#include "encoder_filter.h"
+#include <stddef.h>
+#include <math.h>
+#include "encoder_reader.h"
+
+void encoder_filter_init(encoder_filter_t *filter, float filter_alpha, uint32_t now_us) {
+    filter->filter_alpha = filter_alpha;
+    filter->filtered_rpm = 0.0f;
+    filter->prev_edge_us = now_us;
+    filter->prev_edge_dir = 0;
+    filter->has_prev_edge = false;
+    filter->mt_rpm = 0.0f;
+    filter->load_rpm = 0.0f;
+    filter->duty_pct = 0.0f;
+}
+
+void encoder_filter_setup_observer(encoder_filter_t *filter, const encoder_observer_model_t *model, uint32_t period_ms) {
+    if (model == NULL || period_ms == 0) {
+        filter->observer = false;
+        return;
+    }
+    float ts = (float)period_ms / 1000.0f;
+    float a = expf(-ts / model->tau_s);
+
+    // Steady-state Kalman gains of x = [speed, load], with
+    //   speed(k+1) = a speed(k) + (1 - a) (rpm_per_duty duty(k) - load(k)),  load(k+1) = load(k)
+    // and the raw speed as the measurement. Its noise is the difference of two
+    // count quantizations (uniform, one pulse wide): variance q^2 / 6.
+    float q = CONVERSION_TO_RPM / (CYCLE_ADJUSTMENT * PPR * (float)period_ms);
+    float r = q * q / 6.0f;
+    float q_speed = model->speed_noise * model->speed_noise * ts;
+    float q_load = model->load_noise * model->load_noise * ts;
+    float b = -(1.0f - a);
+    float p00 = r, p01 = 0.0f, p11 = r;
+    float k0 = 0.0f, k1 = 0.0f;
+    for (int i = 0; i < 1000; i++) {
+        // Predict: P = F P F' + Q, with F = [a b; 0 1]
+        float f00 = a * a * p00 + 2.0f * a * b * p01 + b * b * p11 + q_speed;
+        float f01 = a * p01 + b * p11;
+        float f11 = p11 + q_load;
+        // Correct with H = [1 0]
+        float s = f00 + r;
+        float n0 = f00 / s, n1 = f01 / s;
+        p00 = (1.0f - n0) * f00;
+        p01 = (1.0f - n0) * f01;
+        p11 = f11 - n1 * f01;
+        if (fabsf(n0 - k0) < 1e-7f && fabsf(n1 - k1) < 1e-7f) {
+            k0 = n0;
+            k1 = n1;
+            break;
+        }
+        k0 = n0;
+        k1 = n1;
+    }
+
+    filter->obs_decay = a;
+    filter->obs_duty_gain = (1.0f - a) * model->rpm_per_duty;
+    filter->obs_gain_speed = k0;
+    filter->obs_gain_load = k1;
+    filter->load_rpm = 0.0f;
+    filter->observer = true;
+}
+
+void encoder_filter_set_duty(encoder_filter_t *filter, float duty_pct) {
+    filter->duty_pct = duty_pct;
+}
+
+/**
+ * @brief Hybrid M/T speed estimate of one window.
+ *
+ * M/T: the net pulses of the window divided by the time between the last edge
+ * of the previous window and the last edge of this one. This measures the
+ * time of a whole number of pulses, so one pulse no longer means a 3.8 RPM
+ * step. If no edge arrived, the speed can be at most one pulse over the time
+ * since the last edge, which lets the estimate decay towards zero. The result
+ * is blended into the count-based speed as the pulse count grows.
+ *
+ * @param filter The estimate state.
+ * @param window The counter readings of this window.
+ * @param count_rpm The count-based speed of this window.
+ * @return The raw (unfiltered) speed in RPM.
+ */
+static float encoder_mt_rpm(encoder_filter_t *filter, const encoder_window_t *window, float count_rpm) {
+    long pulses = window->pulses;
+    bool new_edge = window->last_edge_us != filter->prev_edge_us;
+    // A reversal makes the span between edges meaningless.
+    bool monotonic = (pulses > 0 && window->last_edge_dir > 0 && filter->prev_edge_dir >= 0) ||
+                     (pulses < 0 && window->last_edge_dir < 0 && filter->prev_edge_dir <= 0);
+    float mt_rpm;
+
+    if (new_edge && pulses != 0 && filter->has_prev_edge && monotonic) {
+        uint32_t span_us = window->last_edge_us - filter->prev_edge_us;
+        mt_rpm = (span_us > 0) ? ((float)pulses * RPM_PER_PULSE_PER_US / (float)span_us) : count_rpm;
+    } else if (new_edge) {
+        // First edges after start-up or a reversal: no usable reference edge yet.
+        mt_rpm = count_rpm;
+    } else if (filter->has_prev_edge) {
+        uint32_t since_us = window->now_us - filter->prev_edge_us;
+        float bound = (since_us > 0) ? (RPM_PER_PULSE_PER_US / (float)since_us) : fabsf(filter->mt_rpm);
+        mt_rpm = (fabsf(filter->mt_rpm) <= bound) ? filter->mt_rpm : copysignf(bound, filter->mt_rpm);
+    } else {
+        mt_rpm = 0.0f;
+    }
+
+    if (new_edge) {
+        filter->prev_edge_us = window->last_edge_us;
+        filter->prev_edge_dir = window->last_edge_dir;
+        filter->has_prev_edge = true;
+    }
+    filter->mt_rpm = mt_rpm;
+
+    // Blend weight of the count-based speed: 0 at low pulse counts, 1 at high.
+    long n = pulses < 0 ? -pulses : pulses;
+    float w = (float)(n - ENCODER_MT_BLEND_LOW) / (float)(ENCODER_MT_BLEND_HIGH - ENCODER_MT_BLEND_LOW);
+    if (w < 0.0f) w = 0.0f;
+    if (w > 1.0f) w = 1.0f;
+    return (w * count_rpm) + ((1.0f - w) * mt_rpm);
+}
+
+float encoder_filter_step(encoder_filter_t *filter, const encoder_window_t *window, bool mt_method) {
+    // --- RPM Calculation Logic ---
+    float cycles = (float)window->pulses / CYCLE_ADJUSTMENT;
+    float revolutions = cycles / PPR;
+    // This is the raw, noisy RPM calculation
+    float raw_rpm = (revolutions / window->delta_time_ms) * CONVERSION_TO_RPM;
+    if (mt_method) {
+        raw_rpm = encoder_mt_rpm(filter, window, raw_rpm);
+    }
+
+    if (filter->observer) {
+        // --- Speed observer: predict from the duty cycle, correct with the raw speed ---
+        float predicted = filter->obs_decay * filter->filtered_rpm + filter->obs_duty_gain * filter->duty_pct
+                          - (1.0f - filter->obs_decay) * filter->load_rpm;
+        float innovation = raw_rpm - predicted;
+        filter->filtered_rpm = predicted + filter->obs_gain_speed * innovation;
+        filter->load_rpm += filter->obs_gain_load * innovation;
+        return filter->filtered_rpm;
+    }
+
+    // --- Apply the Exponential Moving Average (EMA) filter ---
+    // The new filtered value is a weighted average of the new raw measurement
+    // and the previous filtered value.
+    // Equation: y(k) = alpha * x(k) + (1 - alpha) * y(k-1)
+    filter->filtered_rpm = (filter->filter_alpha * raw_rpm) + ((1.0f - filter->filter_alpha) * filter->filtered_rpm);
+    return filter->filtered_rpm;
+}
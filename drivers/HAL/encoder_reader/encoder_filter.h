@@ -0,0 +1,92 @@
+#ifndef ENCODER_FILTER_H //header guard
+#define ENCODER_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Speed estimate of encoder_get_rpm_axis() as a pure function of its state
+ * and the raw counter readings of one window, with no access to hardware or
+ * clocks. The firmware and the host share this code, so a recorded sequence
+ * of windows yields the same speeds bit for bit on both.
+ *
+ * The raw speed of a window is smoothed by an EMA by default. With the
+ * observer set up (encoder_filter_setup_observer()) a steady-state Kalman
+ * filter replaces the EMA: a first-order model of the motor predicts the
+ * speed from the duty cycle applied during the window, and the raw speed
+ * corrects the prediction and a load estimate. It follows speed changes
+ * that the duty cycle explains without the lag of the EMA.
+ */
+
+/**
+ * @brief Raw input of one speed reading: what the counter saw in one window.
+ */
+typedef struct {
+    int32_t pulses;          // Net pulses counted in the window.
+    uint32_t delta_time_ms;  // Length of the window.
+    uint32_t last_edge_us;   // Time of the last counted edge (M/T only).
+    int8_t last_edge_dir;    // Direction (+1/-1) of the last counted edge (M/T only).
+    uint32_t now_us;         // Time of the reading (M/T only).
+} encoder_window_t;
+
+/**
+ * @brief First-order model of a motor and its load for the speed observer:
+ * tau dw/dt = rpm_per_duty * duty - w - load, with the load drifting freely.
+ */
+typedef struct {
+    float tau_s;             // Mechanical time constant [s].
+    float rpm_per_duty;      // Steady-state speed per % of duty cycle [RPM/%].
+    float speed_noise;       // Unmodeled speed change [RPM/sqrt(s)].
+    float load_noise;        // Drift of the load [RPM/sqrt(s)].
+} encoder_observer_model_t;
+
+/**
+ * @brief State of the speed estimate of one encoder.
+ */
+typedef struct {
+    float filter_alpha;      // Smoothing factor of the EMA.
+    float filtered_rpm;      // Estimate (EMA or observer output), kept between windows.
+    // M/T state: last edge of the previous window.
+    uint32_t prev_edge_us;
+    int8_t prev_edge_dir;
+    bool has_prev_edge;
+    float mt_rpm;
+    // Observer (encoder_filter_setup_observer()); the EMA runs while it is off.
+    bool observer;
+    float obs_decay;         // Speed kept per window, exp(-Ts / tau).
+    float obs_duty_gain;     // (1 - decay) * rpm_per_duty.
+    float obs_gain_speed;    // Steady-state Kalman gains of speed and load.
+    float obs_gain_load;
+    float load_rpm;          // Load estimate (speed lost to it in steady state).
+    float duty_pct;          // Duty cycle applied during the current window.
+} encoder_filter_t;
+
+/**
+ * @brief Resets the estimate to standstill. The observer setup is kept.
+ * @param now_us Current time, taken as the time of the last edge.
+ */
+void encoder_filter_init(encoder_filter_t *filter, float filter_alpha, uint32_t now_us);
+
+/**
+ * @brief Replaces the EMA with the speed observer, discretized for windows of
+ * period_ms. The steady-state gains are computed here (startup only); the
+ * update per window is a handful of multiplications.
+ * @param model The motor model, or NULL to go back to the EMA.
+ */
+void encoder_filter_setup_observer(encoder_filter_t *filter, const encoder_observer_model_t *model, uint32_t period_ms);
+
+/**
+ * @brief Duty cycle applied from now until the next window is read (the
+ * input of the observer's prediction).
+ */
+void encoder_filter_set_duty(encoder_filter_t *filter, float duty_pct);
+
+/**
+ * @brief Speed of one window: count-based (or hybrid M/T) raw speed, then the
+ * EMA or the observer.
+ * @param mt_method true to blend in the M/T estimate (see ENCODER_MT_METHOD).
+ * @return The filtered speed in RPM.
+ */
+float encoder_filter_step(encoder_filter_t *filter, const encoder_window_t *window, bool mt_method);
+
+#endif //header guard
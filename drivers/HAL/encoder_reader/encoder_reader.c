@@ -1,69 +1,270 @@
 #include "encoder_reader.h"
+#include <string.h>
 #include "driver/gpio.h"
-#include "soc/gpio_struct.h"
 #include "freertos/FreeRTOS.h"
+#if ENCODER_BACKEND == ENCODER_BACKEND_PCNT
+#include "driver/pulse_cnt.h"
+#else
+#include "soc/gpio_struct.h"
+#include "esp_cpu.h"
+#endif
+#if ENCODER_MT_METHOD
+#include "esp_timer.h"
+#if ENCODER_BACKEND != ENCODER_BACKEND_GPIO_ISR
+#error "ENCODER_MT_METHOD needs the edge timestamps of the GPIO ISR backend"
+#endif
+#endif
+
+// --- Per-axis Encoder State ---
+typedef struct {
+#if ENCODER_BACKEND == ENCODER_BACKEND_PCNT
+    pcnt_unit_handle_t unit;
+    int last_count;
+#else
+    volatile long pulse_count;
+    volatile uint8_t old_AB;
+    encoder_isr_stats_t isr_stats;
+    // Time and direction of the most recent counted edge (written by the ISR).
+    volatile uint32_t last_edge_us;
+    volatile int8_t last_edge_dir;
+#endif
+    uint8_t pin_a;
+    uint8_t pin_b;
+    // The speed estimate retains its state between calls to encoder_get_rpm_axis().
+    encoder_filter_t filter;
+    encoder_window_t window;      // Readings of the last window.
+} encoder_axis_t;
+
+static encoder_axis_t encoder_axes[ENCODER_MAX_AXES];
+
+#if ENCODER_BACKEND == ENCODER_BACKEND_PCNT
+// ===================================================================
+// ===== PCNT BACKEND: hardware quadrature counter ===================
+#define PCNT_EDGE_ACTION(sign) ((sign) > 0 ? PCNT_CHANNEL_EDGE_ACTION_INCREASE : PCNT_CHANNEL_EDGE_ACTION_DECREASE)
+
+// Initializes one PCNT unit as a 4x quadrature decoder for one encoder.
+void encoder_init_axis(uint8_t axis_id, int pin_a, int pin_b, float filter_alpha) {
+    encoder_axis_t *axis = &encoder_axes[axis_id];
+    axis->pin_a = (uint8_t)pin_a;
+    axis->pin_b = (uint8_t)pin_b;
+    axis->last_count = 0;
+    encoder_filter_init(&axis->filter, filter_alpha, 0);
+
+    // With accum_count the driver extends the 16-bit hardware counter in
+    // software every time it reaches one of the limits, so the count never wraps.
+    pcnt_unit_config_t unit_config = {
+        .high_limit = ENCODER_PCNT_LIMIT,
+        .low_limit = -ENCODER_PCNT_LIMIT,
+        .flags.accum_count = 1,
+    };
+    pcnt_new_unit(&unit_config, &axis->unit);
 
-// --- Global Variables for the Encoder ---
-static volatile long pulse_count = 0;
-static volatile uint8_t old_AB = 0;
-static const int8_t QEM[16] = {0,-1,1,0,1,0,0,-1,-1,0,0,1,0,1,-1,0};
+    // Pulses shorter than the glitch filter are ignored by the hardware.
+    pcnt_glitch_filter_config_t filter_config = {
+        .max_glitch_ns = ENCODER_PCNT_GLITCH_NS,
+    };
+    pcnt_unit_set_glitch_filter(axis->unit, &filter_config);
 
-// --- State variable for the filter ---
-// 'static' ensures this variable retains its value between calls to encoder_get_rpm().
-static float filtered_rpm = 0.0f;
+    // Each channel counts the edges of one signal, with the other signal as
+    // direction. Together they decode every edge of A and B (4x), with the
+    // same sign convention as the QEM table of the GPIO ISR backend
+    // (ENCODER_PCNT_* in encoder_reader.h).
+    pcnt_chan_config_t chan_a_config = {
+        .edge_gpio_num = pin_a,
+        .level_gpio_num = pin_b,
+    };
+    pcnt_channel_handle_t chan_a = NULL;
+    pcnt_new_channel(axis->unit, &chan_a_config, &chan_a);
+    pcnt_chan_config_t chan_b_config = {
+        .edge_gpio_num = pin_b,
+        .level_gpio_num = pin_a,
+    };
+    pcnt_channel_handle_t chan_b = NULL;
+    pcnt_new_channel(axis->unit, &chan_b_config, &chan_b);
+
+    pcnt_channel_set_edge_action(chan_a, PCNT_EDGE_ACTION(ENCODER_PCNT_A_RISING), PCNT_EDGE_ACTION(ENCODER_PCNT_A_FALLING));
+    pcnt_channel_set_level_action(chan_a, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+    pcnt_channel_set_edge_action(chan_b, PCNT_EDGE_ACTION(ENCODER_PCNT_B_RISING), PCNT_EDGE_ACTION(ENCODER_PCNT_B_FALLING));
+    pcnt_channel_set_level_action(chan_b, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+
+    // The limits must be watch points for the overflow accumulation to work.
+    pcnt_unit_add_watch_point(axis->unit, ENCODER_PCNT_LIMIT);
+    pcnt_unit_add_watch_point(axis->unit, -ENCODER_PCNT_LIMIT);
+
+    pcnt_unit_enable(axis->unit);
+    pcnt_unit_clear_count(axis->unit);
+    pcnt_unit_start(axis->unit);
+}
+
+// Returns the pulses counted since the previous call. The PCNT has no edge
+// timestamps, so the edge outputs are left untouched.
+static long encoder_take_pulses(encoder_axis_t *axis, uint32_t *last_edge_us, int8_t *last_edge_dir) {
+    int count = 0;
+    pcnt_unit_get_count(axis->unit, &count);
+    // The difference is taken in unsigned arithmetic, so even the wrap of the
+    // accumulated int count after ~2^31 pulses yields the right delta.
+    long pulses = (long)(int)((unsigned)count - (unsigned)axis->last_count);
+    axis->last_count = count;
+    return pulses;
+}
+
+void encoder_get_isr_stats(uint8_t axis_id, encoder_isr_stats_t *stats) {
+    // No interrupt per edge with the PCNT backend.
+    memset(stats, 0, sizeof(*stats));
+}
+
+void encoder_reset_isr_stats(void) {
+}
+
+#else
+// ===================================================================
+// ===== GPIO ISR BACKEND: one interrupt per edge =====================
+static const int8_t QEM[16] = ENCODER_QEM_TABLE;
+
+// The ISR may run on the other core than the control step reading the count,
+// so a spinlock is needed (disabling interrupts only protects the local core).
+static portMUX_TYPE encoder_mux = portMUX_INITIALIZER_UNLOCKED;
 
 // The Interrupt Service Routine (ISR) that runs every time an encoder pin changes state.
+// 'arg' points to the state of the axis the pin belongs to.
 static void IRAM_ATTR encoderISR(void* arg) {
+    encoder_axis_t *axis = (encoder_axis_t *)arg;
+#if ENCODER_ISR_STATS
+    uint32_t start_cycles = esp_cpu_get_cycle_count();
+#endif
     uint32_t gpio_in = GPIO.in;
-    old_AB <<= 2;
-    uint8_t state_A = (gpio_in >> ENC_A_PIN) & 1;
-    uint8_t state_B = (gpio_in >> ENC_B_PIN) & 1;
+    uint8_t state_A = (gpio_in >> axis->pin_a) & 1;
+    uint8_t state_B = (gpio_in >> axis->pin_b) & 1;
     uint8_t new_AB = (state_A << 1) | state_B;
-    old_AB |= new_AB;
-    pulse_count += QEM[old_AB & 0x0f];
+#if ENCODER_MT_METHOD
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+#endif
+
+    portENTER_CRITICAL_ISR(&encoder_mux);
+    axis->old_AB = (uint8_t)((axis->old_AB << 2) | new_AB);
+    int8_t step = QEM[axis->old_AB & 0x0f];
+    axis->pulse_count += step;
+#if ENCODER_MT_METHOD
+    if (step != 0) {
+        axis->last_edge_us = now_us;
+        axis->last_edge_dir = step;
+    }
+#endif
+#if ENCODER_ISR_STATS
+    axis->isr_stats.calls++;
+    axis->isr_stats.cycles += esp_cpu_get_cycle_count() - start_cycles;
+#endif
+    portEXIT_CRITICAL_ISR(&encoder_mux);
 }
 
-// Initializes the GPIO pins and sets up the interrupts for the encoder.
-void encoder_init() {
+// Initializes the GPIO pins and sets up the interrupts for one encoder.
+void encoder_init_axis(uint8_t axis_id, int pin_a, int pin_b, float filter_alpha) {
+    encoder_axis_t *axis = &encoder_axes[axis_id];
+    axis->pin_a = (uint8_t)pin_a;
+    axis->pin_b = (uint8_t)pin_b;
+    axis->pulse_count = 0;
+
     gpio_config_t io_conf = {
         .intr_type = GPIO_INTR_ANYEDGE,
-        .pin_bit_mask = (1ULL << ENC_A_PIN) | (1ULL << ENC_B_PIN),
+        .pin_bit_mask = (1ULL << pin_a) | (1ULL << pin_b),
         .mode = GPIO_MODE_INPUT,
-        .pull_up_en = GPIO_PULLUP_ENABLE, 
+        .pull_up_en = GPIO_PULLUP_ENABLE,
         .pull_down_en = GPIO_PULLDOWN_DISABLE,
     };
     gpio_config(&io_conf);
-    
-    old_AB = ((gpio_get_level(ENC_A_PIN) << 1) | gpio_get_level(ENC_B_PIN));
 
+    axis->old_AB = ((gpio_get_level(pin_a) << 1) | gpio_get_level(pin_b));
+#if ENCODER_MT_METHOD
+    axis->last_edge_us = (uint32_t)esp_timer_get_time();
+#else
+    axis->last_edge_us = 0;
+#endif
+    axis->last_edge_dir = 0;
+    encoder_filter_init(&axis->filter, filter_alpha, axis->last_edge_us);
+
+    // Installing the ISR service a second time just returns an error, which is harmless.
     gpio_install_isr_service(0);
-    gpio_isr_handler_add(ENC_A_PIN, encoderISR, NULL);
-    gpio_isr_handler_add(ENC_B_PIN, encoderISR, NULL);
+    gpio_isr_handler_add(pin_a, encoderISR, axis);
+    gpio_isr_handler_add(pin_b, encoderISR, axis);
+}
+
+// Returns the pulses counted since the previous call, with the time and
+// direction of the last edge (consistent with the count).
+static long encoder_take_pulses(encoder_axis_t *axis, uint32_t *last_edge_us, int8_t *last_edge_dir) {
+    long pulses;
+    portENTER_CRITICAL(&encoder_mux);
+    pulses = axis->pulse_count;
+    axis->pulse_count = 0;
+    *last_edge_us = axis->last_edge_us;
+    *last_edge_dir = axis->last_edge_dir;
+    portEXIT_CRITICAL(&encoder_mux);
+    return pulses;
+}
+
+void encoder_get_isr_stats(uint8_t axis_id, encoder_isr_stats_t *stats) {
+    portENTER_CRITICAL(&encoder_mux);
+    *stats = encoder_axes[axis_id].isr_stats;
+    portEXIT_CRITICAL(&encoder_mux);
+}
+
+void encoder_reset_isr_stats(void) {
+    portENTER_CRITICAL(&encoder_mux);
+    for (int i = 0; i < ENCODER_MAX_AXES; i++) {
+        memset(&encoder_axes[i].isr_stats, 0, sizeof(encoder_axes[i].isr_stats));
+    }
+    portEXIT_CRITICAL(&encoder_mux);
+}
+#endif
+
+// Initializes the default encoder (axis 0) on ENC_A_PIN / ENC_B_PIN.
+void encoder_init() {
+    encoder_init_axis(0, ENC_A_PIN, ENC_B_PIN, RPM_FILTER_ALPHA);
+}
+
+/**
+ * @brief Calculates the speed of one axis in RPM based on the pulses counted since the last call.
+ * @param axis_id The axis to read.
+ * @param delta_time_ms The time elapsed (in milliseconds) since this function was last called.
+ * @return The filtered speed in Revolutions Per Minute (RPM).
+ */
+float encoder_get_rpm_axis(uint8_t axis_id, long delta_time_ms) {
+    encoder_axis_t *axis = &encoder_axes[axis_id];
+    encoder_window_t *window = &axis->window;
+    uint32_t last_edge_us = 0;
+    int8_t last_edge_dir = 0;
+    window->pulses = (int32_t)encoder_take_pulses(axis, &last_edge_us, &last_edge_dir);
+    window->delta_time_ms = (uint32_t)delta_time_ms;
+    window->last_edge_us = last_edge_us;
+    window->last_edge_dir = last_edge_dir;
+#if ENCODER_MT_METHOD
+    window->now_us = (uint32_t)esp_timer_get_time();
+#else
+    window->now_us = 0;
+#endif
+    return encoder_filter_step(&axis->filter, window, ENCODER_MT_METHOD);
+}
+
+void encoder_setup_observer_axis(uint8_t axis_id, const encoder_observer_model_t *model, uint32_t period_ms) {
+    encoder_filter_setup_observer(&encoder_axes[axis_id].filter, model, period_ms);
+}
+
+void encoder_set_duty_axis(uint8_t axis_id, float duty_pct) {
+    encoder_filter_set_duty(&encoder_axes[axis_id].filter, duty_pct);
+}
+
+void encoder_get_window(uint8_t axis_id, encoder_window_t *window) {
+    *window = encoder_axes[axis_id].window;
+}
+
+void encoder_get_filter(uint8_t axis_id, encoder_filter_t *filter) {
+    *filter = encoder_axes[axis_id].filter;
 }
 
 /**
- * @brief Calculates the motor's speed in RPM based on the pulses counted since the last call.
+ * @brief Calculates the motor's speed in RPM for the default encoder (axis 0).
  * @param delta_time_ms The time elapsed (in milliseconds) since this function was last called.
  * @return The filtered speed in Revolutions Per Minute (RPM).
  */
 float encoder_get_rpm(long delta_time_ms) {
-    long pulses;
-    portDISABLE_INTERRUPTS();
-    pulses = pulse_count;
-    pulse_count = 0;
-    portENABLE_INTERRUPTS();
-    
-    // --- RPM Calculation Logic ---
-    float cycles = (float)pulses / CYCLE_ADJUSTMENT;
-    float revolutions = cycles / PPR;
-    // This is the raw, noisy RPM calculation
-    float raw_rpm = (revolutions / delta_time_ms) * CONVERSION_TO_RPM;
-
-    // --- Apply the Exponential Moving Average (EMA) filter ---
-    // The new filtered value is a weighted average of the new raw measurement
-    // and the previous filtered value.
-    // Equation: y(k) = alpha * x(k) + (1 - alpha) * y(k-1)
-    filtered_rpm = (RPM_FILTER_ALPHA * raw_rpm) + ((1.0f - RPM_FILTER_ALPHA) * filtered_rpm);
-    
-    return filtered_rpm; // Return the smooth, filtered value.
-}
\ No newline at end of file
+    return encoder_get_rpm_axis(0, delta_time_ms);
+}
@@ -1,7 +1,64 @@
 #ifndef ENCODER_READER_H
 #define ENCODER_READER_H
 
+#include <stdint.h>
+#include "encoder_filter.h"
+
+// --- Counting Backend ---
+// GPIO_ISR: one interrupt per edge of A and B, decoded with a state table.
+// PCNT: the pulse counter peripheral decodes the quadrature signal in hardware;
+// the CPU only reads the counter once per control period.
+#define ENCODER_BACKEND_GPIO_ISR 0
+#define ENCODER_BACKEND_PCNT     1
+#ifndef ENCODER_BACKEND
+#define ENCODER_BACKEND ENCODER_BACKEND_GPIO_ISR
+#endif
+
+// PCNT counter limits (the hardware counter is 16 bits). Overflows at these
+// limits are accumulated by the driver, so the count does not wrap.
+#define ENCODER_PCNT_LIMIT     10000
+// Edges shorter than this are rejected by the PCNT glitch filter
+// (1 us; an edge at 3000 RPM is 25 us apart with 4x decoding).
+#define ENCODER_PCNT_GLITCH_NS 1000
+
+// --- Quadrature Sign Convention ---
+// Step of the GPIO ISR backend, indexed by (old_AB << 2) | new_AB with
+// AB = (A << 1) | B: A leading B (00 -> 10 -> 11 -> 01) counts up.
+#define ENCODER_QEM_TABLE {0,-1,1,0,1,0,0,-1,-1,0,0,1,0,1,-1,0}
+// The same convention for the PCNT backend. Channel A counts the edges of A
+// and channel B those of B; each sign below applies while the other signal is
+// high and is inverted while it is low. host/quadrature_check compares both.
+#define ENCODER_PCNT_A_RISING  (-1)
+#define ENCODER_PCNT_A_FALLING (+1)
+#define ENCODER_PCNT_B_RISING  (+1)
+#define ENCODER_PCNT_B_FALLING (-1)
+
+// 1 = measure the number of GPIO interrupts and the cycles spent in them
+// (idf.py -DENCODER_ISR_STATS=ON build). Off, the ISR reads no cycle counter
+// and the ENCODER_ISR: counters stay at zero.
+#ifndef ENCODER_ISR_STATS
+#define ENCODER_ISR_STATS 0
+#endif
+
+// --- M/T Speed Measurement ---
+// 1 = hybrid M/T method: the ISR timestamps every edge and the speed is the
+// net pulse count divided by the time between the last edge of the previous
+// window and the last edge of this one, instead of by the fixed window.
+// Needs edge timestamps, so it is only available with the GPIO ISR backend.
+#ifndef ENCODER_MT_METHOD
+#define ENCODER_MT_METHOD (ENCODER_BACKEND == ENCODER_BACKEND_GPIO_ISR)
+#endif
+// Blend between the M/T and the count-based speed, in pulses per window:
+// at or below LOW only M/T is used, at or above HIGH only the pulse count
+// (one pulse per 10 ms window is about 3.8 RPM).
+#define ENCODER_MT_BLEND_LOW   4
+#define ENCODER_MT_BLEND_HIGH  20
+
 // --- Encoder Parameters ---
+// Maximum number of encoders (axes). With the GPIO ISR backend the encoder
+// pins must be below GPIO 32, because the ISR samples both channels from the
+// GPIO.in register.
+#define ENCODER_MAX_AXES 4
 #define ENC_A_PIN   25
 #define ENC_B_PIN   26
 #define PPR         199.0f
@@ -11,17 +68,62 @@
 // A smaller value (e.g., 0.1) results in a smoother (but slower) signal.
 #define RPM_FILTER_ALPHA 0.1f
 
+// --- Speed Observer ---
+// 1 = replace the EMA with the model-based observer of encoder_filter.h: it
+// predicts the speed from the applied duty cycle and corrects it with the
+// counted pulses, so it lags far less than the EMA for the same noise.
+#ifndef ENCODER_OBSERVER
+#define ENCODER_OBSERVER 0
+#endif
+// Model of the motor and its load. Identify tau and the gain from a step of
+// the duty cycle; the noise densities trade lag for smoothness.
+#define ENCODER_OBSERVER_MODEL { \
+    .tau_s = 0.097f,             /* Mechanical time constant [s] */ \
+    .rpm_per_duty = 25.0f,       /* Steady-state RPM per % of duty */ \
+    .speed_noise = 3.0f,         /* Unmodeled speed change [RPM/sqrt(s)] */ \
+    .load_noise = 20.0f,         /* Load drift [RPM/sqrt(s)] */ \
+}
+// PID gains that ENCODER_OBSERVER builds start with. The default gains were
+// tuned against the lag of the EMA and chatter on the observer's estimate;
+// these come from gain_sweep pid --observer with the model above (Kd = 0:
+// the observer passes the count quantization through to the D term).
+#define ENCODER_OBSERVER_PID_KP 0.006
+#define ENCODER_OBSERVER_PID_KI 0.5
+#define ENCODER_OBSERVER_PID_KD 0.0
+
 // --- RPM Calculation Constants ---
 // This factor likely accounts for 4x decoding and another project-specific calibration.
 #define CYCLE_ADJUSTMENT 8.0f
 // Constant to convert revolutions per millisecond to RPM.
 #define CONVERSION_TO_RPM 60000.0f
+// Speed in RPM of one pulse per microsecond (used by the M/T method).
+#define RPM_PER_PULSE_PER_US (60000000.0f / (CYCLE_ADJUSTMENT * PPR))
+
+/**
+ * @brief CPU cost of the GPIO ISR backend since the last reset.
+ * The cycles cover the handler body only; the dispatch of the shared GPIO
+ * interrupt adds a fixed cost of roughly 1-2 us per call on top.
+ * Always zero with the PCNT backend or without ENCODER_ISR_STATS.
+ */
+typedef struct {
+    uint32_t calls;   // Interrupts handled.
+    uint64_t cycles;  // CPU cycles spent in the handler.
+} encoder_isr_stats_t;
 
 /**
  * @brief Initializes the GPIO pins and interrupts for the encoder.
  */
 void encoder_init();
 
+/**
+ * @brief Initializes the GPIO pins and interrupts for the encoder of one axis.
+ * @param axis_id The axis index (0 to ENCODER_MAX_AXES - 1).
+ * @param pin_a GPIO of channel A.
+ * @param pin_b GPIO of channel B.
+ * @param filter_alpha Smoothing factor of the RPM EMA filter for this axis.
+ */
+void encoder_init_axis(uint8_t axis_id, int pin_a, int pin_b, float filter_alpha);
+
 /**
  * @brief Calculates the current filtered speed of the motor in RPM.
  * @param delta_time_ms The time elapsed (in milliseconds) since the last call.
@@ -29,4 +131,46 @@ void encoder_init();
  */
 float encoder_get_rpm(long delta_time_ms);
 
+/**
+ * @brief Calculates the current filtered speed of one axis in RPM.
+ * @param axis_id The axis index.
+ * @param delta_time_ms The time elapsed (in milliseconds) since the last call for this axis.
+ * @return The filtered speed in Revolutions Per Minute (RPM).
+ */
+float encoder_get_rpm_axis(uint8_t axis_id, long delta_time_ms);
+
+/**
+ * @brief Replaces the EMA of one axis with the speed observer (startup only).
+ * @param model The motor model (ENCODER_OBSERVER_MODEL).
+ * @param period_ms The control period.
+ */
+void encoder_setup_observer_axis(uint8_t axis_id, const encoder_observer_model_t *model, uint32_t period_ms);
+
+/**
+ * @brief Duty cycle applied to the motor of one axis until the next
+ * encoder_get_rpm_axis() call (input of the observer). Control task only.
+ */
+void encoder_set_duty_axis(uint8_t axis_id, float duty_pct);
+
+/**
+ * @brief Copies the counter readings of the last encoder_get_rpm_axis() call
+ * of one axis (its raw input, see encoder_filter.h). Control task only.
+ */
+void encoder_get_window(uint8_t axis_id, encoder_window_t *window);
+
+/**
+ * @brief Copies the state of the speed estimate of one axis. Control task only.
+ */
+void encoder_get_filter(uint8_t axis_id, encoder_filter_t *filter);
+
+/**
+ * @brief Copies the interrupt counters of one axis.
+ */
+void encoder_get_isr_stats(uint8_t axis_id, encoder_isr_stats_t *stats);
+
+/**
+ * @brief Clears the interrupt counters of every axis.
+ */
+void encoder_reset_isr_stats(void);
+
 #endif // ENCODER_READER_H
\ No newline at end of file
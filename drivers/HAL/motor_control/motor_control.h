@@ -14,6 +14,14 @@
  */
 void motor_init();
 
+/**
+ * @brief Initializes the PWM output of one motor on its own LEDC channel.
+ * All channels share one LEDC timer (PWM_FREQ, PWM_RESOLUTION).
+ * @param pwm_pin The GPIO that drives the motor.
+ * @param pwm_channel The LEDC channel (0 to 7).
+ */
+void motor_init_channel(int pwm_pin, int pwm_channel);
+
 /**
  * @brief Establishes the PWM signal for motor control.
  * @param percentage The desired duty cycle percentage (0.0 to 100.0) is constrained between DUTY_CYCLE_MIN and DUTY_CYCLE_MAX.
@@ -21,4 +29,12 @@ void motor_init();
  */
 float motor_set_duty_cycle(float percentage);
 
+/**
+ * @brief Establishes the PWM signal of the motor on one LEDC channel.
+ * @param pwm_channel The LEDC channel given to motor_init_channel().
+ * @param percentage The desired duty cycle percentage, constrained between DUTY_CYCLE_MIN and DUTY_CYCLE_MAX.
+ * @return float The actual duty cycle that was set.
+ */
+float motor_set_duty_cycle_channel(int pwm_channel, float percentage);
+
 #endif //header guard
\ No newline at end of file
@@ -4,16 +4,30 @@
  */
 
 #include "PID_Difuso.h"
+#include "PID_Difuso_private.h"
 #include "rtwtypes.h"
 #include <math.h>
 #include "rt_nonfinite.h"
 #include <string.h>
 
-// ===== GANANCIAS DEL CONTROLADOR PID DIFUSO ========================
-// Entre 20
-#define FUZZY_KP 2.0f // Ganancia Proporcional (escala el error antes de la lógica difusa)
-#define FUZZY_KI 8.0f // Ganancia Integral (escala la salida del integrador)
-#define FUZZY_KD 0.0f // Ganancia Derivativa (escala la derivada del error)
+// ===== PRECISIÓN (ver CONTROL_SINGLE_PRECISION en rtwtypes.h) =======
+// En simple precisión se usan las variantes float de la libm para no
+// pasar por double (la FPU del ESP32 solo opera en simple precisión).
+#if CONTROL_SINGLE_PRECISION
+#define rt_fmin fminf
+#define rt_fabs fabsf
+#define PID_Difuso_HALF_REALMAX 1.7014117E+38F   /* realmax('single') / 2 */
+#else
+#define rt_fmin fmin
+#define rt_fabs fabs
+#define PID_Difuso_HALF_REALMAX 8.9884656743115785E+307 /* realmax / 2 */
+#endif
+
+/* Superficie de control precalculada: salida fuzzy PD sobre una malla
+ * (error, delta-error), construida una sola vez a partir del motor de
+ * inferencia original. Fila = delta-error, columna = error. */
+static real32_T PID_Difuso_surface[PID_Difuso_SURF_NDE][PID_Difuso_SURF_NE];
+static boolean_T PID_Difuso_surface_ready = false;
 
 /* Block states */
 DW_PID_Difuso_T PID_Difuso_DW;
@@ -24,8 +38,24 @@ ExtU_PID_Difuso_T PID_Difuso_U;
 /* External outputs */
 ExtY_PID_Difuso_T PID_Difuso_Y;
 
+/* Parámetros ajustables de la instancia global */
+P_PID_Difuso_T PID_Difuso_P = {
+  FUZZY_KP,                            /* KP */
+  FUZZY_KI,                            /* KI */
+  FUZZY_KD,                            /* KD */
+  FUZZY_E_RANGE,                       /* E_RANGE */
+  FUZZY_DE_RANGE,                      /* DE_RANGE */
+  FUZZY_OUT_RANGE                      /* OUT_RANGE */
+};
+
 /* Real-time model */
-static RT_MODEL_PID_Difuso_T PID_Difuso_M_;
+static RT_MODEL_PID_Difuso_T PID_Difuso_M_ = {
+  NULL,                                /* errorStatus */
+  &PID_Difuso_P,
+  &PID_Difuso_DW,
+  &PID_Difuso_U,
+  &PID_Difuso_Y
+};
 RT_MODEL_PID_Difuso_T *const PID_Difuso_M = &PID_Difuso_M_;
 
 /* Forward declaration for local functions */
@@ -42,21 +72,21 @@ static void PID_Difuso_linspace(real_T d1, real_T d2, real_T y[11])
   y[10] = d2;
   y[0] = d1;
   if (d1 == -d2) {
-    delta1 = d2 / 5.0;
+    delta1 = d2 / (real_T)5.0;
     for (k = 0; k < 9; k++) {
-      y[k + 1] = ((real_T)k + 1.0) * delta1 + d1;
+      y[k + 1] = ((real_T)k + (real_T)1.0) * delta1 + d1;
     }
-  } else if (((d1 < 0.0) != (d2 < 0.0)) && ((fabs(d1) > 8.9884656743115785E+307) ||
-              (fabs(d2) > 8.9884656743115785E+307))) {
-    delta1 = d1 / 10.0;
-    d2 /= 10.0;
+  } else if (((d1 < (real_T)0.0) != (d2 < (real_T)0.0)) && ((rt_fabs(d1) > PID_Difuso_HALF_REALMAX) ||
+              (rt_fabs(d2) > PID_Difuso_HALF_REALMAX))) {
+    delta1 = d1 / (real_T)10.0;
+    d2 /= (real_T)10.0;
     for (k = 0; k < 9; k++) {
-      y[k + 1] = (delta1 + d2 * ((real_T)k + 1.0)) * 10.0;
+      y[k + 1] = (delta1 + d2 * ((real_T)k + (real_T)1.0)) * (real_T)10.0;
     }
   } else {
-    delta1 = (d2 - d1) / 10.0;
+    delta1 = (d2 - d1) / (real_T)10.0;
     for (k = 0; k < 9; k++) {
-      y[k + 1] = ((real_T)k + 1.0) * delta1 + d1;
+      y[k + 1] = ((real_T)k + (real_T)1.0) * delta1 + d1;
     }
   }
 }
@@ -65,7 +95,6 @@ static void PID_Difuso_compute_memberships(real_T x, const real_T mivals[11],
   real_T mu[11])
 {
   real_T dv[10];
-  real_T dv1[9];
   real_T U;
   real_T l;
   int b_i;
@@ -77,10 +106,6 @@ static void PID_Difuso_compute_memberships(real_T x, const real_T mivals[11],
     dv[i] = mivals[i + 1] - mivals[i];
   }
 
-  for (i = 0; i < 9; i++) {
-    dv1[i] = dv[i + 1];
-  }
-
   memset(&mu[0], 0, 11U * sizeof(real_T));
   for (i = 0; i < 11; i++) {
     c_data[i] = (x == mivals[i]);
@@ -100,7 +125,7 @@ static void PID_Difuso_compute_memberships(real_T x, const real_T mivals[11],
 
   guard1 = false;
   if (i > 0) {
-    mu[i - 1] = 1.0;
+    mu[i - 1] = (real_T)1.0;
     guard1 = true;
   } else {
     for (i = 0; i < 11; i++) {
@@ -121,37 +146,37 @@ static void PID_Difuso_compute_memberships(real_T x, const real_T mivals[11],
 
     if (i > 0) {
       if (i == 1) {
-        mu[0] = 1.0;
+        mu[0] = (real_T)1.0;
       } else {
         U = mivals[i - 1];
         l = mivals[i - 2];
         if (i == 2) {
           U = (x - l) / dv[0];
-          mu[0] = 1.0 - U;
+          mu[0] = (real_T)1.0 - U;
           mu[1] = U;
         } else {
           U = (x - l) / dv[i - 2];
-          mu[i - 2] = 1.0 - U;
+          mu[i - 2] = (real_T)1.0 - U;
           mu[i - 1] = U;
         }
       }
 
       guard1 = true;
     } else {
-      mu[10] = 1.0;
+      mu[10] = (real_T)1.0;
     }
   }
 
   if (guard1) {
     for (i = 0; i < 11; i++) {
-      if ((mu[i] < 0.0) || (mu[i] > 1.0)) {
+      if ((mu[i] < (real_T)0.0) || (mu[i] > (real_T)1.0)) {
         l = mu[i];
-        if (mu[i] < 0.0) {
-          l = 0.0;
+        if (mu[i] < (real_T)0.0) {
+          l = (real_T)0.0;
         }
 
-        if (mu[i] > 1.0) {
-          l = 1.0;
+        if (mu[i] > (real_T)1.0) {
+          l = (real_T)1.0;
         }
 
         mu[i] = l;
@@ -161,7 +186,9 @@ static void PID_Difuso_compute_memberships(real_T x, const real_T mivals[11],
 }
 // --- Fin funciones linspace y compute_memberships ---
 
-void PID_Difuso_step(void)
+/* Motor de inferencia original (referencia): reglas, inferencia min/max y
+ * defuzzificación por centroide para entradas ya escaladas por KP/KD. */
+real_T PID_Difuso_fuzzy_reference(real_T e_in, real_T de_in)
 {
   real_T div_out[11];
   real_T mu_de[11];
@@ -173,48 +200,39 @@ void PID_Difuso_step(void)
   real_T den;
   real_T fuzzy_pd_out;
   real_T num;
-  real_T rtb_TSamp;
-  int last_tmp_data[121];
   int j;
   int last;
-  int last_tmp_size_idx_0;
   int v;
   signed char FAM[121];
-  boolean_T mask[121];
-  boolean_T exitg1;
   boolean_T y;
 
-  rtb_TSamp = PID_Difuso_U.error_signal; // Guarda el error actual
+  /* --- MEMBRESÍAS DE DELTA-ERROR --- */
+  PID_Difuso_linspace(-FUZZY_DE_RANGE, FUZZY_DE_RANGE, tmp); // Universo de discurso para delta-error
+  PID_Difuso_compute_memberships(de_in, tmp, mu_de);
 
-  /* --- CÁLCULO DE LA DERIVADA DEL ERROR (escalado por Kd) --- */
-  // Calcula la diferencia con el error anterior y la escala por FUZZY_KD
-  PID_Difuso_linspace(-10.0, 10.0, tmp); // Universo de discurso para delta-error
-  PID_Difuso_compute_memberships((rtb_TSamp - PID_Difuso_DW.UD_DSTATE) * FUZZY_KD, tmp, mu_de); // <-- USA FUZZY_KD
-
-  /* --- CÁLCULO PARTE FUZZY PROPORCIONAL (escalado por Kp) --- */
-  // Escala el error de entrada por FUZZY_KP antes de calcular membresías
-  PID_Difuso_linspace(-1200.0, 1200.0, tmp); // Universo de discurso para error
-  PID_Difuso_compute_memberships(FUZZY_KP * PID_Difuso_U.error_signal, tmp, mu_e); // <-- USA FUZZY_KP
+  /* --- MEMBRESÍAS DE ERROR --- */
+  PID_Difuso_linspace(-FUZZY_E_RANGE, FUZZY_E_RANGE, tmp); // Universo de discurso para error
+  PID_Difuso_compute_memberships(e_in, tmp, mu_e);
 
   /* --- LÓGICA FUZZY: Reglas, Inferencia y Defuzzificación --- */
   // (Esta sección no cambia, solo usa los mu_e y mu_de calculados arriba)
-  PID_Difuso_linspace(0.0, 60.0, div_out); // Universo de discurso para salida
+  PID_Difuso_linspace((real_T)0.0, FUZZY_OUT_RANGE, div_out); // Universo de discurso para salida
   for (last = 0; last < 11; last++) {
     for (j = 0; j < 11; j++) {
       v = 16 - (last + j); // Ejemplo de regla: ajusta esto según tu FAM
       if (v > 11) v = 11;
       if (v < 1) v = 1;
       FAM[last + 11 * j] = (signed char)v;
-      rule_heights[j + 11 * last] = fmin(mu_e[j], mu_de[last]);
+      rule_heights[j + 11 * last] = rt_fmin(mu_e[j], mu_de[last]);
     }
   }
-  fuzzy_pd_out = (div_out[5] + div_out[5]) * 0.5; // Centroide inicial
-  num = 0.0;
-  den = 0.0;
-  base = (div_out[1] - div_out[0]) * 2.0; // Base del triángulo de salida (asumido)
+  fuzzy_pd_out = (div_out[5] + div_out[5]) * (real_T)0.5; // Centroide inicial
+  num = (real_T)0.0;
+  den = (real_T)0.0;
+  base = (div_out[1] - div_out[0]) * (real_T)2.0; // Base del triángulo de salida (asumido)
   for (j = 0; j < 11; j++) { // Itera sobre los conjuntos de salida
     // Encuentra la altura máxima de activación para esta salida (agregación MAX)
-    A = 0.0; // Altura agregada para la salida j
+    A = (real_T)0.0; // Altura agregada para la salida j
     y = false; // Flag para saber si esta salida se activó
     for(int rule_idx = 0; rule_idx < 121; ++rule_idx) {
         if (FAM[rule_idx] == (j + 1)) {
@@ -226,44 +244,177 @@ void PID_Difuso_step(void)
     }
 
     // Calcula el área y centroide para la defuzzificación (centroide ponderado)
-    if (A > 0.0) {
+    if (A > (real_T)0.0) {
       // Asumiendo funciones de membresía triangulares simétricas para la salida
-      real_T area = ((1.0 - A) * base + base) * A / 2.0;
+      real_T area = (((real_T)1.0 - A) * base + base) * A / (real_T)2.0;
       num += area * div_out[j]; // área * centroide_del_triángulo
       den += area;              // suma de áreas
     }
   }
   // Calcula la salida defuzzificada final (si hay alguna activación)
-  if (den > 2.2204460492503131E-16) {
+  if (den > (real_T)2.2204460492503131E-16) {
     fuzzy_pd_out = num / den;
   }
   // --- Fin Lógica Fuzzy ---
 
+  return fuzzy_pd_out;
+}
+
+/* Evalúa el motor de referencia en cada nodo de la malla. Las reglas y los
+ * universos no cambian en tiempo de ejecución, así que basta con hacerlo una vez. */
+static void PID_Difuso_build_surface(void)
+{
+  int i;
+  int j;
+  for (i = 0; i < PID_Difuso_SURF_NDE; i++) {
+    real_T de_in = -FUZZY_DE_RANGE + ((real_T)2.0 * FUZZY_DE_RANGE) * (real_T)i /
+      (real_T)(PID_Difuso_SURF_NDE - 1);
+    for (j = 0; j < PID_Difuso_SURF_NE; j++) {
+      real_T e_in = -FUZZY_E_RANGE + ((real_T)2.0 * FUZZY_E_RANGE) * (real_T)j /
+        (real_T)(PID_Difuso_SURF_NE - 1);
+      PID_Difuso_surface[i][j] = (real32_T)PID_Difuso_fuzzy_reference(e_in, de_in);
+    }
+  }
+  PID_Difuso_surface_ready = true;
+}
+
+/* Interpolación bilineal sobre la superficie precalculada. Fuera de los
+ * universos las membresías se saturan, así que basta con recortar la entrada. */
+real_T PID_Difuso_fuzzy_surface(real_T e_in, real_T de_in)
+{
+  real_T x;
+  real_T y;
+  real_T fx;
+  real_T fy;
+  real_T top;
+  real_T bottom;
+  int ix;
+  int iy;
+
+  if (e_in < -FUZZY_E_RANGE) e_in = -FUZZY_E_RANGE;
+  if (e_in > FUZZY_E_RANGE) e_in = FUZZY_E_RANGE;
+  if (de_in < -FUZZY_DE_RANGE) de_in = -FUZZY_DE_RANGE;
+  if (de_in > FUZZY_DE_RANGE) de_in = FUZZY_DE_RANGE;
+
+  // Coordenadas continuas dentro de la malla
+  x = (e_in + FUZZY_E_RANGE) * ((real_T)(PID_Difuso_SURF_NE - 1) / ((real_T)2.0 * FUZZY_E_RANGE));
+  y = (de_in + FUZZY_DE_RANGE) * ((real_T)(PID_Difuso_SURF_NDE - 1) / ((real_T)2.0 * FUZZY_DE_RANGE));
+  ix = (int)x;
+  iy = (int)y;
+  if (ix > PID_Difuso_SURF_NE - 2) ix = PID_Difuso_SURF_NE - 2;
+  if (iy > PID_Difuso_SURF_NDE - 2) iy = PID_Difuso_SURF_NDE - 2;
+  fx = x - (real_T)ix;
+  fy = y - (real_T)iy;
+
+  bottom = PID_Difuso_surface[iy][ix] + fx * (PID_Difuso_surface[iy][ix + 1] -
+    PID_Difuso_surface[iy][ix]);
+  top = PID_Difuso_surface[iy + 1][ix] + fx * (PID_Difuso_surface[iy + 1][ix + 1] -
+    PID_Difuso_surface[iy + 1][ix]);
+  return bottom + fy * (top - bottom);
+}
+
+/* Paso del controlador para una instancia (reentrante: solo usa los datos
+ * a los que apunta el modelo; la superficie es compartida y de solo lectura) */
+void PID_Difuso_step_r(RT_MODEL_PID_Difuso_T *const rtM)
+{
+  const P_PID_Difuso_T *rtP = rtM->defaultParam;
+  DW_PID_Difuso_T *rtDW = rtM->dwork;
+  ExtY_PID_Difuso_T *rtY = rtM->outputs;
+  real_T fuzzy_pd_out;
+  real_T rtb_TSamp;
+
+  rtb_TSamp = rtM->inputs->error_signal; // Guarda el error actual
+
+  /* --- PARTE FUZZY PD (error escalado por Kp, delta-error escalado por Kd) --- */
+  // Consulta la superficie precalculada en lugar de reconstruir las reglas en cada paso.
+  // Las membresías están equiespaciadas en cada universo, así que cambiar un
+  // universo equivale a escalar la entrada (o la salida) de la superficie.
+  fuzzy_pd_out = PID_Difuso_fuzzy_surface(rtP->KP * rtb_TSamp * (FUZZY_E_RANGE / rtP->E_RANGE),
+    (rtb_TSamp - rtDW->UD_DSTATE) * rtDW->DeltaScale * rtP->KD * (FUZZY_DE_RANGE / rtP->DE_RANGE)) *
+    (rtP->OUT_RANGE / FUZZY_OUT_RANGE);
+
   /* --- CÁLCULO FINAL DE LA SALIDA (escalado por Ki) --- */
-  // Combina la parte Integral (escalada por FUZZY_KI) con la salida Fuzzy (PD)
-  PID_Difuso_Y.out = FUZZY_KI * PID_Difuso_DW.DiscreteTimeIntegrator_DSTATE + fuzzy_pd_out; // <-- USA FUZZY_KI
+  // Combina la parte Integral (escalada por KI) con la salida Fuzzy (PD)
+  rtY->out = rtP->KI * rtDW->DiscreteTimeIntegrator_DSTATE + fuzzy_pd_out;
 
   /* --- SATURACIÓN DE SALIDA --- */
-  // Limita la salida final entre 0.0 y 60.0.
-  if (PID_Difuso_Y.out < 0.0) {
-    PID_Difuso_Y.out = 0.0;
-  } else if (PID_Difuso_Y.out > 60.0) {
-    PID_Difuso_Y.out = 60.0;
+  // Limita la salida final al universo de salida [0.0, OUT_RANGE].
+  if (rtY->out < (real_T)0.0) {
+    rtY->out = (real_T)0.0;
+  } else if (rtY->out > rtP->OUT_RANGE) {
+    rtY->out = rtP->OUT_RANGE;
   }
 
   /* --- ACTUALIZACIÓN DE ESTADOS --- */
   // Guarda el error actual para el cálculo de la derivada en el siguiente paso.
-  PID_Difuso_DW.UD_DSTATE = rtb_TSamp;
-  // Actualiza el estado del integrador (con la ganancia interna original de 0.001)
-  PID_Difuso_DW.DiscreteTimeIntegrator_DSTATE += 0.001 * PID_Difuso_U.error_signal;
+  rtDW->UD_DSTATE = rtb_TSamp;
+  // Actualiza el estado del integrador (ganancia interna de 0.001 cada 10 ms)
+  rtDW->DiscreteTimeIntegrator_DSTATE += rtDW->IntGain * rtb_TSamp;
+}
+
+/* Inicializa una instancia. La primera llamada construye además la superficie
+ * compartida, así que debe hacerse antes de arrancar tareas en otros núcleos. */
+void PID_Difuso_initialize_r(RT_MODEL_PID_Difuso_T *const rtM)
+{
+    // Initialize states to zero
+    rtM->dwork->UD_DSTATE = (real_T)0.0;
+    rtM->dwork->DiscreteTimeIntegrator_DSTATE = (real_T)0.0;
+    rtM->outputs->out = (real_T)0.0;
+
+    // Una instancia sin periodo de muestreo usa el de diseño
+    if (!(rtM->dwork->Ts > (real_T)0.0)) {
+      PID_Difuso_discretize_r(rtM, (real_T)FUZZY_TS);
+    }
+
+    // La superficie solo se construye la primera vez (el reset en marcha no la recalcula)
+    if (!PID_Difuso_surface_ready) {
+      PID_Difuso_build_surface();
+    }
+}
+
+/* Coeficientes discretos de una instancia para el periodo Ts. El integrador
+ * acumula 0.1 * e por segundo y el universo del delta-error está pensado para
+ * la variación del error en 10 ms, así que la diferencia de cada paso se
+ * reescala a ese intervalo. Con Ts = FUZZY_TS ambos factores quedan exactos. */
+void PID_Difuso_discretize_r(RT_MODEL_PID_Difuso_T *const rtM, real_T Ts)
+{
+  rtM->dwork->Ts = Ts;
+  rtM->dwork->IntGain = (real_T)FUZZY_INT_GAIN * (Ts / (real_T)FUZZY_TS);
+  rtM->dwork->DeltaScale = (real_T)FUZZY_TS / Ts;
+}
+
+/* Prepara los estados de una instancia para que su siguiente paso, con el
+ * error dado, entregue 'out' (transferencia sin salto desde otro controlador).
+ * El delta-error queda en cero y el integrador absorbe la diferencia. */
+void PID_Difuso_track_r(RT_MODEL_PID_Difuso_T *const rtM, real_T out, real_T error_signal)
+{
+  const P_PID_Difuso_T *rtP = rtM->defaultParam;
+  DW_PID_Difuso_T *rtDW = rtM->dwork;
+  real_T fuzzy_pd_out;
+
+  rtDW->UD_DSTATE = error_signal;
+  fuzzy_pd_out = PID_Difuso_fuzzy_surface(rtP->KP * error_signal * (FUZZY_E_RANGE / rtP->E_RANGE),
+    (real_T)0.0) * (rtP->OUT_RANGE / FUZZY_OUT_RANGE);
+
+  // Sin ganancia integral no hay estado que ajustar
+  if (rtP->KI > (real_T)0.0) {
+    rtDW->DiscreteTimeIntegrator_DSTATE = (out - fuzzy_pd_out) / rtP->KI;
+  } else {
+    rtDW->DiscreteTimeIntegrator_DSTATE = (real_T)0.0;
+  }
+  rtM->outputs->out = out;
+}
+
+/* Entry points de la instancia global (envoltorios) */
+void PID_Difuso_step(void)
+{
+  PID_Difuso_step_r(PID_Difuso_M);
 }
 
 /* Model initialize function */
 void PID_Difuso_initialize(void)
 {
-    // Initialize states to zero
-    PID_Difuso_DW.UD_DSTATE = 0.0;
-    PID_Difuso_DW.DiscreteTimeIntegrator_DSTATE = 0.0;
+  PID_Difuso_initialize_r(PID_Difuso_M);
 }
 
 /* Model terminate function */
@@ -14,6 +14,13 @@
 
 #include "PID_Difuso_types.h" // CAMBIADO
 
+/* Tamaño de la superficie de control precalculada (error x delta-error).
+ * Con 81 x 41 nodos la interpolación bilineal se aparta del motor de
+ * inferencia original como máximo 0.75 (de una salida de 0 a 60) en todo el
+ * plano, y menos de 0.08 con delta-error = 0 (FUZZY_KD = 0). */
+#define PID_Difuso_SURF_NE             81
+#define PID_Difuso_SURF_NDE            41
+
 /* Macros... */
 #ifndef rtmGetErrorStatus
 #define rtmGetErrorStatus(rtm)         ((rtm)->errorStatus)
@@ -26,6 +33,12 @@
 typedef struct {
   real_T UD_DSTATE;                    /* '<S1>/UD' */
   real_T DiscreteTimeIntegrator_DSTATE;/* '<Root>/Discrete-Time Integrator' */
+
+  /* Discretización de la instancia (no son estados: el reset las conserva).
+   * Las fija PID_Difuso_discretize_r() a partir del periodo de muestreo. */
+  real_T Ts;                           /* Periodo de muestreo [s] */
+  real_T IntGain;                      /* Ganancia del integrador por paso */
+  real_T DeltaScale;                   /* Lleva el delta-error a su valor por 10 ms */
 } DW_PID_Difuso_T; // CAMBIADO
 
 /* External inputs */
@@ -38,9 +51,23 @@ typedef struct {
   real_T out;                          /* '<Root>/out' */
 } ExtY_PID_Difuso_T; // CAMBIADO
 
-/* Real-time Model Data Structure */
+/* Parameters (ganancias ajustables por instancia) */
+typedef struct {
+  real_T KP;                           /* Escala el error antes de la lógica difusa */
+  real_T KI;                           /* Escala la salida del integrador */
+  real_T KD;                           /* Escala la diferencia del error */
+  real_T E_RANGE;                      /* Universo del error escalado: [-E_RANGE, E_RANGE] */
+  real_T DE_RANGE;                     /* Universo del delta-error escalado: [-DE_RANGE, DE_RANGE] */
+  real_T OUT_RANGE;                    /* Universo de la salida: [0, OUT_RANGE] */
+} P_PID_Difuso_T;
+
+/* Real-time Model Data Structure: una instancia del controlador */
 struct tag_RTM_PID_Difuso_T { // CAMBIADO
   const char_T * volatile errorStatus;
+  P_PID_Difuso_T *defaultParam;
+  DW_PID_Difuso_T *dwork;
+  ExtU_PID_Difuso_T *inputs;
+  ExtY_PID_Difuso_T *outputs;
 };
 
 /* Block states */
@@ -52,11 +79,27 @@ extern ExtU_PID_Difuso_T PID_Difuso_U; // CAMBIADO
 /* External outputs */
 extern ExtY_PID_Difuso_T PID_Difuso_Y; // CAMBIADO
 
+/* Parámetros de la instancia global (y valores por defecto) */
+extern P_PID_Difuso_T PID_Difuso_P;
+
+/* Entry points reentrantes (una llamada por instancia) */
+extern void PID_Difuso_initialize_r(RT_MODEL_PID_Difuso_T *const rtM);
+/* Fija el periodo de muestreo Ts [s] de una instancia y calcula sus
+ * coeficientes discretos (conserva los estados) */
+extern void PID_Difuso_discretize_r(RT_MODEL_PID_Difuso_T *const rtM, real_T Ts);
+extern void PID_Difuso_step_r(RT_MODEL_PID_Difuso_T *const rtM);
+/* Ajusta los estados para que el siguiente paso con 'error_signal' dé 'out' */
+extern void PID_Difuso_track_r(RT_MODEL_PID_Difuso_T *const rtM, real_T out, real_T error_signal);
+
 /* Model entry point functions */
 extern void PID_Difuso_initialize(void); // CAMBIADO
 extern void PID_Difuso_step(void);       // CAMBIADO
 extern void PID_Difuso_terminate(void);  // CAMBIADO
 
+/* Salida fuzzy PD para entradas ya escaladas: motor original y superficie */
+extern real_T PID_Difuso_fuzzy_reference(real_T e_in, real_T de_in);
+extern real_T PID_Difuso_fuzzy_surface(real_T e_in, real_T de_in);
+
 /* Real-time Model object */
 extern RT_MODEL_PID_Difuso_T *const PID_Difuso_M; // CAMBIADO
 
@@ -0,0 +1,106 @@
+/*
+ * File: PID_Difuso_fixed.c
+ *
+ * Escalado: con e el error en cuentas/periodo y R = FX_RPM_PER_COUNT, la
+ * versión en coma flotante calcula
+ *   out = KI*I + F(KP*R*e, KD*R*(e - e_prev)),  I += FUZZY_INT_GAIN*R*e
+ * y u_k = out/60. Aquí el integrador se guarda directamente en unidades de
+ * u_k (coeficiente KI*FUZZY_INT_GAIN*R/60) y F se consulta en una tabla Q15
+ * de u_k, con las coordenadas de la malla calculadas en Q16.16.
+ */
+
+#include "PID_Difuso_fixed.h"
+#include "PID_Difuso.h"
+#include "PID_Difuso_private.h"
+#include "fixed_point.h"
+
+/* Coeficientes Q8.24 */
+#define FX_INT_GAIN FX_COEF(FUZZY_KI * FUZZY_INT_GAIN * FX_RPM_PER_COUNT / 60.0)
+// Cuentas/periodo -> coordenada de la malla (nodos por unidad de entrada)
+#define FX_E_TO_GRID  FX_COEF(FUZZY_KP * FX_RPM_PER_COUNT * (PID_Difuso_SURF_NE - 1) / (2.0 * FUZZY_E_RANGE))
+#define FX_DE_TO_GRID FX_COEF(FUZZY_KD * FX_RPM_PER_COUNT * (PID_Difuso_SURF_NDE - 1) / (2.0 * FUZZY_DE_RANGE))
+
+/* Superficie de control en Q15 de u_k (salida fuzzy / 60) */
+static int16_t PID_Difuso_fixed_surface[PID_Difuso_SURF_NDE][PID_Difuso_SURF_NE];
+static int PID_Difuso_fixed_surface_ready = 0;
+
+static void PID_Difuso_fixed_build_surface(void)
+{
+  int i;
+  int j;
+  for (i = 0; i < PID_Difuso_SURF_NDE; i++) {
+    double de_in = -FUZZY_DE_RANGE + 2.0 * FUZZY_DE_RANGE * i / (PID_Difuso_SURF_NDE - 1);
+    for (j = 0; j < PID_Difuso_SURF_NE; j++) {
+      double e_in = -FUZZY_E_RANGE + 2.0 * FUZZY_E_RANGE * j / (PID_Difuso_SURF_NE - 1);
+      double u = PID_Difuso_fuzzy_reference(e_in, de_in) / 60.0;
+      PID_Difuso_fixed_surface[i][j] = (int16_t)(u * FX_Q15_ONE + 0.5);
+    }
+  }
+  PID_Difuso_fixed_surface_ready = 1;
+}
+
+/* Coordenada Q16.16 dentro de la malla, recortada a [0, n - 1] */
+static int32_t grid_coord(int32_t value_q16, int32_t coef, int n)
+{
+  int32_t x = fx_add(fx_mul(value_q16, coef), (int32_t)((n - 1) / 2) << 16);
+  if (x < 0) return 0;
+  if (x > ((int32_t)(n - 1) << 16)) return (int32_t)(n - 1) << 16;
+  return x;
+}
+
+/* Interpolación bilineal entera; devuelve Q15 */
+static int32_t surface_lookup(int32_t x_q16, int32_t y_q16)
+{
+  int ix = x_q16 >> 16;
+  int iy = y_q16 >> 16;
+  int32_t fx;
+  int32_t fy;
+  int32_t bottom;
+  int32_t top;
+
+  if (ix > PID_Difuso_SURF_NE - 2) ix = PID_Difuso_SURF_NE - 2;
+  if (iy > PID_Difuso_SURF_NDE - 2) iy = PID_Difuso_SURF_NDE - 2;
+  fx = x_q16 - ((int32_t)ix << 16); // 0..65536
+  fy = y_q16 - ((int32_t)iy << 16);
+
+  bottom = PID_Difuso_fixed_surface[iy][ix] + (int32_t)(((int64_t)(
+    PID_Difuso_fixed_surface[iy][ix + 1] - PID_Difuso_fixed_surface[iy][ix]) * fx) >> 16);
+  top = PID_Difuso_fixed_surface[iy + 1][ix] + (int32_t)(((int64_t)(
+    PID_Difuso_fixed_surface[iy + 1][ix + 1] - PID_Difuso_fixed_surface[iy + 1][ix]) * fx) >> 16);
+  return bottom + (int32_t)(((int64_t)(top - bottom) * fy) >> 16);
+}
+
+void PID_Difuso_fixed_initialize(DW_PID_Difuso_fixed_T *dw)
+{
+  dw->speed_q16 = 0;
+  dw->prev_error_q16 = 0;
+  dw->integrator_q16 = 0;
+  if (!PID_Difuso_fixed_surface_ready) {
+    PID_Difuso_fixed_build_surface();
+  }
+}
+
+int16_t PID_Difuso_fixed_step(DW_PID_Difuso_fixed_T *dw, int32_t reference_q16,
+  int32_t pulses)
+{
+  int32_t error;
+  int32_t fuzzy_q15;
+  int32_t out;
+
+  /* --- MEDICIÓN (mismo EMA que encoder_get_rpm) --- */
+  dw->speed_q16 = fx_speed_filter(dw->speed_q16, pulses);
+  error = fx_add(reference_q16, -dw->speed_q16);
+
+  /* --- PARTE FUZZY PD desde la superficie entera --- */
+  fuzzy_q15 = surface_lookup(grid_coord(error, FX_E_TO_GRID, PID_Difuso_SURF_NE),
+    grid_coord(fx_add(error, -dw->prev_error_q16), FX_DE_TO_GRID, PID_Difuso_SURF_NDE));
+
+  /* --- SALIDA (usa el integrador anterior, como PID_Difuso_step) --- */
+  out = fx_add(dw->integrator_q16, fuzzy_q15 << 1); // Q15 -> Q16.16
+
+  /* --- ACTUALIZACIÓN DE ESTADOS --- */
+  dw->prev_error_q16 = error;
+  dw->integrator_q16 = fx_add(dw->integrator_q16, fx_mul(error, FX_INT_GAIN));
+
+  return fx_to_q15_unipolar(out);
+}
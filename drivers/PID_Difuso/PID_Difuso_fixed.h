@@ -0,0 +1,30 @@
+/*
+ * File: PID_Difuso_fixed.h
+ *
+ * Versión en punto fijo (solo enteros en tiempo de ejecución) del PD difuso
+ * + I de PID_Difuso_step(). Recibe los pulsos del encoder de cada periodo,
+ * aplica el mismo EMA que encoder_get_rpm() y consulta una superficie de
+ * control en Q15. Formatos numéricos: ver fixed_point.h.
+ */
+
+#ifndef PID_Difuso_fixed_h_
+#define PID_Difuso_fixed_h_
+
+#include <stdint.h>
+
+/* Estados (Q16.16) */
+typedef struct {
+  int32_t speed_q16;      // Velocidad medida filtrada (cuentas/periodo)
+  int32_t prev_error_q16; // Error anterior (cuentas/periodo)
+  int32_t integrator_q16; // Integrador, ya escalado a unidades de u_k (1.0 = 100 %)
+} DW_PID_Difuso_fixed_T;
+
+/* Pone los estados a cero y, la primera vez, construye la superficie entera */
+extern void PID_Difuso_fixed_initialize(DW_PID_Difuso_fixed_T *dw);
+
+/* Un paso del controlador: referencia en Q16.16 cuentas/periodo, pulsos del
+ * periodo; devuelve u_k en Q15 saturada a [0, 1] (= salida/60). */
+extern int16_t PID_Difuso_fixed_step(DW_PID_Difuso_fixed_T *dw,
+  int32_t reference_q16, int32_t pulses);
+
+#endif /* PID_Difuso_fixed_h_ */
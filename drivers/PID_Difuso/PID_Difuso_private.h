@@ -7,4 +7,27 @@
 #define PID_Difuso_private_h_ // CAMBIADO
 #include "rtwtypes.h"
 #include "PID_Difuso_types.h" // CAMBIADO
+
+// ===== GANANCIAS DEL CONTROLADOR PID DIFUSO ========================
+// Entre 20
+#define FUZZY_KP 2.0f // Ganancia Proporcional (escala el error antes de la lógica difusa)
+#define FUZZY_KI 8.0f // Ganancia Integral (escala la salida del integrador)
+#define FUZZY_KD 0.0f // Ganancia Derivativa (escala la derivada del error)
+
+// Periodo de muestreo para el que se diseñó el controlador. Es el de la
+// instancia global, el de las instancias sin discretizar y el del kernel de
+// punto fijo.
+#define FUZZY_TS 0.01
+
+// Ganancia interna del integrador discreto (por periodo de FUZZY_TS); con
+// otro periodo Ts se escala por Ts / FUZZY_TS
+#define FUZZY_INT_GAIN 0.001
+
+// ===== UNIVERSOS DE DISCURSO =======================================
+#define FUZZY_E_RANGE  ((real_T)1200.0) // Error escalado: [-1200, 1200]
+#define FUZZY_DE_RANGE ((real_T)10.0)   // Delta-error escalado: [-10, 10]
+#define FUZZY_OUT_RANGE ((real_T)60.0)  // Salida: [0, 60]
+// La superficie se construye con estos universos; los de cada instancia
+// (P_PID_Difuso_T) se aplican escalando la entrada y la salida.
+
 #endif /* PID_Difuso_private_h_ */ // CAMBIADO
\ No newline at end of file
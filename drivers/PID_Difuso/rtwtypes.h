@@ -26,8 +26,17 @@ typedef unsigned int uint32_T;
 typedef float real32_T;
 typedef double real64_T;
 
+/* Controller precision: CONTROL_SINGLE_PRECISION=1 computes in float */
+#ifndef CONTROL_SINGLE_PRECISION
+#define CONTROL_SINGLE_PRECISION 0
+#endif
+
 /* Generic type definitions */
+#if CONTROL_SINGLE_PRECISION
+typedef float real_T;
+#else
 typedef double real_T;
+#endif
 typedef double time_T;
 typedef unsigned char boolean_T;
 typedef int int_T;
@@ -0,0 +1,159 @@
+#include "command.h"
+#include "telemetry.h"
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+#endif
+
+// Same UART as the telemetry stream.
+#define COMMAND_UART UART_NUM_0
+
+// --- Handler Table ---
+typedef struct {
+    uint8_t opcode;
+    command_handler_t handler;
+} command_entry_t;
+
+static command_entry_t handlers[COMMAND_MAX_OPCODES];
+static size_t handler_count = 0;
+
+// --- Decoder State ---
+// COBS bytes of the frame being received (payload + CRC, at most one overhead byte).
+static uint8_t rx_buf[COMMAND_MAX_PAYLOAD_LEN + 2 + 1];
+static size_t rx_len = 0;
+static bool rx_overflow = false;
+static command_stats_t stats;
+
+bool command_register(uint8_t opcode, command_handler_t handler) {
+    for (size_t i = 0; i < handler_count; i++) {
+        if (handlers[i].opcode == opcode) {
+            handlers[i].handler = handler;
+            return true;
+        }
+    }
+    if (handler_count >= COMMAND_MAX_OPCODES) {
+        return false;
+    }
+    handlers[handler_count].opcode = opcode;
+    handlers[handler_count].handler = handler;
+    handler_count++;
+    return true;
+}
+
+size_t command_ack(uint8_t *reply, uint8_t opcode, uint8_t status) {
+    reply[0] = TELEMETRY_FRAME_ACK;
+    reply[1] = opcode;
+    reply[2] = status;
+    return 3;
+}
+
+/**
+ * @brief Reverses the COBS encoding used by telemetry.
+ * @return The decoded length, or 0 if the encoding is invalid.
+ */
+static size_t cobs_decode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+    while (in_pos < len) {
+        uint8_t code = in[in_pos++];
+        if (code == 0 || in_pos + code - 1 > len) {
+            return 0;
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            out[out_pos++] = in[in_pos++];
+        }
+        if (code < 0xFF && in_pos < len) {
+            out[out_pos++] = 0;
+        }
+    }
+    return out_pos;
+}
+
+/**
+ * @brief Checks one complete frame and runs its handler.
+ */
+static void command_dispatch(const uint8_t *encoded, size_t len) {
+    uint8_t frame[sizeof(rx_buf)];
+    size_t n = cobs_decode(encoded, len, frame);
+    if (n < 3) {
+        stats.framing_errors++;
+        return;
+    }
+    size_t payload_len = n - 2;
+    uint16_t crc = (uint16_t)(frame[payload_len] | (frame[payload_len + 1] << 8));
+    if (crc != telemetry_crc16(frame, payload_len)) {
+        stats.crc_errors++;
+        return;
+    }
+
+    uint8_t reply[TELEMETRY_MAX_PAYLOAD_LEN];
+    size_t reply_len = 0;
+    command_handler_t handler = NULL;
+    for (size_t i = 0; i < handler_count; i++) {
+        if (handlers[i].opcode == frame[0]) {
+            handler = handlers[i].handler;
+        }
+    }
+    if (handler != NULL) {
+        stats.frames++;
+        reply_len = handler(frame, payload_len, reply);
+    } else {
+        stats.unknown++;
+        reply_len = command_ack(reply, frame[0], COMMAND_STATUS_UNKNOWN);
+    }
+    if (reply_len > 0) {
+        telemetry_send_frame_now(reply, reply_len);
+    }
+}
+
+void command_feed(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] == 0x00) {
+            // Frame delimiter
+            if (rx_overflow) {
+                stats.framing_errors++;
+            } else if (rx_len > 0) {
+                command_dispatch(rx_buf, rx_len);
+            }
+            rx_len = 0;
+            rx_overflow = false;
+        } else if (rx_len < sizeof(rx_buf)) {
+            rx_buf[rx_len++] = data[i];
+        } else {
+            rx_overflow = true;
+        }
+    }
+}
+
+void command_get_stats(command_stats_t *out) {
+    *out = stats;
+}
+
+#ifdef ESP_PLATFORM
+// Reads whatever arrives on the UART and feeds the decoder.
+static void command_rx_task(void *arg) {
+    uint8_t chunk[COMMAND_RX_CHUNK];
+    while (1) {
+        int n = uart_read_bytes(COMMAND_UART, chunk, sizeof(chunk), pdMS_TO_TICKS(20));
+        if (n > 0) {
+            command_feed(chunk, (size_t)n);
+        }
+    }
+}
+
+void command_init(void) {
+    static TaskHandle_t rx_task = NULL;
+    if (rx_task == NULL) {
+        xTaskCreatePinnedToCore(command_rx_task, "command_rx", COMMAND_TASK_STACK,
+                                NULL, COMMAND_TASK_PRIORITY, &rx_task, COMMAND_TASK_CORE);
+    }
+}
+#else
+void command_init(void) {
+    rx_len = 0;
+    rx_overflow = false;
+}
+#endif
@@ -0,0 +1,83 @@
+#ifndef COMMAND_H //header guard
+#define COMMAND_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+// --- Wire Format ---
+// Commands use the same framing as telemetry, in the other direction:
+// payload | CRC-16/CCITT-FALSE (little endian) -> COBS encoded -> 0x00.
+// The first payload byte is the opcode; the rest is opcode specific.
+#define COMMAND_MAX_PAYLOAD_LEN 64
+#define COMMAND_MAX_OPCODES     16
+
+// --- Reply Status (TELEMETRY_FRAME_ACK) ---
+#define COMMAND_STATUS_OK          0x00
+#define COMMAND_STATUS_UNKNOWN     0x01 // No handler for the opcode.
+#define COMMAND_STATUS_MALFORMED   0x02 // Wrong payload length or layout.
+#define COMMAND_STATUS_BAD_ID      0x03 // Unknown parameter / item.
+#define COMMAND_STATUS_BAD_VALUE   0x04 // Value out of range.
+#define COMMAND_STATUS_BUSY        0x05 // The previous request was not applied yet.
+#define COMMAND_STATUS_STATE       0x06 // Not valid now (e.g. a segment without BEGIN).
+
+// --- Receiver Task Configuration ---
+// Low priority and on core 0: commands are applied by the control task at
+// the next tick, the receiver only decodes and validates them.
+#define COMMAND_TASK_PRIORITY (tskIDLE_PRIORITY + 3)
+#define COMMAND_TASK_STACK    3072
+#define COMMAND_TASK_CORE     0
+#define COMMAND_RX_CHUNK      64
+
+/**
+ * @brief Handles one decoded command.
+ * @param payload The payload, starting with the opcode.
+ * @param len Length of the payload.
+ * @param reply Buffer of TELEMETRY_MAX_PAYLOAD_LEN bytes for the reply payload
+ * (first byte is the telemetry frame type).
+ * @return Length of the reply, or 0 to send no reply.
+ */
+typedef size_t (*command_handler_t)(const uint8_t *payload, size_t len, uint8_t *reply);
+
+/**
+ * @brief Counters of the command receiver.
+ */
+typedef struct {
+    uint32_t frames;          // Valid frames dispatched.
+    uint32_t crc_errors;      // Frames dropped because of a bad CRC.
+    uint32_t framing_errors;  // Bad COBS encoding or oversized frames.
+    uint32_t unknown;         // Valid frames without a handler.
+} command_stats_t;
+
+/**
+ * @brief Registers the handler of an opcode (replaces any previous one).
+ * @return false if the handler table is full.
+ */
+bool command_register(uint8_t opcode, command_handler_t handler);
+
+/**
+ * @brief Starts the receiver. On the ESP32 this creates the task that reads
+ * the telemetry UART (telemetry_init() must have installed the driver).
+ * On the host bytes are pushed with command_feed().
+ */
+void command_init(void);
+
+/**
+ * @brief Feeds received bytes to the frame decoder. Complete frames are
+ * checked and dispatched, and the replies are sent with telemetry_send_frame_now().
+ * Called by the receiver task; host tools call it directly.
+ */
+void command_feed(const uint8_t *data, size_t len);
+
+/**
+ * @brief Builds a TELEMETRY_FRAME_ACK reply payload.
+ * @return Length of the reply.
+ */
+size_t command_ack(uint8_t *reply, uint8_t opcode, uint8_t status);
+
+/**
+ * @brief Copies the receiver counters.
+ */
+void command_get_stats(command_stats_t *stats);
+
+#endif //header guard
@@ -0,0 +1,169 @@
+#include "control_tick.h"
+#include <string.h>
+#include <stdatomic.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#endif
+
+// --- Tick State ---
+static control_tick_handler_t tick_handler = NULL;
+static void *tick_arg = NULL;
+static uint32_t tick_index = 0;
+
+// --- Statistics State ---
+// Written by the control task only. Readers in other tasks copy them under a
+// sequence lock (odd while a tick is being recorded) and a reset is only
+// requested; the control task applies it at the start of its next record.
+static control_tick_stats_t stats;
+static atomic_uint stats_seq;
+static atomic_bool reset_requested;
+static uint64_t last_wake_us = 0;
+static uint64_t jitter_abs_sum_us = 0;
+static bool has_last_wake = false;
+
+/**
+ * @brief Clears the statistics (control task, or before the tick starts).
+ */
+static void control_tick_clear_stats(void) {
+    uint32_t period_us = stats.period_us;
+    memset(&stats, 0, sizeof(stats));
+    stats.period_us = period_us;
+    jitter_abs_sum_us = 0;
+    has_last_wake = false;
+}
+
+/**
+ * @brief Updates the timing statistics for one tick.
+ * Shared by the ESP32 and host tick sources so both report identical numbers.
+ * @param now_us The wake-up time of this tick.
+ * @param exec_us How long the handler took to run.
+ * @param missed Number of timer events that were coalesced into this tick.
+ */
+static void control_tick_record(uint64_t now_us, uint32_t exec_us, uint32_t missed) {
+    unsigned seq = atomic_load_explicit(&stats_seq, memory_order_relaxed);
+    atomic_store_explicit(&stats_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    if (atomic_exchange_explicit(&reset_requested, false, memory_order_acquire)) {
+        control_tick_clear_stats();
+    }
+    if (has_last_wake) {
+        int32_t jitter = (int32_t)(now_us - last_wake_us) - (int32_t)stats.period_us;
+        if (stats.jitter_samples == 0 || jitter < stats.jitter_min_us) stats.jitter_min_us = jitter;
+        if (stats.jitter_samples == 0 || jitter > stats.jitter_max_us) stats.jitter_max_us = jitter;
+        jitter_abs_sum_us += (uint64_t)(jitter < 0 ? -jitter : jitter);
+        stats.jitter_samples++;
+        stats.jitter_mean_abs_us = (float)jitter_abs_sum_us / (float)stats.jitter_samples;
+    }
+    last_wake_us = now_us;
+    has_last_wake = true;
+
+    // A step that does not finish within one period makes the next tick late.
+    if (exec_us >= stats.period_us) {
+        stats.overruns++;
+    }
+    stats.overruns += missed;
+    if (exec_us > stats.exec_max_us) stats.exec_max_us = exec_us;
+    stats.ticks++;
+
+    atomic_store_explicit(&stats_seq, seq + 2, memory_order_release);
+}
+
+void control_tick_get_stats(control_tick_stats_t *out) {
+    // A record takes well under a microsecond and happens once per period, so
+    // the copy is simply retried until no record overlapped it.
+    unsigned before;
+    do {
+        before = atomic_load_explicit(&stats_seq, memory_order_acquire);
+        *out = stats;
+        atomic_thread_fence(memory_order_acquire);
+    } while ((before & 1u) || atomic_load_explicit(&stats_seq, memory_order_relaxed) != before);
+}
+
+void control_tick_reset_stats(void) {
+    atomic_store_explicit(&reset_requested, true, memory_order_release);
+}
+
+#ifdef ESP_PLATFORM
+// ===================================================================
+// ===== ESP32 BACKEND: esp_timer + notified control task ============
+static esp_timer_handle_t tick_timer = NULL;
+static TaskHandle_t tick_task = NULL;
+
+// Runs in the esp_timer service task; it only wakes up the control task.
+static void control_tick_timer_cb(void *arg) {
+    xTaskNotifyGive(tick_task);
+}
+
+// The control task blocks until the timer notifies it, then runs one step.
+static void control_tick_task(void *arg) {
+    while (1) {
+        uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint64_t wake_us = (uint64_t)esp_timer_get_time();
+
+        tick_handler(tick_index++, tick_arg);
+
+        uint32_t exec_us = (uint32_t)((uint64_t)esp_timer_get_time() - wake_us);
+        control_tick_record(wake_us, exec_us, pending > 1 ? pending - 1 : 0);
+    }
+}
+
+bool control_tick_start(uint32_t period_us, control_tick_handler_t handler, void *arg) {
+    tick_handler = handler;
+    tick_arg = arg;
+    tick_index = 0;
+    stats.period_us = period_us;
+    control_tick_clear_stats();
+    atomic_store_explicit(&reset_requested, false, memory_order_relaxed);
+
+    if (xTaskCreatePinnedToCore(control_tick_task, "control_tick", CONTROL_TICK_TASK_STACK,
+                                NULL, CONTROL_TICK_TASK_PRIORITY, &tick_task,
+                                CONTROL_TICK_TASK_CORE) != pdPASS) {
+        return false;
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = control_tick_timer_cb,
+        .arg = NULL,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "control_tick",
+        .skip_unhandled_events = false,
+    };
+    if (esp_timer_create(&timer_args, &tick_timer) != ESP_OK) {
+        return false;
+    }
+    return esp_timer_start_periodic(tick_timer, period_us) == ESP_OK;
+}
+
+void control_tick_stop(void) {
+    if (tick_timer != NULL) {
+        esp_timer_stop(tick_timer);
+    }
+}
+
+#else
+// ===================================================================
+// ===== HOST BACKEND: simulated tick source =========================
+bool control_tick_start(uint32_t period_us, control_tick_handler_t handler, void *arg) {
+    tick_handler = handler;
+    tick_arg = arg;
+    tick_index = 0;
+    stats.period_us = period_us;
+    control_tick_clear_stats();
+    atomic_store_explicit(&reset_requested, false, memory_order_relaxed);
+    return true;
+}
+
+void control_tick_stop(void) {
+    tick_handler = NULL;
+}
+
+void control_tick_host_fire(uint64_t now_us, uint32_t exec_us) {
+    if (tick_handler == NULL) return;
+    tick_handler(tick_index++, tick_arg);
+    control_tick_record(now_us, exec_us, 0);
+}
+#endif
@@ -0,0 +1,84 @@
+#ifndef CONTROL_TICK_H //header guard
+#define CONTROL_TICK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Control Task Configuration ---
+// The control task is pinned to the application core so that Wi-Fi/BT and the
+// esp_timer service (both on core 0) cannot preempt the control step.
+#define CONTROL_TICK_TASK_CORE       1
+#define CONTROL_TICK_TASK_PRIORITY   (configMAX_PRIORITIES - 2)
+#define CONTROL_TICK_TASK_STACK      4096
+
+/**
+ * @brief Function executed once per control period.
+ * @param tick_index Number of ticks handled since control_tick_start().
+ * @param arg The user argument passed to control_tick_start().
+ */
+typedef void (*control_tick_handler_t)(uint32_t tick_index, void *arg);
+
+/**
+ * @brief Timing statistics of the control tick.
+ *
+ * The period is measured between consecutive wake-ups of the control task and
+ * the jitter is the deviation of that period from the nominal one.
+ */
+typedef struct {
+    uint32_t ticks;           // Number of handled ticks.
+    uint32_t overruns;        // Ticks that fired while the previous step was still running.
+    uint32_t period_us;       // Nominal period.
+    int32_t  jitter_min_us;   // Most negative period deviation.
+    int32_t  jitter_max_us;   // Most positive period deviation.
+    float    jitter_mean_abs_us; // Mean absolute period deviation.
+    uint32_t jitter_samples;  // Periods measured (every tick but the first after a reset).
+    uint32_t exec_max_us;     // Longest execution time of the handler.
+} control_tick_stats_t;
+
+/**
+ * @brief Starts the periodic control tick.
+ *
+ * On the ESP32 a periodic esp_timer notifies a high-priority task pinned to
+ * CONTROL_TICK_TASK_CORE, which then runs the handler. On the host no task is
+ * created; ticks are produced by control_tick_host_fire().
+ *
+ * @param period_us The control period in microseconds.
+ * @param handler The function to run every period.
+ * @param arg User argument forwarded to the handler.
+ * @return true if the tick source was started.
+ */
+bool control_tick_start(uint32_t period_us, control_tick_handler_t handler, void *arg);
+
+/**
+ * @brief Stops the periodic control tick.
+ */
+void control_tick_stop(void);
+
+/**
+ * @brief Copies the current timing statistics. Safe from any task: the copy
+ * is retried if the control task recorded a tick while it was taken.
+ * @param stats Destination for the statistics.
+ */
+void control_tick_get_stats(control_tick_stats_t *stats);
+
+/**
+ * @brief Requests a clear of the timing statistics (the nominal period is
+ * kept). The control task applies it when it records its next tick, so that
+ * tick is the first one of the new window.
+ */
+void control_tick_reset_stats(void);
+
+#ifndef ESP_PLATFORM
+/**
+ * @brief Simulated tick source for host builds.
+ *
+ * Runs the handler as if the hardware timer had fired at 'now_us'. The
+ * caller controls the timestamps, so jitter and late ticks can be injected.
+ *
+ * @param now_us The simulated wake-up time in microseconds.
+ * @param exec_us The simulated execution time of the handler in microseconds.
+ */
+void control_tick_host_fire(uint64_t now_us, uint32_t exec_us);
+#endif
+
+#endif //header guard
@@ -0,0 +1,10 @@
+#include "feedforward.h"
+
+float feedforward_output(const feedforward_params_t *params, float rpm, float rpm_per_s) {
+    float u_ff = (params->kv * rpm) + (params->ka * rpm_per_s);
+    // No breakaway offset while the reference is at rest.
+    if (rpm > 0.0f) {
+        u_ff += params->ks;
+    }
+    return u_ff;
+}
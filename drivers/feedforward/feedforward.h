@@ -0,0 +1,32 @@
+#ifndef FEEDFORWARD_H //header guard
+#define FEEDFORWARD_H
+
+/*
+ * Feedforward from the reference to the controller output. For a DC motor
+ * the steady-state voltage is affine in the speed and the torque that
+ * accelerates the rotor is proportional to the acceleration:
+ *
+ *   u_ff = ks + kv * rpm + ka * d(rpm)/dt      (ks only while rpm > 0)
+ *
+ * u_ff is in the units of u_k (0..1 spans DUTY_CYCLE_MIN..DUTY_CYCLE_MAX) and
+ * is added to the feedback output before the clamp, so the feedback
+ * controller only corrects what the model misses. ks holds the friction
+ * offset minus the duty floor, so it can be negative. All gains at zero
+ * (the default) turn the feedforward off.
+ */
+
+/**
+ * @brief Gains of the feedforward model.
+ */
+typedef struct {
+    float ks;   // Static offset while a speed is commanded [u_k]
+    float kv;   // Speed gain [u_k / RPM]
+    float ka;   // Acceleration gain [u_k / (RPM/s)]
+} feedforward_params_t;
+
+/**
+ * @brief Feedforward output for a reference speed and acceleration.
+ */
+float feedforward_output(const feedforward_params_t *params, float rpm, float rpm_per_s);
+
+#endif //header guard
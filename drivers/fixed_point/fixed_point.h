@@ -0,0 +1,84 @@
+#ifndef FIXED_POINT_H //header guard
+#define FIXED_POINT_H
+
+#include <stdint.h>
+
+/*
+ * Fixed-point conventions shared by the integer controller kernels
+ * (simulink_control_fixed and PID_Difuso_fixed).
+ *
+ *  - Signals (speeds, errors, controller states) are Q16.16 in encoder counts
+ *    per control tick: 1.0 = one encoder pulse (as counted by encoder_reader,
+ *    i.e. with 4x decoding) per 10 ms. Range +-32768 counts/tick.
+ *  - Coefficients are Q8.24: range +-128, resolution 6e-8.
+ *  - The control output is Q15: 0x7FFF = u_k of 1.0.
+ *
+ * A signal times a coefficient is formed in 64 bits and shifted back by 24,
+ * which keeps the result in Q16.16. Every store saturates instead of wrapping.
+ */
+
+// --- Formats ---
+#define FX_Q16_ONE      (1L << 16)
+#define FX_COEF_SHIFT   24
+#define FX_Q15_ONE      0x7FFF
+
+// Converts a floating-point constant to a Q8.24 coefficient (compile time or init only).
+#define FX_COEF(x)      ((int32_t)((x) * (double)(1L << FX_COEF_SHIFT) + ((x) < 0 ? -0.5 : 0.5)))
+// Converts a floating-point value to Q16.16 (host side or init only).
+#define FX_Q16(x)       ((int32_t)((x) * (double)FX_Q16_ONE + ((x) < 0 ? -0.5 : 0.5)))
+
+// --- Speed scaling ---
+// One encoder count per tick in RPM: 60000 / (CYCLE_ADJUSTMENT * PPR * TS_MS)
+// = 60000 / (8 * 199 * 10). Kept here so the kernels do not depend on the HAL.
+#define FX_RPM_PER_COUNT 3.768844221105528
+
+// Same smoothing factor as RPM_FILTER_ALPHA in encoder_reader.h.
+#define FX_RPM_FILTER_ALPHA FX_COEF(0.1)
+
+/**
+ * @brief Saturates a 64-bit intermediate to int32.
+ */
+static inline int32_t fx_sat32(int64_t x) {
+    if (x > INT32_MAX) return INT32_MAX;
+    if (x < INT32_MIN) return INT32_MIN;
+    return (int32_t)x;
+}
+
+/**
+ * @brief Saturating Q16.16 addition.
+ */
+static inline int32_t fx_add(int32_t a, int32_t b) {
+    return fx_sat32((int64_t)a + b);
+}
+
+/**
+ * @brief Q16.16 signal times Q8.24 coefficient, rounded, saturated, in Q16.16.
+ */
+static inline int32_t fx_mul(int32_t signal, int32_t coef) {
+    int64_t p = (int64_t)signal * coef;
+    return fx_sat32((p + (1LL << (FX_COEF_SHIFT - 1))) >> FX_COEF_SHIFT);
+}
+
+/**
+ * @brief Q16.16 value (1.0 = full scale) to a Q15 output saturated to [0, 1].
+ */
+static inline int16_t fx_to_q15_unipolar(int32_t x) {
+    int32_t q15 = (x + 1) >> 1;
+    if (q15 < 0) return 0;
+    if (q15 > FX_Q15_ONE) return FX_Q15_ONE;
+    return (int16_t)q15;
+}
+
+/**
+ * @brief Integer version of the EMA in encoder_get_rpm(), applied to the raw
+ * pulse count of one tick.
+ * @param filtered_q16 The previous filtered speed (Q16.16 counts/tick).
+ * @param pulses The encoder pulses counted during this tick.
+ * @return The new filtered speed (Q16.16 counts/tick).
+ */
+static inline int32_t fx_speed_filter(int32_t filtered_q16, int32_t pulses) {
+    int32_t raw_q16 = fx_sat32((int64_t)pulses * FX_Q16_ONE);
+    return fx_add(filtered_q16, fx_mul(fx_sat32((int64_t)raw_q16 - filtered_q16), FX_RPM_FILTER_ALPHA));
+}
+
+#endif //header guard
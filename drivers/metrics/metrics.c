@@ -0,0 +1,88 @@
+#include "metrics.h"
+#include <string.h>
+#include <math.h>
+
+/**
+ * @brief Starts a summary at time 't_seconds'.
+ */
+static void metrics_summary_start(metrics_summary_t *s, uint16_t number, float t_seconds) {
+    memset(s, 0, sizeof(*s));
+    s->number = number;
+    s->t_start = t_seconds;
+}
+
+/**
+ * @brief Kahan summation: adds 'value' to '*sum', carrying the rounding error
+ * in '*comp', so long runs at 100 Hz do not lose the small increments.
+ */
+static void metrics_kahan_add(float *sum, float *comp, float value) {
+    float y = value - *comp;
+    float t = *sum + y;
+    *comp = (t - *sum) - y;
+    *sum = t;
+}
+
+/**
+ * @brief Adds one sample to a summary.
+ */
+static void metrics_summary_add(metrics_summary_t *s, float period_s, float t_seconds, float reference_rpm,
+                                float error, float excess) {
+    float abs_error = fabsf(error);
+    s->samples++;
+    // Running mean instead of a sum of squares: it stays in range however long the run.
+    s->mse += (error * error - s->mse) / (float)s->samples;
+    metrics_kahan_add(&s->iae, &s->iae_comp, abs_error * period_s);
+    metrics_kahan_add(&s->itae, &s->itae_comp, (t_seconds - s->t_start) * abs_error * period_s);
+    if (abs_error > s->max_error) s->max_error = abs_error;
+    if (excess > s->overshoot) s->overshoot = excess;
+
+    float band = fmaxf(METRICS_SETTLE_FRACTION * fabsf(reference_rpm), METRICS_SETTLE_MIN_RPM);
+    if (abs_error > band) {
+        // Not settled yet: it cannot settle before the next sample.
+        s->settling_time = t_seconds + period_s - s->t_start;
+    }
+    s->duration = t_seconds + period_s - s->t_start;
+    s->reference_end = reference_rpm;
+}
+
+void metrics_reset(metrics_t *metrics, float period_s) {
+    memset(metrics, 0, sizeof(*metrics));
+    metrics->period_s = period_s;
+}
+
+void metrics_update(metrics_t *metrics, float t_seconds, float reference_rpm, float reference_slope,
+                    float measured_rpm, uint32_t segment_key) {
+    if (metrics->run.samples == 0) {
+        metrics_summary_start(&metrics->run, 0, t_seconds);
+    }
+    if (metrics->segment_count == 0 || segment_key != metrics->segment_key) {
+        metrics_summary_start(&metrics->segments[metrics->segment_count % METRICS_MAX_SEGMENTS],
+                              metrics->segment_count, t_seconds);
+        metrics->segment_count++;
+        metrics->segment_key = segment_key;
+    }
+
+    // An overshoot is an excess in the direction the reference last moved;
+    // on a hold it keeps the direction of the ramp before it.
+    if (reference_slope > 0.0f) metrics->direction = 1;
+    if (reference_slope < 0.0f) metrics->direction = -1;
+    float error = reference_rpm - measured_rpm;
+    float excess = (float)metrics->direction * (measured_rpm - reference_rpm);
+
+    metrics_summary_t *segment = &metrics->segments[(metrics->segment_count - 1) % METRICS_MAX_SEGMENTS];
+    metrics_summary_add(segment, metrics->period_s, t_seconds, reference_rpm, error, excess);
+    metrics_summary_add(&metrics->run, metrics->period_s, t_seconds, reference_rpm, error, excess);
+}
+
+uint8_t metrics_segments_stored(const metrics_t *metrics) {
+    return metrics->segment_count < METRICS_MAX_SEGMENTS ? (uint8_t)metrics->segment_count : METRICS_MAX_SEGMENTS;
+}
+
+const metrics_summary_t *metrics_segment(const metrics_t *metrics, uint8_t index) {
+    uint8_t stored = metrics_segments_stored(metrics);
+    if (index >= stored) {
+        return NULL;
+    }
+    uint16_t first = metrics->segment_count - stored;
+    return &metrics->segments[(uint16_t)(first + index) % METRICS_MAX_SEGMENTS];
+}
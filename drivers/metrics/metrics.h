@@ -0,0 +1,80 @@
+#ifndef METRICS_H //header guard
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// --- Metrics Configuration ---
+// Segments kept for per-segment results; older ones are overwritten, the
+// whole-run result always covers everything since the last reset.
+#define METRICS_MAX_SEGMENTS    16
+// Settling band: |error| within 2 % of the reference, but never narrower than
+// the speed resolution of one encoder count per period.
+#define METRICS_SETTLE_FRACTION 0.02f
+#define METRICS_SETTLE_MIN_RPM  10.0f
+
+/**
+ * @brief Tracking metrics of one stretch of a run (a trajectory segment or
+ * the whole run). Every field is updated in a single pass, one sample at a time.
+ */
+typedef struct {
+    uint16_t number;        // Segment number since the reset (0 for the whole run).
+    uint32_t samples;       // Samples taken.
+    float t_start;          // Time of the first sample [s].
+    float duration;         // Time covered [s].
+    float mse;              // Mean of error^2 [RPM^2], kept as a running mean.
+    float iae;              // Integral of |error| [RPM s].
+    float itae;             // Integral of (t - t_start) |error| [RPM s^2].
+    float max_error;        // Largest |error| [RPM].
+    float overshoot;        // Largest excess of the speed past the reference in the direction of motion [RPM].
+    float settling_time;    // From t_start until |error| stays inside the settling band [s].
+    float reference_end;    // Reference at the last sample [RPM].
+
+    // Compensation terms of the Kahan sums of iae and itae.
+    float iae_comp;
+    float itae_comp;
+} metrics_summary_t;
+
+/**
+ * @brief Streaming metrics of a run, per segment and overall.
+ * About 0.9 kB; nothing is stored per sample.
+ */
+typedef struct {
+    float period_s;                                  // Sample period, weight of each sample in the integrals.
+    metrics_summary_t run;
+    metrics_summary_t segments[METRICS_MAX_SEGMENTS]; // Ring of the latest segments.
+    uint16_t segment_count;                          // Segments seen since the reset.
+    uint32_t segment_key;                            // Key of the current segment.
+    int8_t direction;                                // Sign of the last non-zero reference slope.
+} metrics_t;
+
+/**
+ * @brief Clears the metrics for a new run.
+ * @param period_s Time between two samples [s].
+ */
+void metrics_reset(metrics_t *metrics, float period_s);
+
+/**
+ * @brief Adds one sample.
+ * @param t_seconds Time of the sample since the start of the run.
+ * @param reference_rpm Reference speed.
+ * @param reference_slope Reference acceleration [RPM/s]; only its sign is used,
+ * to tell the direction in which an overshoot counts.
+ * @param measured_rpm Measured speed.
+ * @param segment_key Identifies the trajectory segment; a new key starts a new segment.
+ */
+void metrics_update(metrics_t *metrics, float t_seconds, float reference_rpm, float reference_slope,
+                    float measured_rpm, uint32_t segment_key);
+
+/**
+ * @brief Number of segments whose results are still kept (at most METRICS_MAX_SEGMENTS).
+ */
+uint8_t metrics_segments_stored(const metrics_t *metrics);
+
+/**
+ * @brief Results of a stored segment, oldest first (the last one is still running).
+ * @return NULL if 'index' is not below metrics_segments_stored().
+ */
+const metrics_summary_t *metrics_segment(const metrics_t *metrics, uint8_t index);
+
+#endif //header guard
@@ -38,10 +38,22 @@ typedef unsigned int  uint32_T;
 typedef float         real32_T;
 typedef double        real64_T; 
 
+/* --- Controller precision --- */
+// Build with CONTROL_SINGLE_PRECISION=1 to compute the controllers in 'float'.
+// The ESP32 FPU only supports single precision, so every 'double' operation is
+// emulated in software. This header is shared (same guard) with PID_Difuso.
+#ifndef CONTROL_SINGLE_PRECISION
+#define CONTROL_SINGLE_PRECISION 0
+#endif
+
 /* --- Generic type definitions --- */
 // These are the general-purpose types that Simulink will use for most calculations.
 // By default, 'real_T' is set to 'double' to ensure maximum numerical precision and avoid rounding errors in control calculations.
+#if CONTROL_SINGLE_PRECISION
+typedef float         real_T;   // Single-precision build: runs on the ESP32 FPU.
+#else
 typedef double        real_T;   // The default type for all floating-point calculations.
+#endif
 typedef double        time_T;   // The default type for representing time.
 typedef unsigned char boolean_T;
 typedef int           int_T;   
@@ -12,62 +12,133 @@
  */
 
 #include "simulink_control.h"
+#include "simulink_control_private.h"
 #include "rtwtypes.h"
 
-#define Kp 0.016f
-#define Ki 2.0f
-#define Kd 0.01f
-#define N 9000.0f
-
 /* --- Global Variable Definitions --- */
 DW_simulink_control_T simulink_control_DW;
 ExtU_simulink_control_T simulink_control_U;
 ExtY_simulink_control_T simulink_control_Y;
 
-/* ... (Internal Real-Time Model structure definitions) ... */
+/* --- Tunable parameters of the global instance --- */
+P_simulink_control_T simulink_control_P = {
+  DEFAULT_KP,                          // Kp
+  DEFAULT_KI,                          // Ki
+  DEFAULT_KD,                          // Kd
+  DEFAULT_N                            // N
+};
+
+/* --- Real-time model of the global instance (used by the wrappers) --- */
+static RT_MODEL_simulink_control_T simulink_control_M_ = {
+  &simulink_control_P,
+  &simulink_control_DW,
+  &simulink_control_U,
+  &simulink_control_Y
+};
+RT_MODEL_simulink_control_T *const simulink_control_M = &simulink_control_M_;
 
 /**
- * @brief Executes one step of the discrete-time PID controller.
- * This function should be called at a fixed interval (e.g., every 10ms).
+ * @brief Executes one step of the discrete-time PID controller for one instance.
+ * This function should be called every Ts (simulink_control_discretize_r()).
+ * It only touches the data referenced by the model, so it is reentrant.
  */
-void simulink_control_step(void)
+void simulink_control_step_r(RT_MODEL_simulink_control_T *const rtM)
 {
+  const P_simulink_control_T *rtP = rtM->defaultParam;
+  DW_simulink_control_T *rtDW = rtM->dwork;
+  real_T error_signal = rtM->inputs->error_signal;
   real_T denAccum;
 
   /* --- 1. CALCULATE THE DERIVATIVE (D) TERM --- */
   // This block implements a discrete-time derivative with a low-pass filter.
-  denAccum = Kd * simulink_control_U.error_signal - -0.009931682274340237 *
-    simulink_control_DW.FilterDifferentiatorTF_states;
+  denAccum = rtP->Kd * error_signal + rtDW->FilterPole *
+    rtDW->FilterDifferentiatorTF_states;
 
   /* --- 2. CALCULATE THE INTEGRAL (I) TERM --- */
   // This block implements the discrete-time integrator. It accumulates the error over time.
   // Equation: I(k) = I(k-1) + Ki * error(k) * sample_time
-  simulink_control_DW.Integrator_DSTATE += Ki *
-    simulink_control_U.error_signal * 0.01;
+  rtDW->Integrator_DSTATE += rtDW->IntGain * error_signal;
 
   /* --- 3. CALCULATE THE FINAL CONTROL OUTPUT (u_k) --- */
   // Main PID equation: u_k = Kp * (P_term + I_term + D_term)
-  simulink_control_Y.u_k = (
+  rtM->outputs->u_k = (
       // --- D Term Output ---
-      (denAccum - simulink_control_DW.FilterDifferentiatorTF_states) * 0.009931682274340237 * N
-      
+      (denAccum - rtDW->FilterDifferentiatorTF_states) * rtDW->FilterPole * rtP->N
+
       // --- P and I Term Sum ---
-      + (simulink_control_U.error_signal           // Proportional (P) term
-         + simulink_control_DW.Integrator_DSTATE)  // Integral (I) term
-    
+      + (error_signal                  // Proportional (P) term
+         + rtDW->Integrator_DSTATE)    // Integral (I) term
+
     // --- Global Proportional Gain (Kp) ---
-    ) * Kp;
+    ) * rtP->Kp;
 
   /* --- 4. UPDATE STATE FOR NEXT ITERATION --- */
   // The current state of the derivative filter becomes the "previous" state for the next step.
-  simulink_control_DW.FilterDifferentiatorTF_states = denAccum;
+  rtDW->FilterDifferentiatorTF_states = denAccum;
 }
 
 /**
- * @brief Initializes the model's states.
+ * @brief Initializes the states of one instance to zero.
  * Call this function once at startup or to reset the controller.
  */
+void simulink_control_initialize_r(RT_MODEL_simulink_control_T *const rtM)
+{
+  rtM->dwork->FilterDifferentiatorTF_states = (real_T)0.0;
+  rtM->dwork->Integrator_DSTATE = (real_T)0.0;
+  rtM->outputs->u_k = (real_T)0.0;
+
+  // Instances that never got a sample time run at the default one.
+  if (!(rtM->dwork->Ts > (real_T)0.0)) {
+    simulink_control_discretize_r(rtM, (real_T)DEFAULT_TS);
+  }
+}
+
+/**
+ * @brief Computes the discrete coefficients of one instance for sample time Ts.
+ * The generated filter pole has the backward Euler form 1 / (1 + Nf * Ts0)
+ * at Ts0 = DEFAULT_TS; it is moved to Ts with the same filter bandwidth Nf,
+ * so Ts = DEFAULT_TS gives FilterCoef exactly.
+ */
+void simulink_control_discretize_r(RT_MODEL_simulink_control_T *const rtM, real_T Ts)
+{
+  real_T ratio = Ts / (real_T)DEFAULT_TS;
+  rtM->dwork->Ts = Ts;
+  rtM->dwork->FilterPole = (real_T)FilterCoef /
+    ((real_T)FilterCoef + ((real_T)1.0 - (real_T)FilterCoef) * ratio);
+  rtM->dwork->IntGain = rtM->defaultParam->Ki * Ts;
+}
+
+/**
+ * @brief Primes the states of one instance so that its next step, with the
+ * given error, outputs u_k (bumpless transfer from another controller).
+ * The derivative filter is set to its steady state for that error, so the
+ * D term contributes nothing, and the integrator takes the rest.
+ */
+void simulink_control_track_r(RT_MODEL_simulink_control_T *const rtM, real_T u_k, real_T error_signal)
+{
+  const P_simulink_control_T *rtP = rtM->defaultParam;
+  DW_simulink_control_T *rtDW = rtM->dwork;
+
+  rtDW->FilterDifferentiatorTF_states = rtP->Kd * error_signal / ((real_T)1.0 - rtDW->FilterPole);
+
+  // The step adds Ki * error * Ts to the integrator before it forms u_k.
+  rtDW->Integrator_DSTATE = (rtP->Kp > (real_T)0.0 ? u_k / rtP->Kp : (real_T)0.0)
+    - error_signal - rtDW->IntGain * error_signal;
+  rtM->outputs->u_k = u_k;
+}
+
+/* --- Entry points of the global instance (thin wrappers) --- */
+void simulink_control_step(void)
+{
+  simulink_control_step_r(simulink_control_M);
+}
+
 void simulink_control_initialize(void)
 {
-  // No explicit initialization code is required here, as states default to zero.
-}
\ No newline at end of file
+  simulink_control_initialize_r(simulink_control_M);
+}
+
+void simulink_control_terminate(void)
+{
+  /* (no terminate code required) */
+}
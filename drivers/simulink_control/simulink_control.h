@@ -31,6 +31,12 @@ typedef struct {
   // The state variable for the integral term. This is the most important state,
   // as it accumulates the sum of the error over time.
   real_T Integrator_DSTATE;
+
+  // Discretization of the instance (not states: a reset keeps them). Set by
+  // simulink_control_discretize_r() from the sample time and Ki.
+  real_T Ts;          // Sample time in seconds.
+  real_T FilterPole;  // Pole of the derivative filter (FilterCoef at DEFAULT_TS).
+  real_T IntGain;     // Integrator gain per step, Ki * Ts.
 } DW_simulink_control_T;
 
 /* --- EXTERNAL INPUTS DATA STRUCTURE --- */
@@ -45,6 +51,25 @@ typedef struct {
   real_T u_k;
 } ExtY_simulink_control_T;
 
+/* --- PARAMETERS DATA STRUCTURE --- */
+typedef struct {
+  real_T Kp;  // Global proportional gain.
+  real_T Ki;  // Integral gain.
+  real_T Kd;  // Derivative gain.
+  real_T N;   // Derivative filter coefficient.
+} P_simulink_control_T;
+
+/* --- REAL-TIME MODEL (ONE CONTROLLER INSTANCE) --- */
+// Every instance owns its parameters, states, inputs and outputs. Several
+// instances (several motors, or candidate controllers) can run side by side,
+// on different cores if needed, as they share no mutable data.
+struct tag_RTM_simulink_control_T {
+  P_simulink_control_T *defaultParam;
+  DW_simulink_control_T *dwork;
+  ExtU_simulink_control_T *inputs;
+  ExtY_simulink_control_T *outputs;
+};
+
 /* --- GLOBAL VARIABLE DECLARATIONS --- */
 // The 'extern' keyword tells other files (like main.c) that these global variables
 // exist and can be used. Their actual definition and memory allocation are in simulink_control.c.
@@ -58,7 +83,40 @@ extern ExtU_simulink_control_T simulink_control_U;
 // Declaration of the global structure for the controller's outputs.
 extern ExtY_simulink_control_T simulink_control_Y;
 
-/* --- MODEL ENTRY-POINT FUNCTION DECLARATIONS --- */
+// Tunable parameters of the global instance (also the defaults for new instances).
+extern P_simulink_control_T simulink_control_P;
+
+// Real-time model of the global instance.
+extern RT_MODEL_simulink_control_T *const simulink_control_M;
+
+/* --- REENTRANT ENTRY POINTS (ONE CALL PER INSTANCE) --- */
+/**
+ * @brief Resets the states of the given instance to zero. An instance that
+ * was never discretized gets the default sample time (DEFAULT_TS).
+ */
+extern void simulink_control_initialize_r(RT_MODEL_simulink_control_T *const rtM);
+
+/**
+ * @brief Sets the sample time of the given instance and computes its discrete
+ * coefficients from it and the current parameters: FilterPole (from Ts
+ * only) and IntGain (Ki * Ts). Call it again after a change of Ki. The
+ * states are kept.
+ * @param Ts Sample time in seconds (> 0).
+ */
+extern void simulink_control_discretize_r(RT_MODEL_simulink_control_T *const rtM, real_T Ts);
+
+/**
+ * @brief Executes one step of the given instance.
+ */
+extern void simulink_control_step_r(RT_MODEL_simulink_control_T *const rtM);
+
+/**
+ * @brief Sets the states of the given instance so that its next step with
+ * 'error_signal' outputs 'u_k' (bumpless switch from another controller).
+ */
+extern void simulink_control_track_r(RT_MODEL_simulink_control_T *const rtM, real_T u_k, real_T error_signal);
+
+/* --- MODEL ENTRY-POINT FUNCTION DECLARATIONS (GLOBAL INSTANCE) --- */
 /**
  * @brief Initializes the controller's states to their starting values (usually zero).
  */
@@ -66,7 +124,7 @@ extern void simulink_control_initialize(void);
 
 /**
  * @brief Executes one computational step of the PID controller.
- * Call this function repeatedly at your fixed sample rate (10ms).
+ * Call this function repeatedly at the sample rate of the global instance (DEFAULT_TS).
  */
 extern void simulink_control_step(void);
 
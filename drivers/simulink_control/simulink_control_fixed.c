@@ -0,0 +1,58 @@
+/*
+ * File: simulink_control_fixed.c
+ *
+ * Purpose: Integer implementation of simulink_control_step().
+ *
+ * Scaling: with e the error in counts/tick and R = FX_RPM_PER_COUNT, the
+ * floating-point controller computes (RPM domain)
+ *   s(k) = Kd*R*e + a*s(k-1),  I(k) = I(k-1) + Ki*Ts*R*e
+ *   u    = Kp * ((s(k) - s(k-1))*a*N + R*e + I(k))
+ * Keeping the filter state w = s/(Kd*R) and the integrator in counts gives
+ *   w(k) = e + a*w(k-1),       I(k) = I(k-1) + Ki*Ts*e
+ *   u    = Kp*R * (e + I(k) + Kd*a*N*(w(k) - w(k-1)))
+ * so every coefficient below fits comfortably in Q8.24.
+ */
+
+#include "simulink_control_fixed.h"
+#include "simulink_control_private.h"
+#include "fixed_point.h"
+
+/* --- Q8.24 COEFFICIENTS --- */
+#define FX_FILTER_A   FX_COEF(FilterCoef)                      // a
+#define FX_DERIV_GAIN FX_COEF(DEFAULT_KD * FilterCoef * DEFAULT_N)             // Kd*a*N
+#define FX_INT_GAIN   FX_COEF(DEFAULT_KI * DEFAULT_TS)                 // Ki*Ts
+#define FX_OUT_GAIN   FX_COEF(DEFAULT_KP * FX_RPM_PER_COUNT)           // Kp*R (1.0 = full scale)
+
+void simulink_control_fixed_initialize(DW_simulink_control_fixed_T *dw)
+{
+  dw->speed_q16 = 0;
+  dw->filter_q16 = 0;
+  dw->integrator_q16 = 0;
+}
+
+int16_t simulink_control_fixed_step(DW_simulink_control_fixed_T *dw,
+  int32_t reference_q16, int32_t pulses)
+{
+  int32_t error;
+  int32_t filter;
+  int32_t sum;
+
+  /* --- 0. MEASUREMENT (same EMA as encoder_get_rpm) --- */
+  dw->speed_q16 = fx_speed_filter(dw->speed_q16, pulses);
+  error = fx_add(reference_q16, -dw->speed_q16);
+
+  /* --- 1. DERIVATIVE (D) TERM --- */
+  filter = fx_add(error, fx_mul(dw->filter_q16, FX_FILTER_A));
+
+  /* --- 2. INTEGRAL (I) TERM --- */
+  dw->integrator_q16 = fx_add(dw->integrator_q16, fx_mul(error, FX_INT_GAIN));
+
+  /* --- 3. FINAL CONTROL OUTPUT --- */
+  sum = fx_add(fx_add(error, dw->integrator_q16),
+               fx_mul(fx_add(filter, -dw->filter_q16), FX_DERIV_GAIN));
+
+  /* --- 4. UPDATE STATE FOR NEXT ITERATION --- */
+  dw->filter_q16 = filter;
+
+  return fx_to_q15_unipolar(fx_mul(sum, FX_OUT_GAIN));
+}
@@ -0,0 +1,37 @@
+/*
+ * File: simulink_control_fixed.h
+ *
+ * Purpose: Fixed-point (integer-only) version of the conventional PID in
+ * simulink_control_step(). It takes the raw encoder pulse count of each tick,
+ * applies the same EMA as encoder_get_rpm() and runs the same PID, all with
+ * saturating integer arithmetic. See fixed_point.h for the number formats.
+ */
+
+#ifndef simulink_control_fixed_h_ //header guard
+#define simulink_control_fixed_h_
+
+#include <stdint.h>
+
+/* --- BLOCK STATES (Q16.16, encoder counts per tick) --- */
+typedef struct {
+  int32_t speed_q16;      // EMA-filtered measured speed.
+  int32_t filter_q16;     // Derivative filter state, in error units.
+  int32_t integrator_q16; // Integrator state, in error units.
+} DW_simulink_control_fixed_T;
+
+/**
+ * @brief Resets the states to zero.
+ */
+extern void simulink_control_fixed_initialize(DW_simulink_control_fixed_T *dw);
+
+/**
+ * @brief Executes one step of the fixed-point PID.
+ * @param dw The controller states.
+ * @param reference_q16 Reference speed in Q16.16 counts per tick.
+ * @param pulses Encoder pulses counted during this tick.
+ * @return The control signal u_k in Q15, saturated to [0, 1].
+ */
+extern int16_t simulink_control_fixed_step(DW_simulink_control_fixed_T *dw,
+  int32_t reference_q16, int32_t pulses);
+
+#endif  // header guard
@@ -17,4 +17,20 @@
 #include "rtwtypes.h"
 #include "simulink_control_types.h"
 
+/* --- DEFAULT PID GAINS --- */
+// Initial values of simulink_control_P (tunable per instance) and the gains
+// compiled into the fixed-point kernel (simulink_control_fixed.c).
+#define DEFAULT_KP 0.016f
+#define DEFAULT_KI 2.0f
+#define DEFAULT_KD 0.01f
+#define DEFAULT_N  9000.0f
+
+// Sample time of the global instance, of instances that are never
+// discretized, and of the fixed-point kernel.
+#define DEFAULT_TS 0.01
+
+// Pole of the discrete derivative filter at DEFAULT_TS (generated). The
+// floating-point instances scale it to their sample time at runtime.
+#define FilterCoef 0.009931682274340237
+
 #endif  //header guard
\ No newline at end of file
@@ -0,0 +1,289 @@
+#include "telemetry.h"
+#include "telemetry_ring.h"
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+#else
+#include <stdio.h>
+#endif
+
+// --- UART Configuration ---
+#define TELEMETRY_UART      UART_NUM_0
+#define TELEMETRY_RX_BUFFER 256
+
+// Sequence number of the next sample frame.
+static uint16_t sample_seq = 0;
+
+// --- Asynchronous Pipeline State ---
+static telemetry_ring_t ring;
+static telemetry_stats_t stats;
+static bool ring_was_full = false;
+#ifdef ESP_PLATFORM
+static TaskHandle_t writer_task = NULL;
+// The writer task and telemetry_send_frame_now() (command task) both add to
+// the sent counters.
+static portMUX_TYPE sent_mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+uint16_t telemetry_crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Consistent Overhead Byte Stuffing: removes every 0x00 from the data so
+ * that 0x00 can be used as an unambiguous frame delimiter.
+ * @return The encoded length (without the delimiter).
+ */
+static size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t code_pos = 0;
+    size_t out_pos = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_pos] = code;
+            code_pos = out_pos++;
+            code = 1;
+        } else {
+            out[out_pos++] = in[i];
+            if (++code == 0xFF) {
+                out[code_pos] = code;
+                code_pos = out_pos++;
+                code = 1;
+            }
+        }
+    }
+    out[code_pos] = code;
+    return out_pos;
+}
+
+// --- Little-endian packing helpers ---
+static uint8_t *put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static uint8_t *put_f32(uint8_t *p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return put_u32(p, bits);
+}
+
+// Converts a speed to a saturated int16 in units of TELEMETRY_RPM_SCALE.
+static uint16_t rpm_to_wire(float rpm) {
+    float scaled = rpm / TELEMETRY_RPM_SCALE;
+    if (scaled > 32767.0f) scaled = 32767.0f;
+    if (scaled < -32768.0f) scaled = -32768.0f;
+    return (uint16_t)(int16_t)(scaled < 0.0f ? scaled - 0.5f : scaled + 0.5f);
+}
+
+// Converts u_k (0.0 to 1.0) to a saturated Q16 fraction.
+static uint16_t duty_to_wire(float u_k) {
+    if (u_k <= 0.0f) return 0;
+    if (u_k >= 1.0f) return 0xFFFF;
+    return (uint16_t)(u_k * 65535.0f + 0.5f);
+}
+
+size_t telemetry_encode_frame(const uint8_t *payload, size_t len, uint8_t *frame) {
+    uint8_t raw[TELEMETRY_MAX_PAYLOAD_LEN + 2];
+    memcpy(raw, payload, len);
+    put_u16(&raw[len], telemetry_crc16(payload, len));
+
+    size_t n = cobs_encode(raw, len + 2, frame);
+    frame[n++] = 0x00; // Frame delimiter
+    return n;
+}
+
+size_t telemetry_encode_sample(const telemetry_sample_t *sample, uint8_t *frame) {
+    uint8_t payload[TELEMETRY_SAMPLE_PAYLOAD_LEN];
+    uint8_t *p = payload;
+
+    *p++ = TELEMETRY_FRAME_SAMPLE;
+    p = put_u16(p, sample->seq);
+    p = put_u32(p, sample->timestamp_us);
+    p = put_u16(p, rpm_to_wire(sample->reference_rpm));
+    p = put_u16(p, rpm_to_wire(sample->measured_rpm));
+    put_u16(p, duty_to_wire(sample->u_k));
+
+    return telemetry_encode_frame(payload, sizeof(payload), frame);
+}
+
+#if TELEMETRY_STATES
+/**
+ * @brief Encodes the controller states of a sample into a STATES frame.
+ */
+static size_t telemetry_encode_states(const telemetry_sample_t *sample, uint8_t *frame) {
+    uint8_t payload[TELEMETRY_STATES_PAYLOAD_LEN];
+    uint8_t *p = payload;
+
+    *p++ = TELEMETRY_FRAME_STATES;
+    p = put_u16(p, sample->seq);
+    p = put_f32(p, sample->state[0]);
+    put_f32(p, sample->state[1]);
+
+    return telemetry_encode_frame(payload, sizeof(payload), frame);
+}
+#endif
+
+/**
+ * @brief Writes a batch of encoded frames to the output channel and counts them.
+ */
+static void telemetry_write(const uint8_t *data, size_t len, uint32_t frames) {
+#ifdef ESP_PLATFORM
+    uart_write_bytes(TELEMETRY_UART, data, len);
+    portENTER_CRITICAL(&sent_mux);
+#else
+    fwrite(data, 1, len, stdout);
+#endif
+    stats.frames_sent += frames;
+    stats.bytes_sent += len;
+#ifdef ESP_PLATFORM
+    portEXIT_CRITICAL(&sent_mux);
+#endif
+}
+
+/**
+ * @brief Queues a record, keeping the producer-side counters.
+ */
+static void telemetry_queue(const telemetry_record_t *record) {
+    if (telemetry_ring_push(&ring, record)) {
+        stats.queued++;
+        ring_was_full = false;
+        uint32_t count = telemetry_ring_count(&ring);
+        if (count > stats.high_water) stats.high_water = count;
+    } else {
+        stats.dropped++;
+        if (!ring_was_full) stats.overflows++;
+        ring_was_full = true;
+    }
+}
+
+void telemetry_flush(void) {
+    uint8_t batch[TELEMETRY_BATCH_LEN];
+    size_t batch_len = 0;
+    uint32_t batch_frames = 0;
+    telemetry_record_t record;
+
+    while (telemetry_ring_pop(&ring, &record)) {
+        // A sample can take two frames (TELEMETRY_STATES).
+        if (batch_len + 2 * TELEMETRY_MAX_FRAME_LEN > sizeof(batch)) {
+            telemetry_write(batch, batch_len, batch_frames);
+            batch_len = 0;
+            batch_frames = 0;
+        }
+
+        uint8_t payload[5];
+        switch (record.type) {
+            case TELEMETRY_FRAME_SAMPLE:
+                batch_len += telemetry_encode_sample(&record.data.sample, &batch[batch_len]);
+#if TELEMETRY_STATES
+                batch_len += telemetry_encode_states(&record.data.sample, &batch[batch_len]);
+                batch_frames++;
+#endif
+                break;
+            case TELEMETRY_FRAME_MSE:
+                payload[0] = TELEMETRY_FRAME_MSE;
+                put_f32(&payload[1], record.data.mse);
+                batch_len += telemetry_encode_frame(payload, 5, &batch[batch_len]);
+                break;
+            case TELEMETRY_FRAME_RECORD:
+                batch_len += telemetry_encode_frame(record.data.raw.bytes, record.data.raw.len, &batch[batch_len]);
+                break;
+            case TELEMETRY_FRAME_RESET:
+            default:
+                payload[0] = record.type;
+                batch_len += telemetry_encode_frame(payload, 1, &batch[batch_len]);
+                break;
+        }
+        batch_frames++;
+    }
+
+    if (batch_len > 0) {
+        telemetry_write(batch, batch_len, batch_frames);
+    }
+}
+
+#ifdef ESP_PLATFORM
+// Low-priority task that drains the ring in batches.
+static void telemetry_writer_task(void *arg) {
+    while (1) {
+        telemetry_flush();
+        vTaskDelay(pdMS_TO_TICKS(TELEMETRY_WRITER_PERIOD_MS));
+    }
+}
+#endif
+
+void telemetry_init(void) {
+    sample_seq = 0;
+    telemetry_ring_init(&ring);
+#ifdef ESP_PLATFORM
+    // Writing through the UART driver bypasses the console's newline translation,
+    // which would otherwise corrupt binary frames. With a TX buffer the driver
+    // copies each batch and the UART interrupt feeds the FIFO in the background.
+    if (!uart_is_driver_installed(TELEMETRY_UART)) {
+        uart_driver_install(TELEMETRY_UART, TELEMETRY_RX_BUFFER, TELEMETRY_UART_TX_BUFFER, 0, NULL, 0);
+    }
+    if (writer_task == NULL) {
+        xTaskCreatePinnedToCore(telemetry_writer_task, "telemetry_tx", TELEMETRY_WRITER_STACK,
+                                NULL, TELEMETRY_WRITER_PRIORITY, &writer_task, TELEMETRY_WRITER_CORE);
+    }
+#endif
+}
+
+void telemetry_send_frame_now(const uint8_t *payload, size_t len) {
+    uint8_t frame[TELEMETRY_MAX_FRAME_LEN];
+    size_t n = telemetry_encode_frame(payload, len, frame);
+    telemetry_write(frame, n, 1);
+}
+
+void telemetry_send_sample(telemetry_sample_t *sample) {
+    telemetry_record_t record = { .type = TELEMETRY_FRAME_SAMPLE };
+    sample->seq = sample_seq++;
+    record.data.sample = *sample;
+    telemetry_queue(&record);
+}
+
+void telemetry_send_reset(void) {
+    telemetry_record_t record = { .type = TELEMETRY_FRAME_RESET };
+    sample_seq = 0;
+    telemetry_queue(&record);
+}
+
+void telemetry_send_mse(float mse) {
+    telemetry_record_t record = { .type = TELEMETRY_FRAME_MSE };
+    record.data.mse = mse;
+    telemetry_queue(&record);
+}
+
+void telemetry_send_record(const uint8_t *payload, size_t len) {
+    telemetry_record_t record = { .type = TELEMETRY_FRAME_RECORD };
+    if (len > TELEMETRY_RECORD_MAX_LEN) {
+        return;
+    }
+    record.data.raw.len = (uint8_t)len;
+    memcpy(record.data.raw.bytes, payload, len);
+    telemetry_queue(&record);
+}
+
+void telemetry_get_stats(telemetry_stats_t *out) {
+    *out = stats;
+}
@@ -0,0 +1,154 @@
+#ifndef TELEMETRY_H //header guard
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- Frame Types ---
+#define TELEMETRY_FRAME_SAMPLE  0x01 // One control-loop sample.
+#define TELEMETRY_FRAME_RESET   0x02 // The run was reset (replaces the "--- RESET ---" line).
+#define TELEMETRY_FRAME_MSE     0x03 // MSE of the finished run (replaces "MSE_RESULT:").
+#define TELEMETRY_FRAME_PARAMS  0x04 // Reply: current controller parameter block.
+#define TELEMETRY_FRAME_ACK     0x05 // Reply: status of a command.
+#define TELEMETRY_FRAME_METRICS 0x06 // Reply: tracking metrics of the run or of one segment.
+#define TELEMETRY_FRAME_RECORD  0x07 // One record of a session log (main/session_record.h).
+#define TELEMETRY_FRAME_CAPTURE 0x08 // Reply: one entry of the capture buffer (main/capture_buffer.h).
+#define TELEMETRY_FRAME_STATES  0x09 // Controller states of a sample (TELEMETRY_STATES builds only).
+
+// 1 = follow every sample frame with a STATES frame (idf.py -DTELEMETRY_STATES=ON
+// build). Off by default, so the link carries only what the plot needs.
+#ifndef TELEMETRY_STATES
+#define TELEMETRY_STATES 0
+#endif
+
+// --- Wire Format ---
+// Every frame is: payload | CRC-16/CCITT-FALSE (little endian) -> COBS encoded -> 0x00.
+// The sample payload (little endian) is:
+//   type u8 | seq u16 | timestamp_us u32 | reference i16 | measured i16 | u_k u16
+// Speeds are sent in units of TELEMETRY_RPM_SCALE and u_k (0..1) as a Q16
+// fraction; the error is reference - measured. 17 bytes on the wire.
+// The states payload carries the seq of its sample:
+//   type u8 | seq u16 | state0 f32 | state1 f32
+#define TELEMETRY_RPM_SCALE          0.1f
+#define TELEMETRY_SAMPLE_PAYLOAD_LEN 13
+#define TELEMETRY_STATES_PAYLOAD_LEN 11
+// Command replies can be longer than a sample.
+#define TELEMETRY_MAX_PAYLOAD_LEN    64
+// Longest payload telemetry_send_record() accepts (it is stored in the ring).
+#define TELEMETRY_RECORD_MAX_LEN     56
+// Payload + CRC + one COBS overhead byte + the 0x00 delimiter.
+#define TELEMETRY_MAX_FRAME_LEN      (TELEMETRY_MAX_PAYLOAD_LEN + 2 + 1 + 1)
+
+// --- Writer Task Configuration ---
+// The writer task drains the ring in batches every TELEMETRY_WRITER_PERIOD_MS.
+// It runs below the control task so UART back-pressure can never stall the loop.
+#define TELEMETRY_WRITER_PERIOD_MS 20
+#define TELEMETRY_WRITER_PRIORITY  (tskIDLE_PRIORITY + 2)
+#define TELEMETRY_WRITER_STACK     3072
+#define TELEMETRY_WRITER_CORE      0
+// Bytes encoded per uart_write_bytes() call and size of the UART driver TX buffer.
+#define TELEMETRY_BATCH_LEN        512
+#define TELEMETRY_UART_TX_BUFFER   2048
+
+/**
+ * @brief One control-loop sample as seen by the application.
+ */
+typedef struct {
+    uint16_t seq;            // Sequence number, assigned by telemetry_send_sample().
+    uint32_t timestamp_us;   // Device time at the start of the control step.
+    float reference_rpm;     // Reference speed.
+    float measured_rpm;      // Filtered measured speed.
+    float error;             // reference_rpm - measured_rpm.
+    float u_k;               // Normalized control signal (0.0 to 1.0).
+    float state[2];          // Internal states of the active controller.
+} telemetry_sample_t;
+
+/**
+ * @brief Counters of the asynchronous telemetry pipeline.
+ */
+typedef struct {
+    uint32_t queued;       // Records accepted into the ring.
+    uint32_t dropped;      // Records lost because the ring was full.
+    uint32_t overflows;    // Times the ring went from accepting to full.
+    uint32_t high_water;   // Largest number of records waiting in the ring.
+    uint32_t frames_sent;  // Frames handed to the UART (ring and telemetry_send_frame_now()).
+    uint32_t bytes_sent;   // Bytes handed to the UART (ring and telemetry_send_frame_now()).
+} telemetry_stats_t;
+
+/**
+ * @brief Prepares the output channel.
+ * On the ESP32 this installs the UART driver with a TX buffer and starts the
+ * low-priority writer task that drains the telemetry ring.
+ */
+void telemetry_init(void);
+
+/**
+ * @brief Encodes a sample into a complete, delimited frame.
+ * @param sample The sample to encode.
+ * @param frame Output buffer of at least TELEMETRY_MAX_FRAME_LEN bytes.
+ * @return The number of bytes written to 'frame'.
+ */
+size_t telemetry_encode_sample(const telemetry_sample_t *sample, uint8_t *frame);
+
+/**
+ * @brief Encodes a payload (whose first byte is the frame type) into a delimited frame.
+ * @param payload The raw payload.
+ * @param len Length of the payload (at most TELEMETRY_MAX_PAYLOAD_LEN).
+ * @param frame Output buffer of at least TELEMETRY_MAX_FRAME_LEN bytes.
+ * @return The number of bytes written to 'frame'.
+ */
+size_t telemetry_encode_frame(const uint8_t *payload, size_t len, uint8_t *frame);
+
+/**
+ * @brief Queues one control-loop sample. Never blocks; the sample is dropped
+ * (and counted) if the ring is full. Sequence numbers are assigned even to
+ * dropped samples, so the receiver sees the gap.
+ */
+void telemetry_send_sample(telemetry_sample_t *sample);
+
+/**
+ * @brief Queues a reset event frame.
+ */
+void telemetry_send_reset(void);
+
+/**
+ * @brief Queues the MSE of the finished run.
+ */
+void telemetry_send_mse(float mse);
+
+/**
+ * @brief Queues a prepared payload (first byte is the frame type) to be framed
+ * by the writer task. Never blocks; dropped and counted like a sample if the
+ * ring is full.
+ * @param len Length of the payload (at most TELEMETRY_RECORD_MAX_LEN).
+ */
+void telemetry_send_record(const uint8_t *payload, size_t len);
+
+/**
+ * @brief Encodes and writes one frame immediately, bypassing the ring.
+ * Used for command replies from a low-priority task: it blocks on the UART,
+ * so it must never be called from the control task. On the ESP32 the UART
+ * driver serializes whole writes, so frames from the writer task and from
+ * this call never interleave.
+ * @param payload The raw payload (first byte is the frame type).
+ * @param len Length of the payload (at most TELEMETRY_MAX_PAYLOAD_LEN).
+ */
+void telemetry_send_frame_now(const uint8_t *payload, size_t len);
+
+/**
+ * @brief Encodes and writes everything waiting in the ring.
+ * Called periodically by the writer task; host builds call it directly.
+ */
+void telemetry_flush(void);
+
+/**
+ * @brief Copies the pipeline counters.
+ */
+void telemetry_get_stats(telemetry_stats_t *stats);
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) used to protect every frame.
+ */
+uint16_t telemetry_crc16(const uint8_t *data, size_t len);
+
+#endif //header guard
@@ -0,0 +1,39 @@
+#include "telemetry_ring.h"
+
+#define RING_MASK (TELEMETRY_RING_SIZE - 1)
+
+_Static_assert((TELEMETRY_RING_SIZE & RING_MASK) == 0, "TELEMETRY_RING_SIZE must be a power of two");
+
+void telemetry_ring_init(telemetry_ring_t *ring) {
+    atomic_store_explicit(&ring->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, 0, memory_order_relaxed);
+}
+
+bool telemetry_ring_push(telemetry_ring_t *ring, const telemetry_record_t *record) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= TELEMETRY_RING_SIZE) {
+        return false; // Full
+    }
+    ring->slots[head & RING_MASK] = *record;
+    // Release: the slot contents become visible before the new head.
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool telemetry_ring_pop(telemetry_ring_t *ring, telemetry_record_t *record) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (head == tail) {
+        return false; // Empty
+    }
+    *record = ring->slots[tail & RING_MASK];
+    // Release: the slot is only handed back to the producer after it was copied.
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+uint32_t telemetry_ring_count(telemetry_ring_t *ring) {
+    return atomic_load_explicit(&ring->head, memory_order_acquire) -
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
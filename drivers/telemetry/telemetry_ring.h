@@ -0,0 +1,64 @@
+#ifndef TELEMETRY_RING_H //header guard
+#define TELEMETRY_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "telemetry.h"
+
+// --- Ring Configuration ---
+// Number of records the ring can hold. Must be a power of two.
+// 64 records buffer 640 ms of samples at the 10 ms control period.
+#define TELEMETRY_RING_SIZE 64
+
+/**
+ * @brief One entry of the ring: a sample or an event, encoded later by the writer.
+ */
+typedef struct {
+    uint8_t type; // One of the TELEMETRY_FRAME_* values.
+    union {
+        telemetry_sample_t sample;
+        float mse;
+        struct {
+            uint8_t len;
+            uint8_t bytes[TELEMETRY_RECORD_MAX_LEN];
+        } raw;                    // Prepared payload (TELEMETRY_FRAME_RECORD)
+    } data;
+} telemetry_record_t;
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring buffer.
+ *
+ * The control task is the only producer and the writer task the only consumer,
+ * so 'head' is written only by the producer and 'tail' only by the consumer.
+ * Free-running 32-bit indices are masked with TELEMETRY_RING_SIZE - 1.
+ */
+typedef struct {
+    _Atomic uint32_t head; // Next slot to write (producer).
+    _Atomic uint32_t tail; // Next slot to read (consumer).
+    telemetry_record_t slots[TELEMETRY_RING_SIZE];
+} telemetry_ring_t;
+
+/**
+ * @brief Empties the ring. Must not be called while the producer or consumer is active.
+ */
+void telemetry_ring_init(telemetry_ring_t *ring);
+
+/**
+ * @brief Adds a record (producer side). Never blocks.
+ * @return false if the ring was full and the record was dropped.
+ */
+bool telemetry_ring_push(telemetry_ring_t *ring, const telemetry_record_t *record);
+
+/**
+ * @brief Removes the oldest record (consumer side). Never blocks.
+ * @return false if the ring was empty.
+ */
+bool telemetry_ring_pop(telemetry_ring_t *ring, telemetry_record_t *record);
+
+/**
+ * @brief Number of records currently stored.
+ */
+uint32_t telemetry_ring_count(telemetry_ring_t *ring);
+
+#endif //header guard
@@ -1,5 +1,6 @@
 #include "trajectory_generator.h"
 #include <math.h>
+#include <string.h>
 
 //Constant definitions for trajectory generation
 
@@ -40,6 +41,17 @@ static float Bezier(float k1) {
     return k1_pow_5 * (R1 - (R2 * k1) + (R3 * k1_pow_2) - (R4 * k1_pow_3) + (R5 * k1_pow_4) - (R6 * k1_pow_5));
 }
 
+/**
+ * @brief Derivative of Bezier() with respect to k1, in closed form:
+ * k1^4 * (5 r1 - 6 r2 k1 + 7 r3 k1^2 - 8 r4 k1^3 + 9 r5 k1^4 - 10 r6 k1^5).
+ */
+static float BezierDerivative(float k1) {
+    float k1_pow_2 = k1 * k1;
+    float k1_pow_4 = k1_pow_2 * k1_pow_2;
+    return k1_pow_4 * ((5.0f * R1) - (6.0f * R2 * k1) + (7.0f * R3 * k1_pow_2) - (8.0f * R4 * k1_pow_2 * k1) +
+                       (9.0f * R5 * k1_pow_4) - (10.0f * R6 * k1_pow_4 * k1));
+}
+
 /**
  * @brief Calculates the reference speed in RPM for a given time 't'.
  * @param t_seconds The time elapsed since the start of the profile, in seconds.
@@ -113,4 +125,246 @@ float trajectory_get_reference_rpm(float t_seconds) {
 
     // --- Final Conversion to RPM ---
     return target_velocity_rad_s * RAD_S_TO_RPM * RPM_SCALING_FACTOR;
-}
\ No newline at end of file
+}
+
+float trajectory_get_reference_accel(float t_seconds) {
+    // Same markers as trajectory_get_reference_rpm(); only the ramps have a slope.
+    const float scale_factor = DESIRED_DURATION / ORIGINAL_DURATION;
+    const float time_markers[6] = {
+        (0.1f + ORIGINAL_SHIFT) * scale_factor,
+        (0.5f + ORIGINAL_SHIFT) * scale_factor,
+        (1.0f + ORIGINAL_SHIFT + ORIGINAL_ADJUSTMENT) * scale_factor,
+        (1.7f + ORIGINAL_SHIFT + ORIGINAL_ADJUSTMENT) * scale_factor,
+        (2.7f + ORIGINAL_SHIFT + ORIGINAL_ADJUSTMENT) * scale_factor,
+        (2.8f + ORIGINAL_SHIFT + ORIGINAL_ADJUSTMENT) * scale_factor
+    };
+    // Amplitude of each ramp in rad/s (ramp-up, ramp-down, ramp-up).
+    const float amplitude[3] = { KF_RAD_S, -KF_RAD_S * 0.5f, KF_RAD_S * 0.25f };
+
+    for (int r = 0; r < 3; r++) {
+        float t_begin = time_markers[2 * r];
+        float t_finish = time_markers[2 * r + 1];
+        if (t_seconds > t_begin && t_seconds <= t_finish) {
+            // d/dt = d/dk1 * dk1/dt
+            float duration = t_finish - t_begin;
+            float k1 = (t_seconds - t_begin) / duration;
+            return amplitude[r] * BezierDerivative(k1) / duration * RAD_S_TO_RPM * RPM_SCALING_FACTOR;
+        }
+    }
+    return 0.0f;
+}
+
+// ===================================================================
+// ===== COMPILED TRAJECTORIES =======================================
+
+void trajectory_init(trajectory_t *traj, float start_time) {
+    memset(traj, 0, sizeof(*traj));
+    traj->end_time = start_time;
+}
+
+/**
+ * @brief Appends a segment whose polynomial variable is zero at
+ * t_start + origin * duration.
+ */
+static bool trajectory_append(trajectory_t *traj, float duration, float origin,
+                              const float *coef, uint8_t degree) {
+    if (traj->count >= TRAJECTORY_MAX_SEGMENTS || degree > TRAJECTORY_MAX_DEGREE || !(duration > 0.0f)) {
+        return false;
+    }
+    trajectory_segment_t *seg = &traj->segments[traj->count++];
+    memset(seg, 0, sizeof(*seg));
+    seg->t_start = traj->end_time;
+    seg->t_end = traj->end_time + duration;
+    seg->t_origin = traj->end_time + origin * duration;
+    seg->inv_duration = 1.0f / duration;
+    seg->degree = degree;
+    for (uint8_t i = 0; i <= degree; i++) {
+        seg->coef[i] = coef[i];
+    }
+
+    // Speed at the end of the segment, x = 1 - origin.
+    const float x_end = 1.0f - origin;
+    float end_rpm = 0.0f;
+    for (int i = degree; i >= 0; i--) {
+        end_rpm = end_rpm * x_end + coef[i];
+    }
+    traj->end_time = seg->t_end;
+    traj->final_rpm = end_rpm;
+    return true;
+}
+
+bool trajectory_add_polynomial(trajectory_t *traj, float duration, const float *coef, uint8_t degree) {
+    return trajectory_append(traj, duration, 0.0f, coef, degree);
+}
+
+bool trajectory_add_hold(trajectory_t *traj, float duration, float rpm) {
+    return trajectory_add_polynomial(traj, duration, &rpm, 0);
+}
+
+bool trajectory_add_bezier(trajectory_t *traj, float duration, float from_rpm, float to_rpm) {
+    // Bezier(k) in powers of s = k - 1/2 (Taylor shift of R1..R6, in double).
+    // Around the midpoint the terms stay below 1, while the expansion in powers
+    // of k cancels terms of up to 1800 and loses about 0.3 RPM in single precision.
+    double shifted[TRAJECTORY_MAX_DEGREE + 1] = { 0.0, 0.0, 0.0, 0.0, 0.0, R1, -R2, R3, -R4, R5, -R6 };
+    for (int i = 0; i < TRAJECTORY_MAX_DEGREE; i++) {
+        for (int j = TRAJECTORY_MAX_DEGREE - 1; j >= i; j--) {
+            shifted[j] += 0.5 * shifted[j + 1];
+        }
+    }
+
+    const double delta = (double)to_rpm - (double)from_rpm;
+    float coef[TRAJECTORY_MAX_DEGREE + 1];
+    for (int i = 0; i <= TRAJECTORY_MAX_DEGREE; i++) {
+        coef[i] = (float)(delta * shifted[i]);
+    }
+    coef[0] = (float)((double)from_rpm + delta * shifted[0]);
+    return trajectory_append(traj, duration, 0.5f, coef, TRAJECTORY_MAX_DEGREE);
+}
+
+void trajectory_build_default(trajectory_t *traj) {
+    // Same breakpoints and levels as trajectory_get_reference_rpm().
+    const float scale_factor = DESIRED_DURATION / ORIGINAL_DURATION;
+    const float time_markers[6] = {
+        (0.1f + ORIGINAL_SHIFT) * scale_factor,
+        (0.5f + ORIGINAL_SHIFT) * scale_factor,
+        (1.0f + ORIGINAL_SHIFT + ORIGINAL_ADJUSTMENT) * scale_factor,
+        (1.7f + ORIGINAL_SHIFT + ORIGINAL_ADJUSTMENT) * scale_factor,
+        (2.7f + ORIGINAL_SHIFT + ORIGINAL_ADJUSTMENT) * scale_factor,
+        (2.8f + ORIGINAL_SHIFT + ORIGINAL_ADJUSTMENT) * scale_factor
+    };
+    const float to_rpm = RAD_S_TO_RPM * RPM_SCALING_FACTOR;
+    const float full = KF_RAD_S * to_rpm;
+
+    trajectory_init(traj, 0.0f);
+    trajectory_add_hold(traj, time_markers[0], 0.0f);
+    trajectory_add_bezier(traj, time_markers[1] - time_markers[0], 0.0f, full);
+    trajectory_add_hold(traj, time_markers[2] - time_markers[1], full);
+    trajectory_add_bezier(traj, time_markers[3] - time_markers[2], full, 0.5f * full);
+    trajectory_add_hold(traj, time_markers[4] - time_markers[3], 0.5f * full);
+    trajectory_add_bezier(traj, time_markers[5] - time_markers[4], 0.5f * full, 0.75f * full);
+    // Past the last marker the profile holds 75 % (final_rpm).
+}
+
+void trajectory_cursor_reset(trajectory_cursor_t *cursor) {
+    // An empty interval: the next evaluation searches from the first segment.
+    cursor->segment = 0;
+    cursor->t_lo = 0.0f;
+    cursor->t_hi = 0.0f;
+}
+
+/**
+ * @brief Finds the segment that holds 't', starting from the cursor.
+ * @return The segment index, or traj->count past the end.
+ */
+static uint8_t trajectory_seek(const trajectory_t *traj, trajectory_cursor_t *cursor, float t) {
+    uint8_t i = cursor->segment;
+    // Going back in time (e.g. after a reset): start over from the first segment.
+    if (i > traj->count || (i > 0 && t <= traj->segments[i - 1].t_end)) {
+        i = 0;
+    }
+    // Going forward: normally at most one step.
+    while (i < traj->count && t > traj->segments[i].t_end) {
+        i++;
+    }
+    cursor->segment = i;
+    cursor->t_lo = (i > 0) ? traj->segments[i - 1].t_end : -INFINITY;
+    cursor->t_hi = (i < traj->count) ? traj->segments[i].t_end : INFINITY;
+    return i;
+}
+
+/**
+ * @brief Evaluates one segment at time 't'.
+ * Estrin's scheme: the partial sums are independent, so the polynomial takes
+ * about four multiply-add latencies instead of the ten of Horner's rule.
+ * Unused coefficients are zero, so every degree goes through the same code.
+ */
+static float trajectory_segment_eval(const trajectory_segment_t *seg, float t) {
+    if (seg->degree == 0) {
+        return seg->coef[0];
+    }
+    if (t < seg->t_start) t = seg->t_start; // Before the first segment: hold its initial speed.
+    const float *c = seg->coef;
+    float x = (t - seg->t_origin) * seg->inv_duration;
+    float x2 = x * x;
+    float x4 = x2 * x2;
+    float x8 = x4 * x4;
+    float q0 = (c[0] + c[1] * x) + (c[2] + c[3] * x) * x2;
+    float q1 = (c[4] + c[5] * x) + (c[6] + c[7] * x) * x2;
+    float q2 = (c[8] + c[9] * x) + c[10] * x2;
+    return q0 + q1 * x4 + q2 * x8;
+}
+
+/**
+ * @brief Evaluates one segment and its first two derivatives at time 't'.
+ * Horner's rule carried through the derivatives; only used once per tick, so
+ * it does not need the latency tricks of trajectory_segment_eval().
+ */
+static void trajectory_segment_eval_point(const trajectory_segment_t *seg, float t, trajectory_point_t *point) {
+    if (seg->degree == 0 || t < seg->t_start) {
+        // Constant, or before the first segment where its initial speed is held.
+        point->rpm = trajectory_segment_eval(seg, t);
+        point->rpm_per_s = 0.0f;
+        point->rpm_per_s2 = 0.0f;
+        return;
+    }
+    float x = (t - seg->t_origin) * seg->inv_duration;
+    float p = seg->coef[seg->degree];
+    float dp = 0.0f;
+    float d2p = 0.0f;
+    for (int i = seg->degree - 1; i >= 0; i--) {
+        d2p = d2p * x + 2.0f * dp;
+        dp = dp * x + p;
+        p = p * x + seg->coef[i];
+    }
+    // dx/dt = inv_duration
+    point->rpm = p;
+    point->rpm_per_s = dp * seg->inv_duration;
+    point->rpm_per_s2 = d2p * seg->inv_duration * seg->inv_duration;
+}
+
+float trajectory_eval(const trajectory_t *traj, trajectory_cursor_t *cursor, float t_seconds) {
+    uint8_t i = cursor->segment;
+    // Still inside the segment of the previous call: no search at all.
+    if (!(t_seconds > cursor->t_lo && t_seconds <= cursor->t_hi)) {
+        i = trajectory_seek(traj, cursor, t_seconds);
+    }
+    if (i >= traj->count) {
+        return traj->final_rpm;
+    }
+    return trajectory_segment_eval(&traj->segments[i], t_seconds);
+}
+
+void trajectory_eval_point(const trajectory_t *traj, trajectory_cursor_t *cursor, float t_seconds,
+                           trajectory_point_t *point) {
+    uint8_t i = cursor->segment;
+    if (!(t_seconds > cursor->t_lo && t_seconds <= cursor->t_hi)) {
+        i = trajectory_seek(traj, cursor, t_seconds);
+    }
+    if (i >= traj->count) {
+        point->rpm = traj->final_rpm;
+        point->rpm_per_s = 0.0f;
+        point->rpm_per_s2 = 0.0f;
+        return;
+    }
+    trajectory_segment_eval_point(&traj->segments[i], t_seconds, point);
+}
+
+void trajectory_eval_batch(const trajectory_t *traj, trajectory_cursor_t *cursor,
+                           float t0, float dt, float *out, size_t n) {
+    size_t j = 0;
+    while (j < n) {
+        float t = t0 + (float)j * dt;
+        uint8_t i = trajectory_seek(traj, cursor, t);
+        if (i >= traj->count) {
+            for (; j < n; j++) out[j] = traj->final_rpm;
+            break;
+        }
+        // Every sample up to the end of this segment uses the same coefficients.
+        const trajectory_segment_t *seg = &traj->segments[i];
+        do {
+            out[j] = trajectory_segment_eval(seg, t);
+            j++;
+            t = t0 + (float)j * dt;
+        } while (j < n && t <= seg->t_end);
+    }
+}
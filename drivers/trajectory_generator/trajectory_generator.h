@@ -1,15 +1,145 @@
 #ifndef TRAJECTORY_GENERATOR_H //header guard
 #define TRAJECTORY_GENERATOR_H
 
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// --- Compiled Trajectory Limits ---
+#define TRAJECTORY_MAX_SEGMENTS 16
+// The 5th-order Bezier ramp is a polynomial of degree 10 in the segment progress.
+#define TRAJECTORY_MAX_DEGREE   10
+
+/**
+ * @brief One segment of a compiled trajectory: the speed is a polynomial of
+ * x = (t - t_origin) * inv_duration. Uploaded polynomials use the segment
+ * progress (t_origin = t_start, x from 0 to 1); Bezier ramps are centred on
+ * their midpoint (x from -0.5 to 0.5), where their coefficients are small.
+ */
+typedef struct {
+    float t_start;       // Start time (s); the end of the previous segment.
+    float t_end;         // End time (s); t_end itself belongs to this segment.
+    float t_origin;      // Time at which x = 0.
+    float inv_duration;  // 1 / (t_end - t_start)
+    uint8_t degree;      // Highest power of x in use.
+    float coef[TRAJECTORY_MAX_DEGREE + 1]; // Speed in RPM, coef[i] multiplies x^i (unused ones are 0).
+} trajectory_segment_t;
+
+/**
+ * @brief A speed profile compiled into polynomial segments. It is read-only
+ * once built, so several axes (and cores) can share one through their own cursors.
+ */
+typedef struct {
+    trajectory_segment_t segments[TRAJECTORY_MAX_SEGMENTS];
+    uint8_t count;
+    float end_time;      // End of the last segment (s).
+    float final_rpm;     // Speed held after the last segment.
+} trajectory_t;
+
+/**
+ * @brief Reference speed and its time derivatives at one instant.
+ */
+typedef struct {
+    float rpm;          // Reference speed [RPM]
+    float rpm_per_s;    // Acceleration, d(rpm)/dt [RPM/s]
+    float rpm_per_s2;   // Jerk, d2(rpm)/dt2 [RPM/s^2]
+} trajectory_point_t;
+
+/**
+ * @brief Position of one reader in a trajectory. Sequential evaluations only
+ * move it forward, so each one costs O(1); going back in time rescans.
+ * Reset it whenever it is used with a different trajectory.
+ */
+typedef struct {
+    uint8_t segment;  // Segment of the last evaluation (count = past the end).
+    float t_lo;       // Times in (t_lo, t_hi] stay in that segment.
+    float t_hi;
+} trajectory_cursor_t;
+
 /**
  * @brief Calculates the reference speed in RPM for a given time 't'.
  *
  * This function implements a scaled Bezier curve to generate a smooth
- * velocity profile over a predefined duration.
+ * velocity profile over a predefined duration. It is the reference
+ * implementation of the built-in profile; the control loop evaluates the
+ * compiled form (trajectory_build_default()).
  *
  * @param t_seconds The time elapsed since the start of the profile, in seconds.
  * @return float The calculated reference speed in Revolutions Per Minute (RPM).
  */
 float trajectory_get_reference_rpm(float t_seconds);
 
+/**
+ * @brief Acceleration of trajectory_get_reference_rpm() at time 't', from the
+ * closed-form derivative of the Bezier polynomial (reference implementation).
+ * @return The acceleration in RPM per second (0 on the holds).
+ */
+float trajectory_get_reference_accel(float t_seconds);
+
+/**
+ * @brief Empties a trajectory; the first segment will start at 'start_time'.
+ * Before the first segment the trajectory holds its initial speed.
+ */
+void trajectory_init(trajectory_t *traj, float start_time);
+
+/**
+ * @brief Appends a constant-speed segment.
+ * @return false if the trajectory is full or the duration is not positive.
+ */
+bool trajectory_add_hold(trajectory_t *traj, float duration, float rpm);
+
+/**
+ * @brief Appends a 5th-order Bezier ramp from 'from_rpm' to 'to_rpm'
+ * (zero slope and curvature at both ends).
+ * @return false if the trajectory is full or the duration is not positive.
+ */
+bool trajectory_add_bezier(trajectory_t *traj, float duration, float from_rpm, float to_rpm);
+
+/**
+ * @brief Appends a polynomial segment in the normalized progress k (0..1).
+ * @param coef The coefficients, coef[i] multiplies k^i, in RPM.
+ * @param degree Highest power (at most TRAJECTORY_MAX_DEGREE).
+ * @return false if the trajectory is full or the arguments are out of range.
+ */
+bool trajectory_add_polynomial(trajectory_t *traj, float duration, const float *coef, uint8_t degree);
+
+/**
+ * @brief Compiles the built-in 40 s profile of trajectory_get_reference_rpm().
+ */
+void trajectory_build_default(trajectory_t *traj);
+
+/**
+ * @brief Moves a cursor back to the first segment.
+ */
+void trajectory_cursor_reset(trajectory_cursor_t *cursor);
+
+/**
+ * @brief Evaluates the reference speed of a compiled trajectory.
+ * @param traj The trajectory.
+ * @param cursor The reader's cursor (updated).
+ * @param t_seconds Time along the trajectory.
+ * @return The reference speed in RPM.
+ */
+float trajectory_eval(const trajectory_t *traj, trajectory_cursor_t *cursor, float t_seconds);
+
+/**
+ * @brief Evaluates the reference speed of a compiled trajectory and its first
+ * two time derivatives, differentiated analytically from the segment
+ * polynomial. Before the first and after the last segment the speed is held,
+ * so both derivatives are zero there.
+ * @param traj The trajectory.
+ * @param cursor The reader's cursor (updated).
+ * @param t_seconds Time along the trajectory.
+ * @param point Speed, acceleration and jerk at 't_seconds'.
+ */
+void trajectory_eval_point(const trajectory_t *traj, trajectory_cursor_t *cursor, float t_seconds,
+                           trajectory_point_t *point);
+
+/**
+ * @brief Fills out[i] with the reference speed at t0 + i * dt (dt > 0).
+ * Consecutive samples in the same segment share one segment lookup.
+ */
+void trajectory_eval_batch(const trajectory_t *traj, trajectory_cursor_t *cursor,
+                           float t0, float dt, float *out, size_t n);
+
 #endif //header guard
\ No newline at end of file
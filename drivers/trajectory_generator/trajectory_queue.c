@@ -0,0 +1,150 @@
+#include "trajectory_queue.h"
+#include <string.h>
+
+void trajectory_queue_init(trajectory_queue_t *queue, const trajectory_t *base) {
+    memset(queue, 0, sizeof(*queue));
+    for (int i = 0; i < TRAJECTORY_QUEUE_BANKS; i++) {
+        atomic_init(&queue->state[i], TRAJECTORY_BANK_EMPTY);
+    }
+    queue->filling = -1;
+    queue->base = base;
+    queue->playing = TRAJECTORY_QUEUE_BASE;
+    trajectory_cursor_reset(&queue->cursor);
+}
+
+// ===================================================================
+// ===== PRODUCER (command task) =====================================
+
+trajectory_t *trajectory_queue_begin(trajectory_queue_t *queue) {
+    if (queue->filling < 0) {
+        // Only the producer moves a bank out of EMPTY, so a plain store is enough.
+        for (int i = 0; i < TRAJECTORY_QUEUE_BANKS; i++) {
+            if (atomic_load_explicit(&queue->state[i], memory_order_acquire) == TRAJECTORY_BANK_EMPTY) {
+                atomic_store_explicit(&queue->state[i], TRAJECTORY_BANK_FILLING, memory_order_relaxed);
+                queue->filling = (int8_t)i;
+                break;
+            }
+        }
+        if (queue->filling < 0) {
+            return NULL;
+        }
+    }
+    trajectory_t *bank = &queue->banks[queue->filling];
+    trajectory_init(bank, 0.0f);
+    return bank;
+}
+
+trajectory_t *trajectory_queue_filling(trajectory_queue_t *queue) {
+    return queue->filling < 0 ? NULL : &queue->banks[queue->filling];
+}
+
+bool trajectory_queue_commit(trajectory_queue_t *queue, bool replace) {
+    int8_t i = queue->filling;
+    if (i < 0 || queue->banks[i].count == 0) {
+        return false;
+    }
+    if (replace) {
+        // Banks still waiting are dropped; the consumer may be taking one right
+        // now, so the transition is a compare-and-swap on both sides.
+        for (int j = 0; j < TRAJECTORY_QUEUE_BANKS; j++) {
+            unsigned char expected = TRAJECTORY_BANK_READY;
+            if (j != i && atomic_compare_exchange_strong_explicit(&queue->state[j], &expected,
+                    TRAJECTORY_BANK_EMPTY, memory_order_acq_rel, memory_order_relaxed)) {
+                queue->stats.replaced++;
+            }
+        }
+    }
+    queue->seq[i] = queue->next_seq++;
+    queue->replace[i] = replace;
+    atomic_store_explicit(&queue->state[i], TRAJECTORY_BANK_READY, memory_order_release);
+    queue->filling = -1;
+    queue->stats.committed++;
+    return true;
+}
+
+// ===================================================================
+// ===== CONSUMER (control task) =====================================
+
+/**
+ * @brief The profile being played.
+ */
+static const trajectory_t *trajectory_queue_current(const trajectory_queue_t *queue) {
+    return queue->playing == TRAJECTORY_QUEUE_BASE ? queue->base : &queue->banks[queue->playing];
+}
+
+/**
+ * @brief Hands the playing bank back to the producer.
+ */
+static void trajectory_queue_release(trajectory_queue_t *queue) {
+    if (queue->playing != TRAJECTORY_QUEUE_BASE) {
+        atomic_store_explicit(&queue->state[queue->playing], TRAJECTORY_BANK_EMPTY, memory_order_release);
+    }
+}
+
+/**
+ * @brief The oldest READY bank, or -1.
+ */
+static int8_t trajectory_queue_oldest_ready(const trajectory_queue_t *queue) {
+    int8_t oldest = -1;
+    for (int i = 0; i < TRAJECTORY_QUEUE_BANKS; i++) {
+        if (atomic_load_explicit(&queue->state[i], memory_order_acquire) == TRAJECTORY_BANK_READY &&
+            (oldest < 0 || (int32_t)(queue->seq[i] - queue->seq[oldest]) < 0)) {
+            oldest = (int8_t)i;
+        }
+    }
+    return oldest;
+}
+
+void trajectory_queue_eval(trajectory_queue_t *queue, float t_seconds, trajectory_point_t *point) {
+    if (t_seconds < queue->last_t) {
+        // The run was reset: start over from the base profile.
+        trajectory_queue_release(queue);
+        queue->playing = TRAJECTORY_QUEUE_BASE;
+        queue->offset = 0.0f;
+        trajectory_cursor_reset(&queue->cursor);
+        queue->stats.restarts++;
+    }
+
+    const trajectory_t *current = trajectory_queue_current(queue);
+    const float end = queue->offset + current->end_time;
+
+    int8_t next = trajectory_queue_oldest_ready(queue);
+    if (next >= 0 && (queue->replace[next] || t_seconds > end)) {
+        unsigned char expected = TRAJECTORY_BANK_READY;
+        if (atomic_compare_exchange_strong_explicit(&queue->state[next], &expected, TRAJECTORY_BANK_PLAYING,
+                                                    memory_order_acquire, memory_order_relaxed)) {
+            // The bank is ours now; its flags are stable.
+            if (!queue->replace[next] && t_seconds <= end) {
+                // Re-committed in the meantime as a normal bank: not its turn yet.
+                atomic_store_explicit(&queue->state[next], TRAJECTORY_BANK_READY, memory_order_release);
+            } else {
+                float start = t_seconds;
+                if (!queue->replace[next]) {
+                    if (queue->last_t <= end) {
+                        start = end; // On time: continue exactly where the previous profile ended.
+                    } else {
+                        queue->stats.late++;
+                    }
+                }
+                trajectory_queue_release(queue);
+                queue->playing = next;
+                queue->offset = start;
+                trajectory_cursor_reset(&queue->cursor);
+                queue->stats.played++;
+                current = &queue->banks[next];
+            }
+        }
+    }
+
+    queue->last_t = t_seconds;
+    trajectory_eval_point(current, &queue->cursor, t_seconds - queue->offset, point);
+}
+
+uint32_t trajectory_queue_segment_key(const trajectory_queue_t *queue) {
+    // Every switch of profile bumps one of the two counters.
+    return ((queue->stats.played + queue->stats.restarts) << 8) | queue->cursor.segment;
+}
+
+void trajectory_queue_get_stats(const trajectory_queue_t *queue, trajectory_queue_stats_t *stats) {
+    *stats = queue->stats;
+}
@@ -0,0 +1,114 @@
+#ifndef TRAJECTORY_QUEUE_H //header guard
+#define TRAJECTORY_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "trajectory_generator.h"
+
+// --- Queue Configuration ---
+// Two banks of up to TRAJECTORY_MAX_SEGMENTS segments: the control loop plays
+// one while the host fills the other, so a profile of any length can be
+// streamed bank by bank.
+#define TRAJECTORY_QUEUE_BANKS 2
+
+// --- Bank States ---
+// EMPTY -> FILLING (producer) -> READY (producer) -> PLAYING (consumer) -> EMPTY (consumer)
+// A READY bank can also go back to EMPTY when the producer replaces it.
+#define TRAJECTORY_BANK_EMPTY   0
+#define TRAJECTORY_BANK_FILLING 1
+#define TRAJECTORY_BANK_READY   2
+#define TRAJECTORY_BANK_PLAYING 3
+
+// Index of the base profile in trajectory_queue_t.playing.
+#define TRAJECTORY_QUEUE_BASE   (-1)
+
+/**
+ * @brief Counters of the trajectory queue.
+ */
+typedef struct {
+    uint32_t committed;  // Banks published by the producer.
+    uint32_t played;     // Banks the consumer switched to.
+    uint32_t replaced;   // READY banks dropped by a later "replace" commit.
+    uint32_t late;       // Banks that started after the previous profile had ended.
+    uint32_t restarts;   // Times the time went back and the base profile restarted.
+} trajectory_queue_stats_t;
+
+/**
+ * @brief Double-buffered queue of trajectory banks between one producer (the
+ * command task) and one consumer (the control task).
+ *
+ * Ownership of a bank moves with its atomic state: the producer only writes a
+ * bank it moved to FILLING, the consumer only reads a bank it moved to PLAYING.
+ * Neither side ever waits for the other.
+ */
+typedef struct {
+    trajectory_t banks[TRAJECTORY_QUEUE_BANKS];
+    atomic_uchar state[TRAJECTORY_QUEUE_BANKS];
+    uint32_t seq[TRAJECTORY_QUEUE_BANKS];     // Commit order, written before READY.
+    bool replace[TRAJECTORY_QUEUE_BANKS];     // Start at once instead of after the current profile.
+
+    // Producer side
+    int8_t filling;                           // Bank being filled, or -1.
+    uint32_t next_seq;
+
+    // Consumer side
+    const trajectory_t *base;                 // Played at start and after a restart.
+    int8_t playing;                           // Bank being played, or TRAJECTORY_QUEUE_BASE.
+    float offset;                             // Time at which the playing profile starts.
+    float last_t;
+    trajectory_cursor_t cursor;
+
+    trajectory_queue_stats_t stats;           // Written by both sides, one field each.
+} trajectory_queue_t;
+
+/**
+ * @brief Empties the queue and starts the base profile at t = 0.
+ * Must not be called while the producer or consumer is active.
+ * @param base Profile played when nothing was streamed (it must stay valid).
+ */
+void trajectory_queue_init(trajectory_queue_t *queue, const trajectory_t *base);
+
+// --- Producer ---
+
+/**
+ * @brief Takes a free bank and empties it (restarts the bank being filled, if any).
+ * @return The bank to fill with trajectory_add_*(), or NULL if both banks are in use.
+ */
+trajectory_t *trajectory_queue_begin(trajectory_queue_t *queue);
+
+/**
+ * @brief The bank being filled, or NULL.
+ */
+trajectory_t *trajectory_queue_filling(trajectory_queue_t *queue);
+
+/**
+ * @brief Publishes the bank being filled.
+ * @param replace true to start it at the next evaluation (dropping any bank
+ * still waiting), false to start it when the current profile ends.
+ * @return false if no bank is being filled or it has no segments.
+ */
+bool trajectory_queue_commit(trajectory_queue_t *queue, bool replace);
+
+// --- Consumer ---
+
+/**
+ * @brief Reference speed and its derivatives at time 't_seconds' of the run.
+ * Switches to the next committed bank when the playing profile has ended (or
+ * at once for a "replace" bank). If the time goes back (a reset of the run),
+ * the playing bank is released and the base profile starts again.
+ */
+void trajectory_queue_eval(trajectory_queue_t *queue, float t_seconds, trajectory_point_t *point);
+
+/**
+ * @brief Identifies the segment of the last evaluation: the key changes
+ * whenever playback moves to another segment, bank or restart.
+ */
+uint32_t trajectory_queue_segment_key(const trajectory_queue_t *queue);
+
+/**
+ * @brief Copies the counters.
+ */
+void trajectory_queue_get_stats(const trajectory_queue_t *queue, trajectory_queue_stats_t *stats);
+
+#endif //header guard
@@ -0,0 +1,90 @@
+#include "axis_io_plant.h"
+#include <string.h>
+#include "motor_control.h"
+#include "encoder_reader.h"
+
+// Indexed by axis: create() hands out the slot of its axis.
+static axis_io_plant_t plant_pool[AXIS_IO_MAX_AXES];
+static motor_plant_params_t plant_params[AXIS_IO_MAX_AXES];
+static bool plant_params_set[AXIS_IO_MAX_AXES];
+static bool plant_created[AXIS_IO_MAX_AXES];
+
+static void plant_reset(void *instance) {
+    axis_io_plant_t *io = instance;
+    motor_plant_init(&io->plant, &io->params);
+    motor_plant_set_duty(&io->plant, DUTY_CYCLE_MIN);
+    encoder_filter_init(&io->filter, io->filter.filter_alpha, 0);
+    encoder_filter_set_duty(&io->filter, (float)io->plant.duty_pct);
+    io->started = false;
+}
+
+void axis_io_plant_init(axis_io_plant_t *io, const motor_plant_params_t *params, float filter_alpha) {
+    memset(io, 0, sizeof(*io));
+    io->params = *params;
+    io->filter.filter_alpha = filter_alpha;
+    plant_reset(io);
+}
+
+static void *plant_create(uint8_t axis, const axis_io_config_t *config) {
+    if (axis >= AXIS_IO_MAX_AXES) {
+        return NULL;
+    }
+    if (!plant_params_set[axis]) {
+        motor_plant_default_params(&plant_params[axis]);
+    }
+    axis_io_plant_init(&plant_pool[axis], &plant_params[axis], config->filter_alpha);
+#if ENCODER_OBSERVER
+    // As encoder_init_axis() does on the device
+    const encoder_observer_model_t model = ENCODER_OBSERVER_MODEL;
+    encoder_filter_setup_observer(&plant_pool[axis].filter, &model, config->period_ms);
+#endif
+    plant_created[axis] = true;
+    return &plant_pool[axis];
+}
+
+static float plant_read_rpm(void *instance, uint32_t period_ms) {
+    axis_io_plant_t *io = instance;
+    io->window = (encoder_window_t){ .delta_time_ms = period_ms };
+    if (io->started) {
+        io->window.pulses = motor_plant_advance(&io->plant, period_ms / 1000.0);
+    }
+    io->started = true;
+    return encoder_filter_step(&io->filter, &io->window, false);
+}
+
+static float plant_set_duty(void *instance, float percentage) {
+    axis_io_plant_t *io = instance;
+    float applied = (float)motor_plant_set_duty(&io->plant, percentage);
+    encoder_filter_set_duty(&io->filter, applied);
+    return applied;
+}
+
+const axis_io_ops_t axis_io_plant = {
+    .name = "plant",
+    .create = plant_create,
+    .reset = plant_reset,
+    .read_rpm = plant_read_rpm,
+    .set_duty = plant_set_duty,
+};
+
+void axis_io_plant_set_params(uint8_t axis, const motor_plant_params_t *params) {
+    if (axis < AXIS_IO_MAX_AXES) {
+        plant_params[axis] = *params;
+        plant_params_set[axis] = true;
+    }
+}
+
+axis_io_plant_t *axis_io_plant_instance(uint8_t axis) {
+    return axis < AXIS_IO_MAX_AXES && plant_created[axis] ? &plant_pool[axis] : NULL;
+}
+
+// --- encoder_reader accessors, served from the pool ---
+void encoder_get_window(uint8_t axis_id, encoder_window_t *window) {
+    axis_io_plant_t *io = axis_io_plant_instance(axis_id);
+    *window = io != NULL ? io->window : (encoder_window_t){ 0 };
+}
+
+void encoder_get_filter(uint8_t axis_id, encoder_filter_t *filter) {
+    axis_io_plant_t *io = axis_io_plant_instance(axis_id);
+    *filter = io != NULL ? io->filter : (encoder_filter_t){ 0 };
+}
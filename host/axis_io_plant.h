@@ -0,0 +1,55 @@
+#ifndef AXIS_IO_PLANT_H //header guard
+#define AXIS_IO_PLANT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "axis_io.h"
+#include "motor_plant.h"
+#include "encoder_filter.h"
+
+/*
+ * axis_io backend on the DC motor model of motor_plant.c (host builds only).
+ * read_rpm() integrates the plant over the period with the duty cycle set at
+ * the end of the previous one, then filters the counted pulses with the
+ * count-based estimate of encoder_get_rpm_axis() (encoder_filter_step()
+ * without M/T: the plant has no edge timestamps). The first read of a run returns
+ * the (zero) speed before any time has passed. set_duty() passes the applied
+ * duty cycle to the filter, for its observer if it has one.
+ *
+ * The backend also provides encoder_get_window() and encoder_get_filter() of
+ * encoder_reader.h for the pool instances, so code that records the encoder
+ * input (main/session_record.c) runs on the plant as well.
+ */
+
+/**
+ * @brief One simulated motor and its encoder filter.
+ */
+typedef struct {
+    motor_plant_t plant;
+    motor_plant_params_t params;   // Restored by reset()
+    encoder_filter_t filter;
+    encoder_window_t window;       // Input of the last read
+    bool started;                  // false until the first read of a run
+} axis_io_plant_t;
+
+extern const axis_io_ops_t axis_io_plant;
+
+/**
+ * @brief Sets up a caller-owned instance (for runs that must not share the
+ * static pool, e.g. concurrent simulations). Pass it to the axis_io_plant
+ * functions as the instance.
+ */
+void axis_io_plant_init(axis_io_plant_t *io, const motor_plant_params_t *params, float filter_alpha);
+
+/**
+ * @brief Motor parameters the next create() for 'axis' will use (the
+ * default motor otherwise).
+ */
+void axis_io_plant_set_params(uint8_t axis, const motor_plant_params_t *params);
+
+/**
+ * @brief The instance create() handed out for 'axis', or NULL.
+ */
+axis_io_plant_t *axis_io_plant_instance(uint8_t axis);
+
+#endif //header guard
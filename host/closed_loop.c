@@ -0,0 +1,135 @@
+#include "closed_loop.h"
+#include <string.h>
+#include <math.h>
+#include "trajectory_generator.h"
+#include "motor_control.h"
+#include "encoder_reader.h"
+#include "axis_io_plant.h"
+
+void closed_loop_default_config(closed_loop_config_t *config, int fuzzy) {
+    memset(config, 0, sizeof(*config));
+    config->fuzzy = fuzzy;
+    config->pid = simulink_control_P;
+    config->fuzzy_gains = PID_Difuso_P;
+    motor_plant_default_params(&config->plant);
+    config->filter_alpha = RPM_FILTER_ALPHA;
+    config->period_ms = CLOSED_LOOP_TS_MS;
+    config->seconds = CLOSED_LOOP_SECONDS;
+}
+
+void closed_loop_plant_feedforward(const motor_plant_params_t *plant, feedforward_params_t *feedforward) {
+    // V = (Ke + R b / Kt) w + R T_coulomb / Kt + (R J / Kt) dw/dt, with the
+    // inductance neglected (L / R is under a millisecond).
+    const double rpm_to_rad_s = 2.0 * M_PI / 60.0;
+    const double u_per_volt = 100.0 / (plant->supply_v * (DUTY_CYCLE_MAX - DUTY_CYCLE_MIN));
+    const double r_over_kt = plant->resistance / plant->kt;
+    feedforward->ks = (float)(r_over_kt * plant->coulomb * u_per_volt - DUTY_CYCLE_MIN / (DUTY_CYCLE_MAX - DUTY_CYCLE_MIN));
+    feedforward->kv = (float)((plant->ke + r_over_kt * plant->viscous) * rpm_to_rad_s * u_per_volt);
+    feedforward->ka = (float)(r_over_kt * plant->inertia * rpm_to_rad_s * u_per_volt);
+}
+
+void closed_loop_run(const closed_loop_config_t *config, closed_loop_result_t *result,
+                     closed_loop_sample_cb_t on_sample, void *arg) {
+    // --- Controller instances owned by this run ---
+    P_simulink_control_T pid_P = config->pid;
+    DW_simulink_control_T pid_DW;
+    ExtU_simulink_control_T pid_U;
+    ExtY_simulink_control_T pid_Y;
+    RT_MODEL_simulink_control_T pid_M = { &pid_P, &pid_DW, &pid_U, &pid_Y };
+
+    P_PID_Difuso_T fuzzy_P = config->fuzzy_gains;
+    DW_PID_Difuso_T fuzzy_DW;
+    ExtU_PID_Difuso_T fuzzy_U;
+    ExtY_PID_Difuso_T fuzzy_Y;
+    RT_MODEL_PID_Difuso_T fuzzy_M = { NULL, &fuzzy_P, &fuzzy_DW, &fuzzy_U, &fuzzy_Y };
+
+    const int period_ms = config->period_ms;
+    simulink_control_discretize_r(&pid_M, (real_T)period_ms / (real_T)1000.0);
+    simulink_control_initialize_r(&pid_M);
+    PID_Difuso_discretize_r(&fuzzy_M, (real_T)period_ms / (real_T)1000.0);
+    PID_Difuso_initialize_r(&fuzzy_M);
+
+    trajectory_t profile;
+    trajectory_cursor_t cursor;
+    trajectory_build_default(&profile);
+    trajectory_cursor_reset(&cursor);
+
+    // The motor and its encoder, behind the same interface as on the device.
+    axis_io_plant_t io_plant;
+    axis_io_plant_init(&io_plant, &config->plant, config->filter_alpha);
+    if (config->observer != NULL) {
+        encoder_filter_setup_observer(&io_plant.filter, config->observer, (uint32_t)period_ms);
+    }
+    const axis_io_ops_t *io = &axis_io_plant;
+
+    const double dt_s = period_ms / 1000.0;
+    long steps = (long)(config->seconds * 1000.0 / period_ms + 0.5);
+    double sum_squared_error = 0.0, sum_squared_true_error = 0.0;
+    long sample_count = 0;
+    double iae = 0.0, overshoot = 0.0, effort = 0.0;
+    float last_u_k = 0.0f;
+    metrics_reset(&result->metrics, (float)dt_s);
+
+    for (long k = 0; k < steps; k++) {
+        telemetry_sample_t sample;
+        float t_seconds = (float)(k * period_ms) / 1000.0f;
+        trajectory_point_t reference;
+        trajectory_eval_point(&profile, &cursor, t_seconds, &reference);
+        float reference_rpm = reference.rpm;
+
+        float measured_rpm = io->read_rpm(&io_plant, period_ms);
+
+        float error = reference_rpm - measured_rpm;
+        if (t_seconds <= 40.0f) {
+            sum_squared_error += (double)error * error;
+            double true_error = reference_rpm - motor_plant_rpm(&io_plant.plant);
+            sum_squared_true_error += true_error * true_error;
+            sample_count++;
+        }
+        iae += fabs(error) * dt_s;
+        metrics_update(&result->metrics, t_seconds, reference_rpm, reference.rpm_per_s, measured_rpm, cursor.segment);
+
+        float u_k;
+        if (config->fuzzy) {
+            fuzzy_U.error_signal = error;
+            PID_Difuso_step_r(&fuzzy_M);
+            u_k = fuzzy_Y.out / fuzzy_P.OUT_RANGE;
+            sample.state[0] = fuzzy_DW.DiscreteTimeIntegrator_DSTATE;
+            sample.state[1] = fuzzy_DW.UD_DSTATE;
+        } else {
+            pid_U.error_signal = error;
+            simulink_control_step_r(&pid_M);
+            u_k = pid_Y.u_k;
+            sample.state[0] = pid_DW.Integrator_DSTATE;
+            sample.state[1] = pid_DW.FilterDifferentiatorTF_states;
+        }
+        u_k += feedforward_output(&config->feedforward, reference_rpm, reference.rpm_per_s);
+        if (u_k > 1.0f) u_k = 1.0f;
+        if (u_k < 0.0f) u_k = 0.0f;
+
+        // With u_k at 0 the motor still runs at DUTY_CYCLE_MIN, so any excess
+        // over the reference there is the duty floor, not an overshoot.
+        double excess = motor_plant_rpm(&io_plant.plant) - reference_rpm;
+        if (u_k > 0.0f && excess > overshoot) overshoot = excess;
+        effort += fabsf(u_k - last_u_k);
+        last_u_k = u_k;
+
+        io->set_duty(&io_plant, DUTY_CYCLE_MIN + (u_k * (DUTY_CYCLE_MAX - DUTY_CYCLE_MIN)));
+
+        if (on_sample != NULL) {
+            sample.timestamp_us = (uint32_t)(k * period_ms * 1000);
+            sample.reference_rpm = reference_rpm;
+            sample.measured_rpm = measured_rpm;
+            sample.error = error;
+            sample.u_k = u_k;
+            on_sample(&sample, arg);
+        }
+    }
+
+    result->mse = sample_count > 0 ? sum_squared_error / sample_count : 0.0;
+    result->true_mse = sample_count > 0 ? sum_squared_true_error / sample_count : 0.0;
+    result->iae = iae;
+    result->overshoot = overshoot;
+    result->effort = effort;
+    result->samples = steps;
+}
@@ -0,0 +1,81 @@
+#ifndef CLOSED_LOOP_H //header guard
+#define CLOSED_LOOP_H
+
+#include "simulink_control.h"
+#include "PID_Difuso.h"
+#include "telemetry.h"
+#include "motor_plant.h"
+#include "feedforward.h"
+#include "metrics.h"
+#include "encoder_filter.h"
+
+/*
+ * One closed-loop run of the firmware's control step (see axis_step() in
+ * main/axis_control.c) against the motor_plant model: Bezier reference from
+ * trajectory_generator, count-based EMA speed as in encoder_get_rpm() (or
+ * its speed observer), one controller instance plus the reference
+ * feedforward, u_k clamped to [0, 1] and mapped to the duty range.
+ * Every call owns its own controller instance and plant, so runs can be
+ * executed concurrently.
+ */
+
+#define CLOSED_LOOP_TS_MS     10
+#define CLOSED_LOOP_SECONDS   40.0
+
+/**
+ * @brief What to simulate.
+ */
+typedef struct {
+    int fuzzy;                       // 0 = simulink_control, 1 = PID_Difuso
+    P_simulink_control_T pid;        // Gains of the conventional PID
+    P_PID_Difuso_T fuzzy_gains;      // Gains of the fuzzy PID
+    motor_plant_params_t plant;      // Motor model
+    feedforward_params_t feedforward; // Reference feedforward (all zero = off)
+    float filter_alpha;              // RPM EMA smoothing factor
+    const encoder_observer_model_t *observer; // Speed observer instead of the EMA (NULL = EMA)
+    int period_ms;                   // Control period (the controllers are discretized for it)
+    double seconds;                  // Length of the run
+} closed_loop_config_t;
+
+/**
+ * @brief Result of a run.
+ */
+typedef struct {
+    double mse;        // Mean squared error of the filtered speed, as MSE_RESULT on the device
+    double true_mse;   // The same for the true speed of the plant (does not depend on the speed estimate)
+    double iae;        // Integral of |error| over the run [RPM s]
+    double overshoot;  // Largest excess of the true speed over the reference, outside the duty floor [RPM]
+    double effort;     // Total variation of u_k, sum |u_k - u_k-1| (actuator activity)
+    long samples;      // Control steps simulated
+    metrics_t metrics; // Per-segment and whole-run metrics, as the device computes them
+} closed_loop_result_t;
+
+/**
+ * @brief Called once per control step with the sample the device would send.
+ */
+typedef void (*closed_loop_sample_cb_t)(telemetry_sample_t *sample, void *arg);
+
+/**
+ * @brief Fills a configuration with the firmware defaults (gains of the global
+ * controller instances, default motor, RPM_FILTER_ALPHA, CLOSED_LOOP_TS_MS, 40 s).
+ */
+void closed_loop_default_config(closed_loop_config_t *config, int fuzzy);
+
+/**
+ * @brief Feedforward gains of an ideal model of a motor: the steady-state
+ * voltage (back-EMF, viscous and Coulomb friction) and the torque that
+ * accelerates the inertia, converted to u_k through the duty range.
+ */
+void closed_loop_plant_feedforward(const motor_plant_params_t *plant, feedforward_params_t *feedforward);
+
+/**
+ * @brief Simulates one run.
+ * @param config What to simulate.
+ * @param result Metrics of the run.
+ * @param on_sample Optional per-step callback (may be NULL).
+ * @param arg Forwarded to on_sample.
+ */
+void closed_loop_run(const closed_loop_config_t *config, closed_loop_result_t *result,
+                     closed_loop_sample_cb_t on_sample, void *arg);
+
+#endif //header guard
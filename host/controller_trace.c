@@ -0,0 +1,133 @@
+/*
+ * File: controller_trace.c
+ *
+ * Purpose: Runs one controller in closed loop against a first-order speed
+ * model (the SIMULATE_ENCODER model from main.c with a gain large enough to
+ * reach the whole Bezier profile) for the full 40 s trajectory, and reports the
+ * cost of the controller step. The same source is built twice: against the
+ * default double-precision controllers (controller_trace) and against the
+ * CONTROL_SINGLE_PRECISION=1 build (controller_trace_f32).
+ *
+ * Usage:
+ *   controller_trace     <pid|fuzzy> <trace.bin>          write the reference trace
+ *   controller_trace_f32 <pid|fuzzy> --compare <trace.bin> compare against it
+ *
+ * In compare mode the process exits with 1 if u_k or the simulated speed drift
+ * further from the reference trace than the bounds below.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "simulink_control.h"
+#include "PID_Difuso.h"
+#include "trajectory_generator.h"
+
+#define TS_MS          10
+#define STEPS          4000 // RUN_SECONDS at TS_MS
+
+// --- Divergence bounds for the single-precision build ---
+#define MAX_U_K_DIFF   1e-3   // Normalized control signal (0..1)
+#define MAX_RPM_DIFF   0.5    // Simulated speed
+
+typedef struct {
+    double u_k;
+    double rpm;
+} trace_point_t;
+
+static uint64_t cycles_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static double controller_step(int fuzzy, double error) {
+    if (fuzzy) {
+        PID_Difuso_U.error_signal = error;
+        PID_Difuso_step();
+        return PID_Difuso_Y.out / PID_Difuso_P.OUT_RANGE;
+    }
+    simulink_control_U.error_signal = error;
+    simulink_control_step();
+    return simulink_control_Y.u_k;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <pid|fuzzy> <trace.bin> | <pid|fuzzy> --compare <trace.bin>\n", argv[0]);
+        return 2;
+    }
+    int fuzzy = strcmp(argv[1], "fuzzy") == 0;
+    int compare = strcmp(argv[2], "--compare") == 0 && argc > 3;
+    const char *path = compare ? argv[3] : argv[2];
+
+    static trace_point_t trace[STEPS];
+    uint64_t step_cycles = 0;
+    double rpm = 0.0;
+
+    simulink_control_initialize();
+    PID_Difuso_initialize();
+
+    for (int k = 0; k < STEPS; k++) {
+        double reference = trajectory_get_reference_rpm(k * TS_MS / 1000.0f);
+
+        uint64_t c0 = cycles_now();
+        double u_k = controller_step(fuzzy, reference - rpm);
+        step_cycles += cycles_now() - c0;
+
+        if (u_k > 1.0) u_k = 1.0;
+        if (u_k < 0.0) u_k = 0.0;
+        rpm = 0.95 * rpm + 75.0 * u_k;
+        trace[k].u_k = u_k;
+        trace[k].rpm = rpm;
+    }
+
+    printf("%s (real_T = %s): %.1f %s/step\n", fuzzy ? "fuzzy" : "pid",
+           sizeof(real_T) == sizeof(float) ? "float" : "double",
+           (double)step_cycles / STEPS,
+#if defined(__x86_64__) || defined(__i386__)
+           "cycles"
+#else
+           "ns"
+#endif
+           );
+
+    FILE *f = fopen(path, compare ? "rb" : "wb");
+    if (f == NULL) {
+        perror(path);
+        return 2;
+    }
+    if (!compare) {
+        fwrite(trace, sizeof(trace_point_t), STEPS, f);
+        fclose(f);
+        return 0;
+    }
+
+    static trace_point_t ref[STEPS];
+    size_t n = fread(ref, sizeof(trace_point_t), STEPS, f);
+    fclose(f);
+    if (n != STEPS) {
+        fprintf(stderr, "%s: expected %d points, got %zu\n", path, STEPS, n);
+        return 2;
+    }
+
+    double max_u = 0.0, max_rpm = 0.0;
+    for (int k = 0; k < STEPS; k++) {
+        max_u = fmax(max_u, fabs(trace[k].u_k - ref[k].u_k));
+        max_rpm = fmax(max_rpm, fabs(trace[k].rpm - ref[k].rpm));
+    }
+    int ok = max_u <= MAX_U_K_DIFF && max_rpm <= MAX_RPM_DIFF;
+    printf("max |du_k| = %.3g (bound %.3g), max |drpm| = %.3g (bound %.3g): %s\n",
+           max_u, MAX_U_K_DIFF, max_rpm, MAX_RPM_DIFF, ok ? "OK" : "FAIL");
+    return ok ? 0 : 1;
+}
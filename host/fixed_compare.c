@@ -0,0 +1,111 @@
+/*
+ * File: fixed_compare.c
+ *
+ * Purpose: Runs the fixed-point controller kernels and the floating-point
+ * controllers side by side over the full 40 s Bezier profile and compares the
+ * resulting trajectories. Each pipeline drives its own copy of a first-order
+ * speed model (as in controller_trace.c) whose speed is quantized into whole
+ * encoder pulses per tick, exactly what encoder_get_rpm() would count.
+ *
+ *  - floating point: pulses -> EMA in RPM -> simulink_control / PID_Difuso
+ *  - fixed point:    pulses -> *_fixed_step() (integer EMA + controller)
+ *
+ * The process exits with 1 if the speed or u_k trajectories of the two
+ * pipelines differ by more than the bounds below.
+ *
+ * Usage: fixed_compare [pid|fuzzy|all]
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "fixed_point.h"
+#include "simulink_control.h"
+#include "simulink_control_fixed.h"
+#include "PID_Difuso.h"
+#include "PID_Difuso_fixed.h"
+#include "trajectory_generator.h"
+
+#define TS_MS 10
+#define STEPS 4000 // 40 s
+#define RPM_FILTER_ALPHA 0.1
+
+// --- Bounds on the fixed-point vs floating-point trajectories ---
+#define MAX_RPM_DIFF 8.0    // About two encoder counts per tick
+#define MAX_U_K_DIFF 0.03
+
+/**
+ * @brief First-order speed model with encoder quantization.
+ */
+typedef struct {
+    double rpm;       // True speed
+    double position;  // Accumulated encoder counts (fractional)
+} plant_t;
+
+static int32_t plant_step(plant_t *p, double u_k) {
+    p->rpm = 0.95 * p->rpm + 75.0 * u_k;
+    double before = floor(p->position);
+    p->position += p->rpm / FX_RPM_PER_COUNT;
+    return (int32_t)(floor(p->position) - before);
+}
+
+static int run(int fuzzy) {
+    plant_t plant_float = {0}, plant_fixed = {0};
+    int32_t pulses_float = 0, pulses_fixed = 0;
+    double filtered_rpm = 0.0;
+    double max_rpm = 0.0, max_u = 0.0, sse_float = 0.0, sse_fixed = 0.0;
+    DW_simulink_control_fixed_T pid_dw;
+    DW_PID_Difuso_fixed_T fuzzy_dw;
+
+    simulink_control_initialize();
+    PID_Difuso_initialize();
+    simulink_control_fixed_initialize(&pid_dw);
+    PID_Difuso_fixed_initialize(&fuzzy_dw);
+
+    for (int k = 0; k < STEPS; k++) {
+        double reference = trajectory_get_reference_rpm(k * TS_MS / 1000.0f);
+
+        // --- Floating-point pipeline ---
+        filtered_rpm = RPM_FILTER_ALPHA * pulses_float * FX_RPM_PER_COUNT + (1.0 - RPM_FILTER_ALPHA) * filtered_rpm;
+        double u_float;
+        if (fuzzy) {
+            PID_Difuso_U.error_signal = reference - filtered_rpm;
+            PID_Difuso_step();
+            u_float = PID_Difuso_Y.out / PID_Difuso_P.OUT_RANGE;
+        } else {
+            simulink_control_U.error_signal = reference - filtered_rpm;
+            simulink_control_step();
+            u_float = simulink_control_Y.u_k;
+        }
+        u_float = fmin(fmax(u_float, 0.0), 1.0);
+
+        // --- Fixed-point pipeline ---
+        int32_t reference_q16 = FX_Q16(reference / FX_RPM_PER_COUNT);
+        int16_t u_q15 = fuzzy ? PID_Difuso_fixed_step(&fuzzy_dw, reference_q16, pulses_fixed)
+                              : simulink_control_fixed_step(&pid_dw, reference_q16, pulses_fixed);
+        double u_fixed = u_q15 / (double)FX_Q15_ONE;
+
+        pulses_float = plant_step(&plant_float, u_float);
+        pulses_fixed = plant_step(&plant_fixed, u_fixed);
+
+        max_rpm = fmax(max_rpm, fabs(plant_float.rpm - plant_fixed.rpm));
+        max_u = fmax(max_u, fabs(u_float - u_fixed));
+        sse_float += (reference - plant_float.rpm) * (reference - plant_float.rpm);
+        sse_fixed += (reference - plant_fixed.rpm) * (reference - plant_fixed.rpm);
+    }
+
+    int ok = max_rpm <= MAX_RPM_DIFF && max_u <= MAX_U_K_DIFF;
+    printf("%-5s: tracking MSE float=%.2f fixed=%.2f | max |drpm|=%.3f (bound %.1f) max |du_k|=%.4f (bound %.2f): %s\n",
+           fuzzy ? "fuzzy" : "pid", sse_float / STEPS, sse_fixed / STEPS,
+           max_rpm, MAX_RPM_DIFF, max_u, MAX_U_K_DIFF, ok ? "OK" : "FAIL");
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    const char *which = (argc > 1) ? argv[1] : "all";
+    int ok = 1;
+    if (strcmp(which, "fuzzy") != 0) ok &= run(0);
+    if (strcmp(which, "pid") != 0) ok &= run(1);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,64 @@
+/*
+ * File: fuzzy_surface_check.c
+ *
+ * Purpose: Compares the precomputed fuzzy control surface used by
+ * PID_Difuso_step() against the original inference engine. Random points are
+ * drawn over (and slightly beyond) both universes of discourse; the maximum and
+ * mean absolute deviation are reported together with the cost of each path.
+ * The process exits with 1 if the deviation exceeds the stated tolerance.
+ *
+ * Usage: fuzzy_surface_check [samples]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "PID_Difuso.h"
+
+// Tolerances documented next to PID_Difuso_SURF_NE in PID_Difuso.h.
+#define TOLERANCE_PLANE   0.75
+#define TOLERANCE_DE_ZERO 0.08
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static double uniform(double lo, double hi) {
+    return lo + (hi - lo) * ((double)rand() / RAND_MAX);
+}
+
+int main(int argc, char **argv) {
+    int samples = (argc > 1) ? atoi(argv[1]) : 200000;
+    double max_err = 0.0, max_err_de0 = 0.0, sum_err = 0.0;
+    volatile double sink = 0.0;
+
+    PID_Difuso_initialize();
+    srand(1);
+
+    for (int i = 0; i < samples; i++) {
+        double e = uniform(-1300.0, 1300.0);
+        double de = uniform(-11.0, 11.0);
+        double err = fabs(PID_Difuso_fuzzy_surface(e, de) - PID_Difuso_fuzzy_reference(e, de));
+        double err_de0 = fabs(PID_Difuso_fuzzy_surface(e, 0.0) - PID_Difuso_fuzzy_reference(e, 0.0));
+        sum_err += err;
+        if (err > max_err) max_err = err;
+        if (err_de0 > max_err_de0) max_err_de0 = err_de0;
+    }
+
+    // Timing of both paths over the same inputs
+    double t0 = now_ns();
+    for (int i = 0; i < samples; i++) sink += PID_Difuso_fuzzy_reference(-1200.0 + i % 2400, 0.0);
+    double t1 = now_ns();
+    for (int i = 0; i < samples; i++) sink += PID_Difuso_fuzzy_surface(-1200.0 + i % 2400, 0.0);
+    double t2 = now_ns();
+
+    printf("surface %dx%d: max_err=%.4f mean_err=%.4f max_err_de0=%.4f (output range 0..60)\n",
+           PID_Difuso_SURF_NE, PID_Difuso_SURF_NDE, max_err, sum_err / samples, max_err_de0);
+    printf("reference: %.1f ns/call, surface: %.1f ns/call\n",
+           (t1 - t0) / samples, (t2 - t1) / samples);
+
+    return (max_err <= TOLERANCE_PLANE && max_err_de0 <= TOLERANCE_DE_ZERO) ? 0 : 1;
+}
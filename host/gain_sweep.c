@@ -0,0 +1,273 @@
+/*
+ * File: gain_sweep.c
+ *
+ * Purpose: Offline tuning of the controller gains. Every combination of the
+ * requested gain ranges is simulated over the 40 s Bezier profile with
+ * closed_loop_run() (DC motor model + unmodified controller sources). The
+ * runs are spread over a pool of worker threads, one per core by default,
+ * and the parameter sets are ranked by one of the metrics:
+ *
+ *   mse       mean squared error of the filtered speed (MSE_RESULT on the device)
+ *   iae       integral of |error| [RPM s]
+ *   overshoot largest excess of the speed over the reference [RPM]
+ *   effort    total variation of u_k
+ *
+ * Usage:
+ *   gain_sweep pid   [--kp lo:hi:n] [--ki lo:hi:n] [--kd lo:hi:n] [--n lo:hi:n]
+ *   gain_sweep fuzzy [--kp lo:hi:n] [--ki lo:hi:n] [--kd lo:hi:n]
+ *              [--sort mse|iae|overshoot|effort] [--top K] [--threads T] [--csv out.csv] [--ff] [--observer]
+ *
+ * --ff adds the reference feedforward with the gains of the ideal motor model,
+ * so the sweep finds the feedback gains that only correct its residuals.
+ * --observer measures the speed with the observer of encoder_filter.h
+ * (ENCODER_OBSERVER_MODEL) instead of the EMA.
+ *
+ * A range "lo:hi:n" takes n evenly spaced values; a single number fixes the gain.
+ * Gains that are not given keep their firmware defaults.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include "closed_loop.h"
+#include "encoder_reader.h"
+
+#define MAX_VALUES 64
+
+/**
+ * @brief Values taken by one gain.
+ */
+typedef struct {
+    double values[MAX_VALUES];
+    int count;
+} sweep_axis_t;
+
+/**
+ * @brief One parameter set and its metrics.
+ */
+typedef struct {
+    double gains[4];  // Kp, Ki, Kd, N (N unused by the fuzzy PID)
+    closed_loop_result_t result;
+} sweep_job_t;
+
+// --- Work Queue ---
+// Jobs are claimed with an atomic counter, so the workers need no lock.
+static sweep_job_t *jobs;
+static long job_count;
+static atomic_long next_job;
+static closed_loop_config_t base_config;
+static const encoder_observer_model_t observer_model = ENCODER_OBSERVER_MODEL;
+
+static const char *metric_names[] = { "mse", "iae", "overshoot", "effort" };
+static int sort_metric = 0;
+
+static int parse_axis(const char *spec, sweep_axis_t *axis) {
+    double lo, hi;
+    int n;
+    if (sscanf(spec, "%lf:%lf:%d", &lo, &hi, &n) == 3) {
+        if (n < 1 || n > MAX_VALUES) return 0;
+        for (int i = 0; i < n; i++) {
+            axis->values[i] = (n == 1) ? lo : lo + (hi - lo) * i / (n - 1);
+        }
+        axis->count = n;
+        return 1;
+    }
+    if (sscanf(spec, "%lf", &lo) == 1) {
+        axis->values[0] = lo;
+        axis->count = 1;
+        return 1;
+    }
+    return 0;
+}
+
+static void *sweep_worker(void *arg) {
+    (void)arg;
+    while (1) {
+        long i = atomic_fetch_add(&next_job, 1);
+        if (i >= job_count) break;
+
+        closed_loop_config_t config = base_config;
+        if (config.fuzzy) {
+            config.fuzzy_gains.KP = jobs[i].gains[0];
+            config.fuzzy_gains.KI = jobs[i].gains[1];
+            config.fuzzy_gains.KD = jobs[i].gains[2];
+        } else {
+            config.pid.Kp = jobs[i].gains[0];
+            config.pid.Ki = jobs[i].gains[1];
+            config.pid.Kd = jobs[i].gains[2];
+            config.pid.N = jobs[i].gains[3];
+        }
+        closed_loop_run(&config, &jobs[i].result, NULL, NULL);
+    }
+    return NULL;
+}
+
+static double metric_of(const sweep_job_t *job, int metric) {
+    switch (metric) {
+        case 1:  return job->result.iae;
+        case 2:  return job->result.overshoot;
+        case 3:  return job->result.effort;
+        default: return job->result.mse;
+    }
+}
+
+static int compare_jobs(const void *a, const void *b) {
+    double ma = metric_of((const sweep_job_t *)a, sort_metric);
+    double mb = metric_of((const sweep_job_t *)b, sort_metric);
+    return (ma > mb) - (ma < mb);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || (strcmp(argv[1], "pid") != 0 && strcmp(argv[1], "fuzzy") != 0)) {
+        fprintf(stderr, "usage: %s pid|fuzzy [--kp lo:hi:n] [--ki ..] [--kd ..] [--n ..] "
+                        "[--sort mse|iae|overshoot|effort] [--top K] [--threads T] [--csv file] [--ff] [--observer]\n", argv[0]);
+        return 2;
+    }
+    int fuzzy = strcmp(argv[1], "fuzzy") == 0;
+
+    // The fuzzy surface is built here, once, before any worker runs.
+    simulink_control_initialize();
+    PID_Difuso_initialize();
+    closed_loop_default_config(&base_config, fuzzy);
+
+    // --- Default grids around the firmware gains ---
+    sweep_axis_t axes[4];
+    if (fuzzy) {
+        parse_axis("0.05:2:8", &axes[0]);
+        parse_axis("0.25:8:8", &axes[1]);
+        parse_axis("0:0.4:3", &axes[2]);
+        parse_axis("0", &axes[3]);
+    } else {
+        parse_axis("0.004:0.032:8", &axes[0]);
+        parse_axis("0.5:4:8", &axes[1]);
+        parse_axis("0:0.02:5", &axes[2]);
+        axes[3].values[0] = base_config.pid.N;
+        axes[3].count = 1;
+    }
+
+    int top = 10;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *csv_path = NULL;
+    const char *gain_flags[] = { "--kp", "--ki", "--kd", "--n" };
+    for (int i = 2; i < argc; i++) {
+        int used = 0;
+        for (int g = 0; g < 4 && i + 1 < argc; g++) {
+            if (strcmp(argv[i], gain_flags[g]) == 0) {
+                if (!parse_axis(argv[++i], &axes[g])) {
+                    fprintf(stderr, "bad range for %s\n", gain_flags[g]);
+                    return 2;
+                }
+                used = 1;
+            }
+        }
+        if (used) continue;
+        if (strcmp(argv[i], "--sort") == 0 && i + 1 < argc) {
+            const char *name = argv[++i];
+            sort_metric = -1;
+            for (int m = 0; m < 4; m++) {
+                if (strcmp(name, metric_names[m]) == 0) sort_metric = m;
+            }
+            if (sort_metric < 0) {
+                fprintf(stderr, "unknown metric %s\n", name);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            top = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (strcmp(argv[i], "--ff") == 0) {
+            closed_loop_plant_feedforward(&base_config.plant, &base_config.feedforward);
+        } else if (strcmp(argv[i], "--observer") == 0) {
+            base_config.observer = &observer_model;
+        } else {
+            fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        }
+    }
+    if (threads < 1) threads = 1;
+
+    // --- Cartesian product of the gain values ---
+    job_count = (long)axes[0].count * axes[1].count * axes[2].count * axes[3].count;
+    jobs = calloc((size_t)job_count, sizeof(*jobs));
+    if (jobs == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    long j = 0;
+    for (int a = 0; a < axes[0].count; a++)
+        for (int b = 0; b < axes[1].count; b++)
+            for (int c = 0; c < axes[2].count; c++)
+                for (int d = 0; d < axes[3].count; d++, j++) {
+                    jobs[j].gains[0] = axes[0].values[a];
+                    jobs[j].gains[1] = axes[1].values[b];
+                    jobs[j].gains[2] = axes[2].values[c];
+                    jobs[j].gains[3] = axes[3].values[d];
+                }
+
+    // --- Thread pool ---
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    atomic_store(&next_job, 0);
+    // No more threads than runs. Only the threads that did start are joined;
+    // if none could be started the runs are done on this thread.
+    if (threads > job_count) threads = job_count;
+    long started = 0;
+    pthread_t *pool = malloc((size_t)threads * sizeof(*pool));
+    if (pool != NULL) {
+        for (; started < threads; started++) {
+            if (pthread_create(&pool[started], NULL, sweep_worker, NULL) != 0) {
+                fprintf(stderr, "could only start %ld of %ld threads\n", started, threads);
+                break;
+            }
+        }
+        for (long t = 0; t < started; t++) {
+            pthread_join(pool[t], NULL);
+        }
+        free(pool);
+    }
+    if (started == 0) {
+        sweep_worker(NULL);
+        started = 1;
+    }
+    threads = started;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double wall_s = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    qsort(jobs, (size_t)job_count, sizeof(*jobs), compare_jobs);
+
+    printf("%ld %s runs of %.0f s on %ld threads in %.2f s (%.0f runs/s), sorted by %s\n",
+           job_count, fuzzy ? "fuzzy" : "pid", base_config.seconds, threads, wall_s,
+           job_count / wall_s, metric_names[sort_metric]);
+    printf("%4s %10s %10s %10s %10s | %12s %10s %10s %8s\n",
+           "rank", "Kp", "Ki", "Kd", "N", "mse", "iae", "overshoot", "effort");
+    for (long i = 0; i < job_count && i < top; i++) {
+        const sweep_job_t *job = &jobs[i];
+        printf("%4ld %10.5g %10.5g %10.5g %10.5g | %12.2f %10.1f %10.1f %8.2f\n",
+               i + 1, job->gains[0], job->gains[1], job->gains[2], job->gains[3],
+               job->result.mse, job->result.iae, job->result.overshoot, job->result.effort);
+    }
+
+    if (csv_path != NULL) {
+        FILE *csv = fopen(csv_path, "w");
+        if (csv == NULL) {
+            perror(csv_path);
+            return 1;
+        }
+        fprintf(csv, "kp,ki,kd,n,mse,iae,overshoot,effort\n");
+        for (long i = 0; i < job_count; i++) {
+            const sweep_job_t *job = &jobs[i];
+            fprintf(csv, "%.9g,%.9g,%.9g,%.9g,%.6f,%.6f,%.6f,%.6f\n",
+                    job->gains[0], job->gains[1], job->gains[2], job->gains[3],
+                    job->result.mse, job->result.iae, job->result.overshoot, job->result.effort);
+        }
+        fclose(csv);
+    }
+    free(jobs);
+    return 0;
+}
@@ -0,0 +1,397 @@
+/*
+ * File: kernel_bench.c
+ *
+ * Purpose: Micro-benchmarks of the numeric kernels of the control loop, built
+ * natively from the unmodified sources. Every kernel is run over a table of
+ * precomputed inputs (so nothing folds into constants) and its results go to
+ * memory. The batch size is calibrated during a warm-up until one batch takes
+ * at least BATCH_MIN_NS. Then REPEATS batches are timed, and the median,
+ * minimum and spread in ns/call are reported.
+ *
+ * With --baseline the medians are compared against a stored file. The process
+ * exits with 1 if any kernel is slower than its baseline by more than the
+ * threshold. --write stores the current medians as a new baseline. Baselines
+ * are only comparable on the same machine and build type.
+ *
+ * Usage: kernel_bench [--baseline file] [--write file] [--threshold 0.25] [--filter name]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "simulink_control.h"
+#include "simulink_control_fixed.h"
+#include "PID_Difuso.h"
+#include "PID_Difuso_fixed.h"
+#include "trajectory_generator.h"
+#include "metrics.h"
+#include "capture_buffer.h"
+#include "encoder_reader.h"
+
+#define INPUTS       4096           // Power of two
+#define REPEATS      21
+#define BATCH_MIN_NS 2000000.0      // 2 ms per timed batch
+#define MAX_KERNELS  32
+
+// --- Inputs and results (shared by every kernel) ---
+static double errors[INPUTS];       // Controller error [RPM]
+static double fuzzy_e[INPUTS];      // Fuzzy surface inputs, over the whole universe
+static double fuzzy_de[INPUTS];
+static int32_t pulses[INPUTS];      // Encoder pulses per tick
+static float profile_t[INPUTS];     // Sequential times over the whole profile [s]
+static float ramp_t[INPUTS];        // Times inside the first ramp only [s]
+static double results[INPUTS];
+
+// --- Kernel state ---
+static P_simulink_control_T pid_P;
+static DW_simulink_control_T pid_DW;
+static ExtU_simulink_control_T pid_U;
+static ExtY_simulink_control_T pid_Y;
+static RT_MODEL_simulink_control_T pid_M = { &pid_P, &pid_DW, &pid_U, &pid_Y };
+
+static P_PID_Difuso_T fuzzy_P;
+static DW_PID_Difuso_T fuzzy_DW;
+static ExtU_PID_Difuso_T fuzzy_U;
+static ExtY_PID_Difuso_T fuzzy_Y;
+static RT_MODEL_PID_Difuso_T fuzzy_M = { NULL, &fuzzy_P, &fuzzy_DW, &fuzzy_U, &fuzzy_Y };
+
+static DW_simulink_control_fixed_T pid_fixed_dw;
+static DW_PID_Difuso_fixed_T fuzzy_fixed_dw;
+static trajectory_t profile;
+static trajectory_cursor_t cursor;
+static metrics_t metrics;
+static encoder_filter_t ema_filter;
+static encoder_filter_t observer_filter;
+
+// ===================================================================
+// ===== KERNELS =====================================================
+// Each one makes n calls, cycling through the input tables.
+
+static void bench_pid_step(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        pid_U.error_signal = errors[i & (INPUTS - 1)];
+        simulink_control_step_r(&pid_M);
+        results[i & (INPUTS - 1)] = pid_Y.u_k;
+    }
+}
+
+static void bench_fuzzy_step(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        fuzzy_U.error_signal = errors[i & (INPUTS - 1)];
+        PID_Difuso_step_r(&fuzzy_M);
+        results[i & (INPUTS - 1)] = fuzzy_Y.out;
+    }
+}
+
+// Membership functions and rule inference (what compute_memberships feeds).
+static void bench_fuzzy_reference(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        results[i & (INPUTS - 1)] = PID_Difuso_fuzzy_reference(fuzzy_e[i & (INPUTS - 1)], fuzzy_de[i & (INPUTS - 1)]);
+    }
+}
+
+static void bench_fuzzy_surface(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        results[i & (INPUTS - 1)] = PID_Difuso_fuzzy_surface(fuzzy_e[i & (INPUTS - 1)], fuzzy_de[i & (INPUTS - 1)]);
+    }
+}
+
+static void bench_pid_fixed_step(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        results[i & (INPUTS - 1)] = simulink_control_fixed_step(&pid_fixed_dw, 3 << 16, pulses[i & (INPUTS - 1)]);
+    }
+}
+
+static void bench_fuzzy_fixed_step(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        results[i & (INPUTS - 1)] = PID_Difuso_fixed_step(&fuzzy_fixed_dw, 3 << 16, pulses[i & (INPUTS - 1)]);
+    }
+}
+
+static void bench_reference_rpm(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        results[i & (INPUTS - 1)] = trajectory_get_reference_rpm(profile_t[i & (INPUTS - 1)]);
+    }
+}
+
+// Only ramp times: the cost is dominated by Bezier().
+static void bench_reference_rpm_ramp(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        results[i & (INPUTS - 1)] = trajectory_get_reference_rpm(ramp_t[i & (INPUTS - 1)]);
+    }
+}
+
+static void bench_trajectory_eval(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        results[i & (INPUTS - 1)] = trajectory_eval(&profile, &cursor, profile_t[i & (INPUTS - 1)]);
+    }
+}
+
+static void bench_trajectory_eval_point(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        trajectory_point_t point;
+        trajectory_eval_point(&profile, &cursor, profile_t[i & (INPUTS - 1)], &point);
+        results[i & (INPUTS - 1)] = point.rpm + point.rpm_per_s;
+    }
+}
+
+static void bench_metrics_update(size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        size_t k = i & (INPUTS - 1);
+        metrics_update(&metrics, profile_t[k], 500.0f, 0.0f, 500.0f - (float)errors[k], (uint32_t)(k >> 9));
+    }
+    results[0] = metrics.run.mse;
+}
+
+static void bench_capture_tick(size_t n) {
+    telemetry_sample_t sample = { .reference_rpm = 500.0f };
+    for (size_t i = 0; i < n; i++) {
+        size_t k = i & (INPUTS - 1);
+        sample.timestamp_us = (uint32_t)i;
+        sample.measured_rpm = 500.0f - (float)errors[k];
+        sample.u_k = (float)results[k];
+        capture_buffer_tick(&sample, pulses[k], 0);
+    }
+}
+
+static void bench_speed(encoder_filter_t *filter, size_t n) {
+    encoder_window_t window = { .delta_time_ms = 10 };
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        size_t k = i & (INPUTS - 1);
+        window.pulses = pulses[k];
+        sum += encoder_filter_step(filter, &window, false);
+        encoder_filter_set_duty(filter, 50.0f + (float)(k & 15));
+    }
+    results[0] = sum;
+}
+
+static void bench_speed_ema(size_t n) {
+    bench_speed(&ema_filter, n);
+}
+
+static void bench_speed_observer(size_t n) {
+    bench_speed(&observer_filter, n);
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(size_t n);
+} kernel_t;
+
+static const kernel_t kernels[] = {
+    { "pid_step",             bench_pid_step },
+    { "fuzzy_step",           bench_fuzzy_step },
+    { "fuzzy_reference",      bench_fuzzy_reference },
+    { "fuzzy_surface",        bench_fuzzy_surface },
+    { "pid_fixed_step",       bench_pid_fixed_step },
+    { "fuzzy_fixed_step",     bench_fuzzy_fixed_step },
+    { "reference_rpm",        bench_reference_rpm },
+    { "reference_rpm_ramp",   bench_reference_rpm_ramp },
+    { "trajectory_eval",      bench_trajectory_eval },
+    { "trajectory_eval_point", bench_trajectory_eval_point },
+    { "metrics_update",       bench_metrics_update },
+    { "capture_tick",         bench_capture_tick },
+    { "speed_ema",            bench_speed_ema },
+    { "speed_observer",       bench_speed_observer },
+};
+#define KERNEL_COUNT (sizeof(kernels) / sizeof(kernels[0]))
+
+// ===================================================================
+// ===== MEASUREMENT =================================================
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Result of one kernel, in ns per call.
+ */
+typedef struct {
+    double median;
+    double min;
+    double spread;   // Median absolute deviation / median
+} bench_result_t;
+
+static void bench_run(const kernel_t *kernel, bench_result_t *result) {
+    // Warm-up and calibration: grow the batch until it takes BATCH_MIN_NS.
+    size_t n = INPUTS;
+    for (;;) {
+        double t0 = now_ns();
+        kernel->run(n);
+        if (now_ns() - t0 >= BATCH_MIN_NS || n >= ((size_t)1 << 30)) break;
+        n *= 2;
+    }
+
+    double samples[REPEATS];
+    for (int r = 0; r < REPEATS; r++) {
+        double t0 = now_ns();
+        kernel->run(n);
+        samples[r] = (now_ns() - t0) / (double)n;
+    }
+    qsort(samples, REPEATS, sizeof(samples[0]), compare_doubles);
+    result->median = samples[REPEATS / 2];
+    result->min = samples[0];
+
+    double deviations[REPEATS];
+    for (int r = 0; r < REPEATS; r++) {
+        deviations[r] = fabs(samples[r] - result->median);
+    }
+    qsort(deviations, REPEATS, sizeof(deviations[0]), compare_doubles);
+    result->spread = deviations[REPEATS / 2] / result->median;
+}
+
+static void setup_inputs(void) {
+    // Deterministic pseudo-random inputs (LCG), the same on every run.
+    uint32_t seed = 12345;
+    for (int i = 0; i < INPUTS; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        double u = (double)(seed >> 8) / (double)(1u << 24) * 2.0 - 1.0;   // -1..1
+        seed = seed * 1664525u + 1013904223u;
+        double v = (double)(seed >> 8) / (double)(1u << 24) * 2.0 - 1.0;
+        errors[i] = 400.0 * u;
+        fuzzy_e[i] = 1.2 * PID_Difuso_P.E_RANGE * u;
+        fuzzy_de[i] = 1.2 * PID_Difuso_P.DE_RANGE * v;
+        pulses[i] = 3 + (int32_t)(2.0 * v);
+        profile_t[i] = 45.0f * (float)i / INPUTS;
+        ramp_t[i] = 1.22f + 4.8f * (float)i / INPUTS;
+    }
+}
+
+static void setup_kernels(void) {
+    simulink_control_initialize();
+    PID_Difuso_initialize();
+    pid_P = simulink_control_P;
+    fuzzy_P = PID_Difuso_P;
+    simulink_control_initialize_r(&pid_M);
+    PID_Difuso_initialize_r(&fuzzy_M);
+    simulink_control_fixed_initialize(&pid_fixed_dw);
+    PID_Difuso_fixed_initialize(&fuzzy_fixed_dw);
+    trajectory_build_default(&profile);
+    trajectory_cursor_reset(&cursor);
+    metrics_reset(&metrics, 0.01f);
+    // A ring capture never stops, so every call stores an entry.
+    capture_buffer_init();
+    capture_buffer_arm(true);
+    capture_buffer_reset();
+    const encoder_observer_model_t model = ENCODER_OBSERVER_MODEL;
+    encoder_filter_init(&ema_filter, RPM_FILTER_ALPHA, 0);
+    encoder_filter_init(&observer_filter, RPM_FILTER_ALPHA, 0);
+    encoder_filter_setup_observer(&observer_filter, &model, 10);
+}
+
+/**
+ * @brief Looks up a kernel in a baseline file ("name ns_per_call" lines, '#' comments).
+ * @return The baseline, or a negative value if the kernel is not listed.
+ */
+static double baseline_lookup(const char *path, const char *name) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        return -1.0;
+    }
+    char line[128];
+    double found = -1.0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char key[64];
+        double value;
+        if (line[0] != '#' && sscanf(line, "%63s %lf", key, &value) == 2 && strcmp(key, name) == 0) {
+            found = value;
+        }
+    }
+    fclose(f);
+    return found;
+}
+
+int main(int argc, char **argv) {
+    const char *baseline_path = NULL;
+    const char *write_path = NULL;
+    const char *filter = NULL;
+    double threshold = 0.25;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+            write_path = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--baseline file] [--write file] [--threshold 0.25] [--filter name]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (baseline_path != NULL) {
+        FILE *f = fopen(baseline_path, "r");
+        if (f == NULL) {
+            perror(baseline_path);
+            return 2;
+        }
+        fclose(f);
+    }
+
+    setup_inputs();
+    setup_kernels();
+
+    FILE *out = NULL;
+    if (write_path != NULL) {
+        out = fopen(write_path, "w");
+        if (out == NULL) {
+            perror(write_path);
+            return 2;
+        }
+        fprintf(out, "# kernel_bench baseline: median ns/call (real_T = %s)\n",
+                sizeof(real_T) == sizeof(float) ? "float" : "double");
+    }
+
+    int regressions = 0;
+    printf("%-22s %10s %10s %8s", "kernel", "median", "min", "spread");
+    if (baseline_path != NULL) printf(" %10s %8s", "baseline", "change");
+    printf("\n");
+    for (size_t k = 0; k < KERNEL_COUNT; k++) {
+        if (filter != NULL && strstr(kernels[k].name, filter) == NULL) {
+            continue;
+        }
+        bench_result_t r;
+        bench_run(&kernels[k], &r);
+        printf("%-22s %10.2f %10.2f %7.1f%%", kernels[k].name, r.median, r.min, 100.0 * r.spread);
+        if (baseline_path != NULL) {
+            double base = baseline_lookup(baseline_path, kernels[k].name);
+            if (base > 0.0) {
+                double change = r.median / base - 1.0;
+                int regressed = change > threshold;
+                regressions += regressed;
+                printf(" %10.2f %+7.1f%%%s", base, 100.0 * change, regressed ? "  REGRESSION" : "");
+            } else {
+                printf(" %10s", "-");
+            }
+        }
+        printf("\n");
+        if (out != NULL) {
+            fprintf(out, "%s %.3f\n", kernels[k].name, r.median);
+        }
+    }
+    if (out != NULL) {
+        fclose(out);
+    }
+
+    // Keep the results alive.
+    double sink = 0.0;
+    for (int i = 0; i < INPUTS; i++) sink += results[i];
+    if (sink == 12345.678) printf("\n");
+
+    if (regressions > 0) {
+        printf("%d kernel(s) slower than the baseline by more than %.0f %%\n", regressions, 100.0 * threshold);
+        return 1;
+    }
+    return 0;
+}
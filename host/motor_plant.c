@@ -0,0 +1,82 @@
+#include "motor_plant.h"
+#include <math.h>
+#include <string.h>
+#include "motor_control.h"
+#include "encoder_reader.h"
+
+#define RAD_S_TO_RPM (60.0 / (2.0 * M_PI))
+// Encoder counts per shaft revolution, as assumed by encoder_get_rpm().
+#define COUNTS_PER_REV ((double)CYCLE_ADJUSTMENT * (double)PPR)
+
+void motor_plant_default_params(motor_plant_params_t *params) {
+    params->supply_v = 12.0;
+    params->resistance = 2.0;
+    params->inductance = 1.5e-3;
+    params->ke = 0.045;
+    params->kt = 0.045;
+    params->inertia = 1.0e-4;
+    params->viscous = 2.0e-5;
+    params->coulomb = 4.0e-3;
+    params->stiction = 6.0e-3;
+    params->load_torque = 0.0;
+    params->substep_s = 50e-6;
+}
+
+void motor_plant_init(motor_plant_t *plant, const motor_plant_params_t *params) {
+    memset(plant, 0, sizeof(*plant));
+    plant->p = *params;
+}
+
+double motor_plant_set_duty(motor_plant_t *plant, double percentage) {
+    // Same clamping and integer conversion as motor_set_duty_cycle()
+    if (percentage < DUTY_CYCLE_MIN) percentage = DUTY_CYCLE_MIN;
+    if (percentage > DUTY_CYCLE_MAX) percentage = DUTY_CYCLE_MAX;
+    uint32_t max_value = (1u << PWM_RESOLUTION) - 1;
+    uint32_t duty_value = (uint32_t)((percentage / 100.0) * max_value);
+    plant->duty_pct = 100.0 * duty_value / max_value;
+    return plant->duty_pct;
+}
+
+/**
+ * @brief One semi-implicit Euler step: the current first, then the speed with
+ * the new current. The speed is held at zero while the drive torque stays
+ * inside the stiction band, and friction cannot reverse the motion.
+ */
+static void motor_plant_substep(motor_plant_t *plant, double h) {
+    const motor_plant_params_t *p = &plant->p;
+    double voltage = p->supply_v * plant->duty_pct / 100.0;
+
+    plant->current += h * (voltage - p->resistance * plant->current - p->ke * plant->speed) / p->inductance;
+
+    double drive = p->kt * plant->current - p->load_torque;
+    if (plant->speed == 0.0 && fabs(drive) <= p->stiction) {
+        return; // Stuck
+    }
+    double direction = (plant->speed != 0.0) ? copysign(1.0, plant->speed) : copysign(1.0, drive);
+    double torque = drive - p->viscous * plant->speed - p->coulomb * direction;
+    double speed = plant->speed + h * torque / p->inertia;
+
+    // Friction alone brings the shaft to rest instead of reversing it
+    if (plant->speed != 0.0 && speed * plant->speed < 0.0) {
+        speed = 0.0;
+    }
+    plant->speed = speed;
+    plant->angle += h * speed;
+}
+
+int32_t motor_plant_advance(motor_plant_t *plant, double dt_s) {
+    int steps = (int)ceil(dt_s / plant->p.substep_s);
+    double h = dt_s / steps;
+    for (int i = 0; i < steps; i++) {
+        motor_plant_substep(plant, h);
+    }
+
+    int64_t counts = (int64_t)floor(plant->angle / (2.0 * M_PI) * COUNTS_PER_REV);
+    int32_t pulses = (int32_t)(counts - plant->counts);
+    plant->counts = counts;
+    return pulses;
+}
+
+double motor_plant_rpm(const motor_plant_t *plant) {
+    return plant->speed * RAD_S_TO_RPM;
+}
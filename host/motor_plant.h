@@ -0,0 +1,79 @@
+#ifndef MOTOR_PLANT_H //header guard
+#define MOTOR_PLANT_H
+
+#include <stdint.h>
+
+/*
+ * Brushed DC motor model for closed-loop simulation on the host.
+ *
+ *   L di/dt = V - R i - Ke w
+ *   J dw/dt = Kt i - b w - T_coulomb sign(w) - T_load
+ *
+ * with a static (breakaway) friction band around w = 0. The PWM input is
+ * quantized exactly like motor_set_duty_cycle() (PWM_RESOLUTION bits, clamped
+ * to DUTY_CYCLE_MIN..DUTY_CYCLE_MAX) and averaged over the 100 kHz period,
+ * which is far shorter than the electrical time constant. The shaft angle is
+ * quantized into encoder counts with the scaling of encoder_get_rpm()
+ * (CYCLE_ADJUSTMENT * PPR counts per revolution).
+ */
+
+/**
+ * @brief Physical parameters of the motor and its load.
+ */
+typedef struct {
+    double supply_v;       // H-bridge supply voltage [V]
+    double resistance;     // Armature resistance R [ohm]
+    double inductance;     // Armature inductance L [H]
+    double ke;             // Back-EMF constant [V s/rad]
+    double kt;             // Torque constant [N m/A]
+    double inertia;        // Rotor + load inertia J [kg m^2]
+    double viscous;        // Viscous friction b [N m s/rad]
+    double coulomb;        // Kinetic (Coulomb) friction [N m]
+    double stiction;       // Breakaway torque at standstill [N m]
+    double load_torque;    // Constant load torque [N m]
+    double substep_s;      // Integration step [s]
+} motor_plant_params_t;
+
+/**
+ * @brief State of one simulated motor.
+ */
+typedef struct {
+    motor_plant_params_t p;
+    double current;        // Armature current [A]
+    double speed;          // Shaft speed [rad/s]
+    double angle;          // Shaft angle [rad]
+    int64_t counts;        // Encoder counts reported so far
+    double duty_pct;       // Duty cycle actually applied [%]
+} motor_plant_t;
+
+/**
+ * @brief Default parameters: a 12 V gearmotor that reaches about 2200 RPM at
+ * DUTY_CYCLE_MAX with a mechanical time constant of roughly 100 ms.
+ */
+void motor_plant_default_params(motor_plant_params_t *params);
+
+/**
+ * @brief Resets the motor to standstill with the given parameters.
+ */
+void motor_plant_init(motor_plant_t *plant, const motor_plant_params_t *params);
+
+/**
+ * @brief Applies a duty cycle as motor_set_duty_cycle() would.
+ * @param percentage Requested duty cycle (0 to 100).
+ * @return The duty cycle after clamping and PWM quantization.
+ */
+double motor_plant_set_duty(motor_plant_t *plant, double percentage);
+
+/**
+ * @brief Integrates the model over one control period.
+ * @param dt_s Length of the period [s].
+ * @return The encoder pulses counted during the period.
+ */
+int32_t motor_plant_advance(motor_plant_t *plant, double dt_s);
+
+/**
+ * @brief True shaft speed in RPM.
+ */
+double motor_plant_rpm(const motor_plant_t *plant);
+
+#endif //header guard
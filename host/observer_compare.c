@@ -0,0 +1,209 @@
+/*
+ * File: observer_compare.c
+ *
+ * Purpose: Compares the speed observer of encoder_filter.c with the EMA it
+ * replaces. Both estimates are fed the same encoder windows of the DC motor
+ * model in motor_plant.c, driven open loop through duty steps, a ramp and
+ * a load torque step, and are measured against the true shaft speed (the
+ * observer also with a model 30 % off in tau and gain):
+ *   lag    shift of the true speed (1 ms resolution) that best matches the estimate
+ *   noise  RMS of what is left at that shift
+ *   hold   standard deviation of the estimate while the duty and load hold still
+ *   rms    RMS error against the true speed at the end of each window
+ * Then the 40 s profile runs closed loop with each estimate (closed_loop.c,
+ * default gains, with and without the plant feedforward; the PID also with
+ * the observer gains ENCODER_OBSERVER_PID_*, as obs_gains). true_mse is the
+ * error of the true speed, so it compares the estimates fairly; mse is the
+ * figure the device reports, on the estimate itself.
+ *
+ * Usage: observer_compare [period_ms]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "closed_loop.h"
+#include "encoder_reader.h"
+
+#define TEST_SECONDS  12.0
+#define MAX_LAG_MS    200
+#define ESTIMATORS    3
+
+static const encoder_observer_model_t observer_model = ENCODER_OBSERVER_MODEL;
+
+/**
+ * @brief Open-loop test input: duty steps, a ramp, then a load step.
+ */
+static void test_input(double t, double *duty_pct, double *load_nm) {
+    if (t < 2.0)       *duty_pct = 30.0;
+    else if (t < 4.0)  *duty_pct = 60.0;
+    else if (t < 6.0)  *duty_pct = 45.0;
+    else if (t < 8.0)  *duty_pct = 45.0 + 20.0 * (t - 6.0);
+    else               *duty_pct = 60.0;
+    *load_nm = t >= 10.0 ? 0.01 : 0.0;
+}
+
+// Holds used for the "hold" figure: the last second of two still segments.
+static int in_hold(double t) {
+    return (t >= 1.0 && t < 2.0) || (t >= 9.0 && t < 10.0);
+}
+
+typedef struct {
+    const char *name;
+    encoder_filter_t filter;
+    float *estimate;       // One per window
+} estimator_t;
+
+typedef struct {
+    double rms, lag_ms, noise, hold;
+} estimator_result_t;
+
+static void evaluate(const estimator_t *est, const double *truth_ms, long windows, int period_ms,
+                     estimator_result_t *result) {
+    // RMS at the end of each window
+    double sum_sq = 0.0;
+    for (long k = 1; k <= windows; k++) {
+        double d = est->estimate[k - 1] - truth_ms[k * period_ms];
+        sum_sq += d * d;
+    }
+    result->rms = sqrt(sum_sq / windows);
+
+    // Best delay of the true speed, skipping the start-up transient
+    long first = (MAX_LAG_MS + period_ms - 1) / period_ms;
+    double best = INFINITY;
+    int best_lag = 0;
+    for (int lag = 0; lag <= MAX_LAG_MS; lag++) {
+        double s = 0.0;
+        for (long k = first; k <= windows; k++) {
+            double d = est->estimate[k - 1] - truth_ms[k * period_ms - lag];
+            s += d * d;
+        }
+        if (s < best) {
+            best = s;
+            best_lag = lag;
+        }
+    }
+    result->lag_ms = best_lag;
+    result->noise = sqrt(best / (windows - first + 1));
+
+    // Spread during the holds, around the mean of each hold
+    double hold_sq = 0.0;
+    long hold_n = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        double lo = pass == 0 ? 1.0 : 9.0;
+        double mean = 0.0;
+        long n = 0;
+        for (long k = 1; k <= windows; k++) {
+            double t = (double)(k * period_ms) / 1000.0;
+            if (in_hold(t) && t >= lo && t < lo + 1.0) {
+                mean += est->estimate[k - 1];
+                n++;
+            }
+        }
+        mean /= n;
+        for (long k = 1; k <= windows; k++) {
+            double t = (double)(k * period_ms) / 1000.0;
+            if (in_hold(t) && t >= lo && t < lo + 1.0) {
+                double d = est->estimate[k - 1] - mean;
+                hold_sq += d * d;
+                hold_n++;
+            }
+        }
+    }
+    result->hold = sqrt(hold_sq / hold_n);
+}
+
+static void open_loop_test(int period_ms) {
+    motor_plant_params_t params;
+    motor_plant_default_params(&params);
+    motor_plant_t plant;
+    motor_plant_init(&plant, &params);
+
+    long windows = (long)(TEST_SECONDS * 1000.0) / period_ms;
+    double *truth_ms = malloc((size_t)(windows * period_ms + 1) * sizeof(double));
+    estimator_t est[ESTIMATORS] = { { .name = "ema" }, { .name = "observer" }, { .name = "obs_off30" } };
+    for (int i = 0; i < ESTIMATORS; i++) {
+        est[i].estimate = malloc((size_t)windows * sizeof(float));
+        encoder_filter_init(&est[i].filter, RPM_FILTER_ALPHA, 0);
+    }
+    encoder_observer_model_t off_model = observer_model;
+    off_model.tau_s *= 1.3f;
+    off_model.rpm_per_duty *= 0.7f;
+    encoder_filter_setup_observer(&est[1].filter, &observer_model, (uint32_t)period_ms);
+    encoder_filter_setup_observer(&est[2].filter, &off_model, (uint32_t)period_ms);
+
+    // The duty of each window is set at its start; the true speed is kept every millisecond.
+    truth_ms[0] = 0.0;
+    for (long k = 0; k < windows; k++) {
+        double duty, load;
+        test_input((double)(k * period_ms) / 1000.0, &duty, &load);
+        plant.p.load_torque = load;
+        float applied = (float)motor_plant_set_duty(&plant, duty);
+        int32_t pulses = 0;
+        for (int ms = 1; ms <= period_ms; ms++) {
+            pulses += motor_plant_advance(&plant, 0.001);
+            truth_ms[k * period_ms + ms] = motor_plant_rpm(&plant);
+        }
+        encoder_window_t window = { .pulses = pulses, .delta_time_ms = (uint32_t)period_ms };
+        for (int i = 0; i < ESTIMATORS; i++) {
+            est[i].estimate[k] = encoder_filter_step(&est[i].filter, &window, false);
+            encoder_filter_set_duty(&est[i].filter, applied);
+        }
+    }
+
+    printf("Open loop, %d ms windows (duty steps, ramp, load step):\n", period_ms);
+    printf("%-10s %8s %8s %8s %8s\n", "estimate", "lag_ms", "noise", "hold", "rms");
+    for (int i = 0; i < ESTIMATORS; i++) {
+        estimator_result_t r;
+        evaluate(&est[i], truth_ms, windows, period_ms, &r);
+        printf("%-10s %8.0f %8.2f %8.2f %8.2f\n", est[i].name, r.lag_ms, r.noise, r.hold, r.rms);
+        free(est[i].estimate);
+    }
+    printf("observer gains: speed %.4f, load %.5f (duty-to-speed decay %.4f)\n\n",
+           est[1].filter.obs_gain_speed, est[1].filter.obs_gain_load, est[1].filter.obs_decay);
+    free(truth_ms);
+}
+
+static void closed_loop_test(int period_ms) {
+    printf("Closed loop, 40 s profile, %d ms:\n", period_ms);
+    printf("%-10s %-9s %10s %10s %8s %10s %8s\n", "controller", "estimate", "mse", "true_mse", "iae", "overshoot", "effort");
+    for (int fuzzy = 0; fuzzy < 2; fuzzy++) {
+        for (int ff = 0; ff < 2; ff++) {
+            // 0 = EMA, 1 = observer, 2 = observer with its PID gains
+            for (int obs = 0; obs < (fuzzy ? 2 : 3); obs++) {
+                static const char *estimate_names[] = { "ema", "observer", "obs_gains" };
+                closed_loop_config_t config;
+                closed_loop_result_t result;
+                closed_loop_default_config(&config, fuzzy);
+                config.period_ms = period_ms;
+                config.observer = obs ? &observer_model : NULL;
+                if (obs == 2) {
+                    config.pid.Kp = ENCODER_OBSERVER_PID_KP;
+                    config.pid.Ki = ENCODER_OBSERVER_PID_KI;
+                    config.pid.Kd = ENCODER_OBSERVER_PID_KD;
+                }
+                if (ff) {
+                    closed_loop_plant_feedforward(&config.plant, &config.feedforward);
+                }
+                closed_loop_run(&config, &result, NULL, NULL);
+                char name[16];
+                snprintf(name, sizeof(name), "%s%s", fuzzy ? "fuzzy" : "pid", ff ? "+ff" : "");
+                printf("%-10s %-9s %10.1f %10.1f %8.1f %10.1f %8.2f\n", name, estimate_names[obs],
+                       result.mse, result.true_mse, result.iae, result.overshoot, result.effort);
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    int period_ms = argc > 1 ? atoi(argv[1]) : CLOSED_LOOP_TS_MS;
+    if (period_ms <= 0) {
+        fprintf(stderr, "Usage: observer_compare [period_ms]\n");
+        return 2;
+    }
+    simulink_control_initialize();
+    PID_Difuso_initialize();
+    open_loop_test(period_ms);
+    closed_loop_test(period_ms);
+    return 0;
+}
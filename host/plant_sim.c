@@ -0,0 +1,76 @@
+/*
+ * File: plant_sim.c
+ *
+ * Purpose: Faster-than-real-time closed-loop simulation of the firmware
+ * against the DC motor model in motor_plant.c. The unmodified
+ * trajectory_generator, simulink_control and PID_Difuso sources run the
+ * 40 s profile and every control step is written to stdout as a telemetry
+ * frame, followed by the MSE and reset frames the device sends when the reset
+ * button is pressed. The run summary and the metrics of every trajectory
+ * segment go to stderr. With --ff the reference
+ * feedforward runs with the gains of the ideal motor model.
+ *
+ * Usage: plant_sim [pid|fuzzy] [load_torque_Nm] [--ff] > run.bin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "closed_loop.h"
+#include "telemetry.h"
+
+// Writes every sample as a frame (the host telemetry backend prints to stdout).
+static void send_sample(telemetry_sample_t *sample, void *arg) {
+    (void)arg;
+    telemetry_send_sample(sample);
+    telemetry_flush();
+}
+
+int main(int argc, char **argv) {
+    int fuzzy = (argc > 1) && strcmp(argv[1], "fuzzy") == 0;
+    int use_ff = (argc > 1) && strcmp(argv[argc - 1], "--ff") == 0;
+    if (use_ff) argc--;
+    closed_loop_config_t config;
+    closed_loop_result_t result;
+
+    simulink_control_initialize();
+    PID_Difuso_initialize();
+    closed_loop_default_config(&config, fuzzy);
+    if (argc > 2) {
+        config.plant.load_torque = atof(argv[2]);
+    }
+    if (use_ff) {
+        closed_loop_plant_feedforward(&config.plant, &config.feedforward);
+    }
+
+    telemetry_init();
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    closed_loop_run(&config, &result, send_sample, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    telemetry_send_mse((float)result.mse);
+    telemetry_send_reset();
+    telemetry_flush();
+    fflush(stdout);
+
+    double wall_ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+    telemetry_stats_t tx;
+    telemetry_get_stats(&tx);
+    fprintf(stderr, "%s%s: %ld steps (%.0f s simulated) in %.1f ms, MSE=%.2f, %lu frames / %lu bytes\n",
+            fuzzy ? "fuzzy" : "pid", use_ff ? "+ff" : "", result.samples, config.seconds, wall_ms, result.mse,
+            (unsigned long)tx.frames_sent, (unsigned long)tx.bytes_sent);
+    fprintf(stderr, "segment  t_start  duration        mse      iae     itae  max_err  overshoot  settling\n");
+    for (uint8_t i = 0; i < metrics_segments_stored(&result.metrics); i++) {
+        const metrics_summary_t *s = metrics_segment(&result.metrics, i);
+        fprintf(stderr, "%7u %8.2f %9.2f %10.1f %8.1f %8.1f %8.1f %10.1f %9.2f\n",
+                (unsigned)s->number, s->t_start, s->duration, s->mse, s->iae, s->itae,
+                s->max_error, s->overshoot, s->settling_time);
+    }
+    const metrics_summary_t *run = &result.metrics.run;
+    fprintf(stderr, "    run %8.2f %9.2f %10.1f %8.1f %8.1f %8.1f %10.1f %9.2f\n",
+            run->t_start, run->duration, run->mse, run->iae, run->itae,
+            run->max_error, run->overshoot, run->settling_time);
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * File: quadrature_check.c
+ *
+ * Purpose: Checks that the two encoder backends of encoder_reader.c count
+ * with the same sign. The same A/B sequences are decoded with the QEM table
+ * of the GPIO ISR backend and with a model of the PCNT channel setup (the
+ * ENCODER_PCNT_* edge signs, kept while the other signal is high and
+ * inverted while it is low):
+ *   - every single-signal edge from every AB state, step by step;
+ *   - a full turn forward (A leading B) and backward, as net counts.
+ * The process exits with 1 on any difference, or if A leading B does not
+ * count up.
+ *
+ * Usage: quadrature_check
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "encoder_reader.h"
+
+#define TURN_EDGES ((int)(4.0f * PPR))
+
+static const int8_t QEM[16] = ENCODER_QEM_TABLE;
+
+// Gray sequence of AB = (A << 1) | B with A leading B.
+static const uint8_t forward_ab[4] = { 0x0, 0x2, 0x3, 0x1 };
+
+/**
+ * @brief Step of the GPIO ISR backend for the transition old_ab -> new_ab.
+ */
+static int qem_step(uint8_t old_ab, uint8_t new_ab) {
+    return QEM[((old_ab << 2) | new_ab) & 0x0f];
+}
+
+/**
+ * @brief Step of the PCNT backend for the transition old_ab -> new_ab (one
+ * signal changes): the channel of the signal that moved counts its edge,
+ * with the sign inverted while the other signal is low.
+ */
+static int pcnt_step(uint8_t old_ab, uint8_t new_ab) {
+    int a = (new_ab >> 1) & 1, b = new_ab & 1;
+    int sign;
+    if (((old_ab ^ new_ab) & 0x2) != 0) {
+        sign = a ? ENCODER_PCNT_A_RISING : ENCODER_PCNT_A_FALLING;
+        return b ? sign : -sign;
+    }
+    if (((old_ab ^ new_ab) & 0x1) != 0) {
+        sign = b ? ENCODER_PCNT_B_RISING : ENCODER_PCNT_B_FALLING;
+        return a ? sign : -sign;
+    }
+    return 0;
+}
+
+static const char *ab_name(uint8_t ab) {
+    static const char *names[4] = { "00", "01", "10", "11" };
+    return names[ab & 0x3];
+}
+
+int main(void) {
+    int ok = 1;
+
+    printf("%-8s %6s %6s\n", "AB", "isr", "pcnt");
+    for (uint8_t old_ab = 0; old_ab < 4; old_ab++) {
+        for (uint8_t flip = 1; flip <= 2; flip++) {
+            uint8_t new_ab = old_ab ^ flip;
+            int isr = qem_step(old_ab, new_ab);
+            int pcnt = pcnt_step(old_ab, new_ab);
+            int pass = isr == pcnt && isr != 0;
+            printf("%s->%s %6d %6d%s\n", ab_name(old_ab), ab_name(new_ab), isr, pcnt, pass ? "" : "  FAIL");
+            ok &= pass;
+        }
+    }
+
+    for (int dir = 1; dir >= -1; dir -= 2) {
+        long isr = 0, pcnt = 0;
+        int index = 0;
+        for (int i = 0; i < TURN_EDGES; i++) {
+            int next = (index + dir + 4) % 4;
+            isr += qem_step(forward_ab[index], forward_ab[next]);
+            pcnt += pcnt_step(forward_ab[index], forward_ab[next]);
+            index = next;
+        }
+        int pass = isr == pcnt && isr == (long)dir * TURN_EDGES;
+        printf("%-8s %6ld %6ld%s\n", dir > 0 ? "forward" : "backward", isr, pcnt, pass ? "" : "  FAIL");
+        ok &= pass;
+    }
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
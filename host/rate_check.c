@@ -0,0 +1,129 @@
+/*
+ * File: rate_check.c
+ *
+ * Purpose: Checks that the controllers, discretized for their sample time
+ * (simulink_control_discretize_r(), PID_Difuso_discretize_r()), keep the
+ * same continuous-time behavior at every control rate. Each controller runs
+ * the 40 s profile against the motor model at CLOSED_LOOP_TS_MS and at the
+ * faster periods below, with the RPM EMA rescaled to the same time constant
+ * and the reference feedforward of the ideal motor model (without it the
+ * default fuzzy PID settles into a limit cycle, whose phase is not
+ * reproducible from one rate to the next).
+ * The speed of every run is compared with the CLOSED_LOOP_TS_MS run on its
+ * 10 ms grid; the process exits with 1 if a run drifts by more than the
+ * tolerance.
+ *
+ * Usage: rate_check [pid|fuzzy|all] [load_torque_Nm]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "closed_loop.h"
+
+// Periods checked against the CLOSED_LOOP_TS_MS run (1 ms = 1 kHz).
+static const int periods_ms[] = { 5, 2, 1 };
+#define PERIOD_COUNT (sizeof(periods_ms) / sizeof(periods_ms[0]))
+
+// RMS of the speed difference on the common grid (the runs track the 1031 RPM
+// profile within about 75 RPM RMS). The count-based speed of a shorter window
+// is coarser (one count is about 3.8 RPM at 10 ms, 38 RPM at 1 ms), which
+// the rescaled EMA only partly smooths out: the PID stays under 0.5 RPM and
+// the fuzzy PID, whose surface is steeper, under 4 RPM.
+#define TOLERANCE_RMS_RPM 10.0
+
+typedef struct {
+    long count;        // Grid points stored
+    long capacity;
+    float *rpm;        // Filtered speed on the grid
+} grid_trace_t;
+
+static void store_sample(telemetry_sample_t *sample, void *arg) {
+    grid_trace_t *trace = arg;
+    long k = (long)(sample->timestamp_us / 1000u);
+    if (k % (CLOSED_LOOP_TS_MS) != 0) {
+        return;
+    }
+    if (trace->count < trace->capacity) {
+        trace->rpm[trace->count++] = sample->measured_rpm;
+    }
+}
+
+/**
+ * @brief EMA factor with the time constant that 'alpha' has at
+ * CLOSED_LOOP_TS_MS, for a filter updated every period_ms.
+ */
+static float rescale_alpha(float alpha, int period_ms) {
+    return (float)(1.0 - pow(1.0 - alpha, (double)period_ms / CLOSED_LOOP_TS_MS));
+}
+
+static void run_at(int fuzzy, double load_torque, int period_ms, grid_trace_t *trace, closed_loop_result_t *result) {
+    closed_loop_config_t config;
+    closed_loop_default_config(&config, fuzzy);
+    config.plant.load_torque = load_torque;
+    closed_loop_plant_feedforward(&config.plant, &config.feedforward);
+    config.period_ms = period_ms;
+    config.filter_alpha = rescale_alpha(config.filter_alpha, period_ms);
+    trace->count = 0;
+    closed_loop_run(&config, result, store_sample, trace);
+}
+
+/**
+ * @brief Runs one controller at every rate.
+ * @return 1 if every rate is within the tolerance.
+ */
+static int check_controller(int fuzzy, double load_torque) {
+    long capacity = (long)(CLOSED_LOOP_SECONDS * 1000.0 / CLOSED_LOOP_TS_MS) + 1;
+    grid_trace_t base = { .capacity = capacity, .rpm = malloc(capacity * sizeof(float)) };
+    grid_trace_t trace = { .capacity = capacity, .rpm = malloc(capacity * sizeof(float)) };
+    closed_loop_result_t result;
+    int ok = 1;
+
+    run_at(fuzzy, load_torque, CLOSED_LOOP_TS_MS, &base, &result);
+    printf("%-6s %6s %10s %8s %10s %12s %12s\n", fuzzy ? "fuzzy" : "pid",
+           "Ts_ms", "mse", "iae", "overshoot", "rms_diff", "max_diff");
+    printf("%-6s %6d %10.1f %8.1f %10.1f %12s %12s\n", "", CLOSED_LOOP_TS_MS,
+           result.mse, result.iae, result.overshoot, "-", "-");
+
+    for (size_t i = 0; i < PERIOD_COUNT; i++) {
+        run_at(fuzzy, load_torque, periods_ms[i], &trace, &result);
+        long n = trace.count < base.count ? trace.count : base.count;
+        double sum_sq = 0.0, max_diff = 0.0;
+        for (long k = 0; k < n; k++) {
+            double diff = fabs((double)trace.rpm[k] - base.rpm[k]);
+            sum_sq += diff * diff;
+            if (diff > max_diff) max_diff = diff;
+        }
+        double rms = n > 0 ? sqrt(sum_sq / n) : 0.0;
+        int pass = n == base.count && rms <= TOLERANCE_RMS_RPM;
+        printf("%-6s %6d %10.1f %8.1f %10.1f %12.2f %12.2f%s\n", "", periods_ms[i],
+               result.mse, result.iae, result.overshoot, rms, max_diff, pass ? "" : "  FAIL");
+        ok &= pass;
+    }
+
+    free(base.rpm);
+    free(trace.rpm);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    const char *which = argc > 1 ? argv[1] : "all";
+    double load_torque = argc > 2 ? atof(argv[2]) : 0.0;
+    if (strcmp(which, "pid") != 0 && strcmp(which, "fuzzy") != 0 && strcmp(which, "all") != 0) {
+        fprintf(stderr, "Usage: rate_check [pid|fuzzy|all] [load_torque_Nm]\n");
+        return 2;
+    }
+
+    simulink_control_initialize();
+    PID_Difuso_initialize();
+    int ok = 1;
+    if (strcmp(which, "fuzzy") != 0) {
+        ok &= check_controller(0, load_torque);
+    }
+    if (strcmp(which, "pid") != 0) {
+        ok &= check_controller(1, load_torque);
+    }
+    printf("%s (tolerance %.1f RPM RMS)\n", ok ? "PASS" : "FAIL", TOLERANCE_RMS_RPM);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,360 @@
+/*
+ * File: session_replay.c
+ *
+ * Purpose: Replays a session log of main/session_record.c through the
+ * firmware's own speed estimate (encoder_filter_step()) and control stack
+ * (axis_control, control_params, controller_registry) and checks that every
+ * u_k comes out bit for bit as on the device. The log is the raw telemetry
+ * stream captured during the recording (plotter.py "record on <file>", or
+ * stack_sim --record); frames other than TELEMETRY_FRAME_RECORD are skipped.
+ *
+ * The replayed run is written to stdout as telemetry frames (samples and
+ * resets, as the device sends them), the report to stderr. Exit code 1 on a
+ * mismatch or a damaged log.
+ *
+ * session_replay_f32 is the same tool built with real_T = float, for logs of
+ * firmware built with CONTROL_SINGLE_PRECISION.
+ *
+ * Usage: session_replay log.bin > replayed.bin
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "axis_control.h"
+#include "control_params.h"
+#include "controller_registry.h"
+#include "session_record.h"
+#include "encoder_filter.h"
+#include "telemetry.h"
+#include "command.h"
+
+// --- Replay backend: the recorded encoder windows through the real filter ---
+static encoder_filter_t replay_filter;   // Starts from the snapshot of the header
+static encoder_window_t replay_window;   // Window of the current TICK
+static bool replay_mt_method;
+
+static void *replay_create(uint8_t axis, const axis_io_config_t *config) {
+    (void)config;
+    return axis == 0 ? &replay_filter : NULL;
+}
+
+// The encoder keeps running across resets on the device, so does the filter here.
+static void replay_reset(void *instance) {
+    (void)instance;
+}
+
+static float replay_read_rpm(void *instance, uint32_t period_ms) {
+    (void)period_ms;
+    return encoder_filter_step(instance, &replay_window, replay_mt_method);
+}
+
+static float replay_set_duty(void *instance, float percentage) {
+    (void)instance;
+    return percentage;
+}
+
+static const axis_io_ops_t axis_io_session = {
+    .name = "session",
+    .create = replay_create,
+    .reset = replay_reset,
+    .read_rpm = replay_read_rpm,
+    .set_duty = replay_set_duty,
+};
+
+// --- Little-endian readers for the records ---
+static uint16_t get_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static float get_f32(const uint8_t *p) {
+    uint32_t bits = get_u32(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint32_t float_bits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * @brief Reverses the COBS encoding of one frame (as in command.c).
+ * @return The decoded length, or 0 if the encoding is invalid.
+ */
+static size_t cobs_decode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+    while (in_pos < len) {
+        uint8_t code = in[in_pos++];
+        if (code == 0 || in_pos + code - 1 > len) {
+            return 0;
+        }
+        for (uint8_t i = 1; i < code; i++) {
+            out[out_pos++] = in[in_pos++];
+        }
+        if (code < 0xFF && in_pos < len) {
+            out[out_pos++] = 0;
+        }
+    }
+    return out_pos;
+}
+
+/**
+ * @brief State of the replay and its findings.
+ */
+typedef struct {
+    bool started;           // HEADER seen
+    uint16_t next_seq;
+    long ticks;
+    long mismatches;
+    long first_mismatch;    // seq of the first mismatch, -1 if none
+    long bad_frames;        // Frames with a bad encoding or CRC
+    bool lost;              // Records were dropped on the way: replay stopped
+    bool failed;            // Unusable header or record: replay stopped
+} replay_t;
+
+static bool replay_header(replay_t *replay, const uint8_t *rec, size_t len) {
+    if (len != SESSION_RECORD_HEADER_LEN || rec[2] != SESSION_RECORD_FORMAT) {
+        fprintf(stderr, "unsupported header (format %u, %zu bytes)\n", len > 2 ? rec[2] : 0, len);
+        replay->failed = true;
+        return false;
+    }
+    uint8_t flags = rec[3];
+    bool single = (flags & SESSION_RECORD_FLAG_SINGLE) != 0;
+    if (single != (sizeof(real_T) == sizeof(float))) {
+        fprintf(stderr, "the log comes from a real_T = %s build: use session_replay%s\n",
+                single ? "float" : "double", single ? "_f32" : "");
+        replay->failed = true;
+        return false;
+    }
+    uint16_t period_ms = get_u16(&rec[4]);
+    uint8_t controller = rec[6];
+    if (controller >= controller_count()) {
+        fprintf(stderr, "unknown controller %u\n", controller);
+        replay->failed = true;
+        return false;
+    }
+
+    replay_mt_method = (flags & SESSION_RECORD_FLAG_MT) != 0;
+    replay_filter.filter_alpha = get_f32(&rec[7]);
+    replay_filter.filtered_rpm = get_f32(&rec[11]);
+    replay_filter.prev_edge_us = get_u32(&rec[15]);
+    replay_filter.prev_edge_dir = (int8_t)rec[19];
+    replay_filter.has_prev_edge = rec[20] != 0;
+    replay_filter.mt_rpm = get_f32(&rec[21]);
+
+    axis_config_t config = {
+        .filter_alpha = replay_filter.filter_alpha, .controller = controller,
+        .core = 0, .io = &axis_io_session,
+    };
+    if (!axis_control_init(&config, 1, period_ms)) {
+        fprintf(stderr, "axis_control_init failed\n");
+        replay->failed = true;
+        return false;
+    }
+    fprintf(stderr, "session: %u ms period, %s, %s estimate, real_T = %s\n", period_ms,
+            controller_get(controller)->name, replay_mt_method ? "M/T" : "count",
+            single ? "float" : "double");
+    replay->started = true;
+    return true;
+}
+
+/**
+ * @brief Feeds one command payload to the command channel, framed as the plotter sends it.
+ */
+static void replay_command(const uint8_t *payload, size_t len) {
+    uint8_t frame[TELEMETRY_MAX_FRAME_LEN];
+    command_feed(frame, telemetry_encode_frame(payload, len, frame));
+}
+
+/**
+ * @brief Brings the parameter block to the recorded one with PARAM_SET
+ * commands, as on the device. They all land before the next step, which
+ * picks up the latest block.
+ */
+static void replay_params(const uint8_t *rec) {
+    control_params_t current;
+    uint32_t version;
+    control_params_read(&current, &version);
+
+    uint16_t float_mask = get_u16(&rec[2]);
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD_LEN];
+    size_t len = 0;
+    payload[len++] = CONTROL_CMD_PARAM_SET;
+    for (uint8_t id = 0; id < CONTROL_PARAM_COUNT; id++) {
+        float value = get_f32(&rec[4 + 4 * id]);
+        bool same = float_bits(control_params_get_value(&current, id)) == float_bits(value);
+        if (float_mask & (1u << id)) {
+            if (same && control_params_is_float(&current, id)) {
+                continue;
+            }
+            if (len + 5 > sizeof(payload)) {
+                replay_command(payload, len);
+                len = 1;
+            }
+            payload[len++] = id;
+            memcpy(&payload[len], &rec[4 + 4 * id], 4);
+            len += 4;
+        } else if (!same || control_params_is_float(&current, id)) {
+            // A compiled default that only the same build can restore.
+            fprintf(stderr, "warning: parameter %u is a compiled default on the device (%g) "
+                    "that this build cannot restore\n", id, value);
+        }
+    }
+    if (len > 1) {
+        replay_command(payload, len);
+    }
+}
+
+static void replay_tick(replay_t *replay, const uint8_t *rec) {
+    uint16_t seq = get_u16(&rec[2]);
+    if (seq != replay->next_seq) {
+        fprintf(stderr, "records lost before tick %u (expected %u): replay stopped\n", seq, replay->next_seq);
+        replay->lost = true;
+        return;
+    }
+    replay->next_seq = seq + 1;
+
+    replay_window.pulses = (int32_t)get_u32(&rec[4]);
+    replay_window.delta_time_ms = get_u16(&rec[8]);
+    replay_window.last_edge_us = get_u32(&rec[10]);
+    replay_window.last_edge_dir = (int8_t)rec[14];
+    replay_window.now_us = get_u32(&rec[15]);
+    trajectory_point_t reference = {
+        .rpm = get_f32(&rec[19]), .rpm_per_s = get_f32(&rec[23]),
+    };
+    uint8_t controller = rec[27];
+    float u_k = get_f32(&rec[28]);
+
+    // The device switched in this step: request it before the step.
+    if (controller != axis_control_active_controller(0)) {
+        axis_control_select(0, controller);
+    }
+    axis_control_run(&reference, 0);
+
+    telemetry_sample_t sample;
+    axis_control_get_sample(0, &sample);
+    if (float_bits(sample.u_k) != float_bits(u_k)) {
+        if (replay->mismatches == 0) {
+            replay->first_mismatch = seq;
+            fprintf(stderr, "tick %u: u_k %.9g, recorded %.9g\n", seq, sample.u_k, u_k);
+        }
+        replay->mismatches++;
+    }
+    replay->ticks++;
+    telemetry_send_sample(&sample);
+    telemetry_flush();
+}
+
+/**
+ * @brief Runs one decoded record.
+ * @return false if the replay cannot go on.
+ */
+static bool replay_record(replay_t *replay, const uint8_t *rec, size_t len) {
+    uint8_t kind = rec[1];
+    if (!replay->started) {
+        // Anything before the header belongs to no recording.
+        return kind == SESSION_RECORD_HEADER ? replay_header(replay, rec, len) : true;
+    }
+    switch (kind) {
+        case SESSION_RECORD_PARAMS:
+            if (len == SESSION_RECORD_PARAMS_LEN) {
+                replay_params(rec);
+                return true;
+            }
+            break;
+        case SESSION_RECORD_RESET:
+            axis_control_reset();
+            telemetry_send_reset();
+            telemetry_flush();
+            return true;
+        case SESSION_RECORD_TICK:
+            if (len == SESSION_RECORD_TICK_LEN) {
+                replay_tick(replay, rec);
+                return !replay->lost;
+            }
+            break;
+        case SESSION_RECORD_HEADER:
+            fprintf(stderr, "a second recording starts here: only the first one is replayed\n");
+            return false;
+        default:
+            break;
+    }
+    fprintf(stderr, "bad record (kind %u, %zu bytes)\n", kind, len);
+    replay->failed = true;
+    return false;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s log.bin > replayed.bin\n", argv[0]);
+        return 2;
+    }
+    FILE *in = fopen(argv[1], "rb");
+    if (in == NULL) {
+        perror(argv[1]);
+        return 2;
+    }
+
+    simulink_control_initialize();
+    PID_Difuso_initialize();
+    telemetry_init();
+    control_params_init();
+    controller_registry_init();
+    command_init();
+
+    replay_t replay = { .first_mismatch = -1 };
+    uint8_t encoded[TELEMETRY_MAX_FRAME_LEN];
+    uint8_t frame[TELEMETRY_MAX_FRAME_LEN];
+    size_t encoded_len = 0;
+    bool overflow = false;
+    bool go_on = true;
+    int c;
+    while (go_on && (c = fgetc(in)) != EOF) {
+        if (c != 0x00) {
+            if (encoded_len < sizeof(encoded)) {
+                encoded[encoded_len++] = (uint8_t)c;
+            } else {
+                overflow = true;
+            }
+            continue;
+        }
+        // Frame delimiter
+        size_t n = overflow ? 0 : cobs_decode(encoded, encoded_len, frame);
+        bool empty = encoded_len == 0;
+        encoded_len = 0;
+        overflow = false;
+        if (empty) {
+            continue;
+        }
+        if (n < 3 || get_u16(&frame[n - 2]) != telemetry_crc16(frame, n - 2)) {
+            replay.bad_frames++;
+            continue;
+        }
+        if (frame[0] == TELEMETRY_FRAME_RECORD && n - 2 >= 2) {
+            go_on = replay_record(&replay, frame, n - 2);
+        }
+    }
+    fclose(in);
+
+    if (!replay.started) {
+        if (!replay.failed) {
+            fprintf(stderr, "no session header in %s\n", argv[1]);
+        }
+        return 1;
+    }
+    fprintf(stderr, "%ld ticks replayed, %ld bad frames: ", replay.ticks, replay.bad_frames);
+    if (replay.mismatches == 0) {
+        fprintf(stderr, "u_k matches bit for bit%s\n", replay.lost ? " up to the lost records" : "");
+    } else {
+        fprintf(stderr, "%ld MISMATCHES (first at tick %ld)\n", replay.mismatches, replay.first_mismatch);
+    }
+    return replay.mismatches == 0 && !replay.lost && !replay.failed ? 0 : 1;
+}
@@ -0,0 +1,139 @@
+/*
+ * File: stack_sim.c
+ *
+ * Purpose: Runs the firmware's own control stack natively: axis_control,
+ * control_params, controller_registry and trajectory_stream from main/,
+ * paced by the host backend of control_tick, with every axis on a
+ * non-hardware axis_io backend. Axis 0 is scored with the same streaming
+ * metrics as the device. With the plant backend the run must match
+ * closed_loop_run() exactly, which is checked (exit code 1 on a mismatch).
+ *
+ * With --record the run is also logged by main/session_record.c, as on the
+ * device: the RECORD frames go to stdout (the report to stderr), ready for
+ * session_replay.
+ *
+ * Usage: stack_sim [pid|fuzzy] [plant|sim] [axes] [--record]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "axis_control.h"
+#include "axis_io_plant.h"
+#include "control_params.h"
+#include "controller_registry.h"
+#include "trajectory_stream.h"
+#include "control_tick.h"
+#include "closed_loop.h"
+#include "metrics.h"
+#include "encoder_reader.h"
+#include "session_record.h"
+#include "telemetry.h"
+#include "command.h"
+
+static metrics_t metrics;
+static bool record = false;
+
+// The part of control_step() in main.c that does not touch the hardware.
+static void control_step(uint32_t tick_index, void *arg) {
+    (void)arg;
+    float t_seconds = (tick_index * CLOSED_LOOP_TS_MS) / 1000.0f;
+    trajectory_point_t reference;
+    trajectory_stream_reference(t_seconds, &reference);
+    axis_control_run(&reference, 0);
+
+    telemetry_sample_t sample;
+    axis_control_get_sample(0, &sample);
+    metrics_update(&metrics, t_seconds, reference.rpm, reference.rpm_per_s, sample.measured_rpm,
+                   trajectory_stream_segment_key());
+    if (record) {
+        session_record_tick(&reference, &sample);
+        telemetry_flush();
+    }
+}
+
+/**
+ * @brief Arms a recording through the command channel, as the plotter does.
+ */
+static void record_arm(void) {
+    uint8_t payload[2] = { SESSION_RECORD_CMD, SESSION_RECORD_FLAG_ON };
+    uint8_t frame[TELEMETRY_MAX_FRAME_LEN];
+    size_t n = telemetry_encode_frame(payload, sizeof(payload), frame);
+    command_feed(frame, n);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[argc - 1], "--record") == 0) {
+        record = true;
+        argc--;
+    }
+    int fuzzy = (argc > 1) && strcmp(argv[1], "fuzzy") == 0;
+    const axis_io_ops_t *io = (argc > 2) && strcmp(argv[2], "sim") == 0 ? &axis_io_sim : &axis_io_plant;
+    int axes = argc > 3 ? atoi(argv[3]) : 1;
+    FILE *report = record ? stderr : stdout;
+    if (axes < 1 || axes > AXIS_MAX_COUNT) {
+        fprintf(stderr, "axes must be 1 to %d\n", AXIS_MAX_COUNT);
+        return 2;
+    }
+
+    simulink_control_initialize();
+    PID_Difuso_initialize();
+    control_params_init();
+    trajectory_stream_init();
+
+    axis_config_t table[AXIS_MAX_COUNT];
+    for (int i = 0; i < axes; i++) {
+        table[i] = (axis_config_t){
+            .pwm_channel = i, .filter_alpha = RPM_FILTER_ALPHA,
+            .controller = fuzzy ? CONTROLLER_ID_FUZZY : CONTROLLER_ID_PID,
+            .core = CONTROL_TICK_TASK_CORE, .io = io,
+        };
+    }
+    if (!axis_control_init(table, (uint8_t)axes, CLOSED_LOOP_TS_MS)) {
+        fprintf(stderr, "axis_control_init failed\n");
+        return 1;
+    }
+    if (record) {
+        if (io != &axis_io_plant) {
+            fprintf(stderr, "--record needs the plant backend (it records encoder windows)\n");
+            return 2;
+        }
+        telemetry_init();
+        session_record_init(CLOSED_LOOP_TS_MS, false);
+        command_init();
+        record_arm();
+        // The recording starts at a reset, as with the button on the device.
+        axis_control_reset();
+        session_record_reset();
+        telemetry_flush();
+    }
+
+    metrics_reset(&metrics, CLOSED_LOOP_TS_MS / 1000.0f);
+    long steps = (long)(CLOSED_LOOP_SECONDS * 1000.0 / CLOSED_LOOP_TS_MS + 0.5);
+    control_tick_start(CLOSED_LOOP_TS_MS * 1000, control_step, NULL);
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (long k = 0; k < steps; k++) {
+        control_tick_host_fire((uint64_t)k * CLOSED_LOOP_TS_MS * 1000, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double wall_us = (t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3;
+
+    fprintf(report, "%s on %s, %d axis(es): %ld ticks in %.1f ms (%.2f us/tick), MSE=%.2f\n",
+           controller_get(axis_control_active_controller(0))->name, io->name, axes,
+           steps, wall_us / 1e3, wall_us / steps, metrics.run.mse);
+
+    if (io == &axis_io_plant) {
+        closed_loop_config_t config;
+        closed_loop_result_t *result = malloc(sizeof(*result));
+        closed_loop_default_config(&config, fuzzy);
+        closed_loop_run(&config, result, NULL, NULL);
+        // Same metrics code on both sides, so any difference is a difference in the loop.
+        int match = memcmp(&result->metrics.run, &metrics.run, sizeof(metrics.run)) == 0;
+        fprintf(report, "closed_loop_run: MSE=%.2f (%s)\n", result->metrics.run.mse, match ? "match" : "MISMATCH");
+        free(result);
+        return match ? 0 : 1;
+    }
+    return 0;
+}
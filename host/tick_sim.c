@@ -0,0 +1,105 @@
+/*
+ * File: tick_sim.c
+ *
+ * Purpose: Drives the control_tick module with a simulated timer on the host
+ * and checks its statistics against known inputs:
+ *   - a fixed sequence of wake-up times with early, late and on-time ticks
+ *     and one step that runs longer than the period (an overrun);
+ *   - a reset request, which must leave the statistics untouched until the
+ *     next tick and then start a new window with that tick.
+ * The process exits with 1 if any statistic differs from the expected value.
+ *
+ * Usage: tick_sim
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include "control_tick.h"
+
+#define TS_US 10000
+
+typedef struct {
+    uint64_t now_us;
+    uint32_t exec_us;
+} tick_input_t;
+
+// Period deviations: 0, +50, -70, +520 (late), -500, 0. The late tick also
+// runs longer than the period.
+static const tick_input_t run_ticks[] = {
+    {  1000,  1000 },
+    { 11000,  1200 },
+    { 21050,   900 },
+    { 30980,  1100 },
+    { 41500, 10200 },
+    { 51000,  1000 },
+    { 61000,  2500 },
+};
+
+static void dummy_step(uint32_t tick_index, void *arg) {
+    (void)tick_index;
+    (void)arg;
+}
+
+/**
+ * @brief Compares the current statistics with the expected ones and prints both.
+ * @return 1 if they match.
+ */
+static int check_stats(const char *name, const control_tick_stats_t *expected) {
+    control_tick_stats_t stats;
+    control_tick_get_stats(&stats);
+    int pass = stats.ticks == expected->ticks && stats.overruns == expected->overruns
+            && stats.period_us == expected->period_us
+            && stats.jitter_min_us == expected->jitter_min_us
+            && stats.jitter_max_us == expected->jitter_max_us
+            && stats.jitter_mean_abs_us == expected->jitter_mean_abs_us
+            && stats.jitter_samples == expected->jitter_samples
+            && stats.exec_max_us == expected->exec_max_us;
+    printf("%-12s ticks=%u overruns=%u period_us=%u jitter_min_us=%d jitter_max_us=%d jitter_mean_us=%.1f jitter_samples=%u exec_max_us=%u%s\n",
+           name, stats.ticks, stats.overruns, stats.period_us, stats.jitter_min_us,
+           stats.jitter_max_us, stats.jitter_mean_abs_us, stats.jitter_samples,
+           stats.exec_max_us, pass ? "" : "  FAIL");
+    if (!pass) {
+        printf("%-12s ticks=%u overruns=%u period_us=%u jitter_min_us=%d jitter_max_us=%d jitter_mean_us=%.1f jitter_samples=%u exec_max_us=%u\n",
+               "  expected", expected->ticks, expected->overruns, expected->period_us,
+               expected->jitter_min_us, expected->jitter_max_us, expected->jitter_mean_abs_us,
+               expected->jitter_samples, expected->exec_max_us);
+    }
+    return pass;
+}
+
+int main(void) {
+    int ok = 1;
+
+    control_tick_start(TS_US, dummy_step, NULL);
+    for (size_t i = 0; i < sizeof(run_ticks) / sizeof(run_ticks[0]); i++) {
+        control_tick_host_fire(run_ticks[i].now_us, run_ticks[i].exec_us);
+    }
+    const control_tick_stats_t after_run = {
+        .ticks = 7, .overruns = 1, .period_us = TS_US,
+        .jitter_min_us = -500, .jitter_max_us = 520,
+        .jitter_mean_abs_us = (0 + 50 + 70 + 520 + 500 + 0) / 6.0f,
+        .jitter_samples = 6, .exec_max_us = 10200,
+    };
+    ok &= check_stats("run", &after_run);
+
+    // The clear is applied by the next tick, not by the request.
+    control_tick_reset_stats();
+    ok &= check_stats("requested", &after_run);
+
+    control_tick_host_fire(71000, 300);
+    const control_tick_stats_t after_reset = {
+        .ticks = 1, .period_us = TS_US, .exec_max_us = 300,
+    };
+    ok &= check_stats("reset", &after_reset);
+
+    control_tick_host_fire(81010, 400);
+    const control_tick_stats_t after_next = {
+        .ticks = 2, .period_us = TS_US,
+        .jitter_min_us = 10, .jitter_max_us = 10, .jitter_mean_abs_us = 10.0f,
+        .jitter_samples = 1, .exec_max_us = 400,
+    };
+    ok &= check_stats("next", &after_next);
+
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
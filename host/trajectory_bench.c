@@ -0,0 +1,167 @@
+/*
+ * File: trajectory_bench.c
+ *
+ * Purpose: Compares the compiled trajectory (trajectory_build_default() +
+ * trajectory_eval()) and trajectory_get_reference_rpm() against the same
+ * profile evaluated in double precision, and measures the cost of both. The original function is timed per
+ * call; the compiled one is timed sequentially (as the control loop uses it),
+ * with random access (cursor rescans) and through the batch API.
+ * The acceleration of trajectory_eval_point() and of
+ * trajectory_get_reference_accel() is checked the same way.
+ * The process exits with 1 if the compiled trajectory is off by more than
+ * the tolerance.
+ *
+ * Usage: trajectory_bench [samples]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "trajectory_generator.h"
+
+// About 1e-5 of the 1031 RPM peak. The original single-precision evaluation
+// is off by about 0.2 RPM during the ramps (cancellation in Bezier()).
+#define TOLERANCE_RPM 0.01
+// About 1e-4 of the 554 RPM/s peak acceleration.
+#define TOLERANCE_RPM_S 0.05
+#define PROFILE_END_S 45.0f
+#define REPEATS       5
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief The built-in profile of trajectory_generator.c, in double precision.
+ */
+static double bezier_double(double k) {
+    return pow(k, 5) * (252.0 - 1050.0 * k + 1800.0 * k * k - 1575.0 * pow(k, 3)
+                        + 700.0 * pow(k, 4) - 126.0 * pow(k, 5));
+}
+
+// d/dk of bezier_double(): 1260 k^4 (1 - k)^5
+static double bezier_derivative_double(double k) {
+    return 1260.0 * pow(k, 4) * pow(1.0 - k, 5);
+}
+
+static double accel_double(double t) {
+    const double s = 40.0 / 3.3;
+    const double m[6] = { 0.1 * s, 0.5 * s, 1.5 * s, 2.2 * s, 3.2 * s, 3.3 * s };
+    const double full = 24.0 * 9.5492965855 * 4.5;
+    const double amplitude[3] = { full, -0.5 * full, 0.25 * full };
+    for (int r = 0; r < 3; r++) {
+        double d = m[2 * r + 1] - m[2 * r];
+        if (t > m[2 * r] && t <= m[2 * r + 1]) {
+            return amplitude[r] * bezier_derivative_double((t - m[2 * r]) / d) / d;
+        }
+    }
+    return 0.0;
+}
+
+static double reference_double(double t) {
+    const double s = 40.0 / 3.3;
+    const double m[6] = { 0.1 * s, 0.5 * s, 1.5 * s, 2.2 * s, 3.2 * s, 3.3 * s };
+    const double full = 24.0 * 9.5492965855 * 4.5;
+    if (t <= m[0]) return 0.0;
+    if (t <= m[1]) return full * bezier_double((t - m[0]) / (m[1] - m[0]));
+    if (t <= m[2]) return full;
+    if (t <= m[3]) return full - 0.5 * full * bezier_double((t - m[2]) / (m[3] - m[2]));
+    if (t <= m[4]) return 0.5 * full;
+    if (t <= m[5]) return 0.5 * full + 0.25 * full * bezier_double((t - m[4]) / (m[5] - m[4]));
+    return 0.75 * full;
+}
+
+int main(int argc, char **argv) {
+    int samples = (argc > 1) ? atoi(argv[1]) : 1000000;
+    const float dt = PROFILE_END_S / samples;
+    float *batch = malloc((size_t)samples * sizeof(*batch));
+    float *random_t = malloc((size_t)samples * sizeof(*random_t));
+    volatile float sink = 0.0f;
+    if (batch == NULL || random_t == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 2;
+    }
+
+    trajectory_t traj;
+    trajectory_cursor_t cursor;
+    trajectory_build_default(&traj);
+
+    // --- Deviation from the double-precision profile (sequential and batch) ---
+    double max_err = 0.0, max_err_batch = 0.0, max_err_original = 0.0;
+    trajectory_cursor_reset(&cursor);
+    trajectory_eval_batch(&traj, &cursor, 0.0f, dt, batch, (size_t)samples);
+    trajectory_cursor_reset(&cursor);
+    for (int i = 0; i < samples; i++) {
+        float t = i * dt;
+        double exact = reference_double(t);
+        double err = fabs((double)trajectory_eval(&traj, &cursor, t) - exact);
+        double err_batch = fabs((double)batch[i] - exact);
+        double err_original = fabs((double)trajectory_get_reference_rpm(t) - exact);
+        if (err > max_err) max_err = err;
+        if (err_batch > max_err_batch) max_err_batch = err_batch;
+        if (err_original > max_err_original) max_err_original = err_original;
+    }
+
+    // --- Acceleration (analytic derivatives) ---
+    double max_err_accel = 0.0, max_err_accel_original = 0.0, max_err_point = 0.0;
+    trajectory_cursor_reset(&cursor);
+    for (int i = 0; i < samples; i++) {
+        float t = i * dt;
+        trajectory_point_t point;
+        trajectory_eval_point(&traj, &cursor, t, &point);
+        double exact = accel_double(t);
+        double err = fabs((double)point.rpm_per_s - exact);
+        double err_original = fabs((double)trajectory_get_reference_accel(t) - exact);
+        double err_point = fabs((double)point.rpm - reference_double(t));
+        if (err > max_err_accel) max_err_accel = err;
+        if (err_original > max_err_accel_original) max_err_accel_original = err_original;
+        if (err_point > max_err_point) max_err_point = err_point;
+    }
+
+    srand(1);
+    for (int i = 0; i < samples; i++) {
+        random_t[i] = PROFILE_END_S * ((float)rand() / RAND_MAX);
+    }
+
+    // --- Timing (best of REPEATS, the host is not idle) ---
+    // Results go to memory rather than into one accumulator, so the loops are
+    // not serialized on a floating-point add.
+    double best[4] = { INFINITY, INFINITY, INFINITY, INFINITY };
+    for (int r = 0; r < REPEATS; r++) {
+        double t0 = now_ns();
+        for (int i = 0; i < samples; i++) batch[i] = trajectory_get_reference_rpm(i * dt);
+        double t1 = now_ns();
+        sink += batch[samples / 2];
+        trajectory_cursor_reset(&cursor);
+        for (int i = 0; i < samples; i++) batch[i] = trajectory_eval(&traj, &cursor, i * dt);
+        double t2 = now_ns();
+        sink += batch[samples / 2];
+        for (int i = 0; i < samples; i++) batch[i] = trajectory_eval(&traj, &cursor, random_t[i]);
+        double t3 = now_ns();
+        sink += batch[samples / 2];
+        trajectory_cursor_reset(&cursor);
+        trajectory_eval_batch(&traj, &cursor, 0.0f, dt, batch, (size_t)samples);
+        double t4 = now_ns();
+        sink += batch[samples / 2];
+
+        if (t1 - t0 < best[0]) best[0] = t1 - t0;
+        if (t2 - t1 < best[1]) best[1] = t2 - t1;
+        if (t3 - t2 < best[2]) best[2] = t3 - t2;
+        if (t4 - t3 < best[3]) best[3] = t4 - t3;
+    }
+
+    printf("compiled profile: %u segments, max_err=%.6f RPM, max_err_batch=%.6f RPM (original: %.6f RPM)\n",
+           (unsigned)traj.count, max_err, max_err_batch, max_err_original);
+    printf("acceleration: max_err=%.6f RPM/s (original: %.6f RPM/s), speed of the point: max_err=%.6f RPM\n",
+           max_err_accel, max_err_accel_original, max_err_point);
+    printf("original: %.2f ns/call, compiled sequential: %.2f ns/call, random: %.2f ns/call, batch: %.2f ns/sample\n",
+           best[0] / samples, best[1] / samples, best[2] / samples, best[3] / samples);
+
+    free(batch);
+    free(random_t);
+    return (max_err <= TOLERANCE_RPM && max_err_batch <= TOLERANCE_RPM && max_err_point <= TOLERANCE_RPM &&
+            max_err_accel <= TOLERANCE_RPM_S) ? 0 : 1;
+}
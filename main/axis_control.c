@@ -0,0 +1,343 @@
+#include "axis_control.h"
+#include <string.h>
+#include <stdatomic.h>
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#else
+#include <time.h>
+#endif
+
+#include "motor_control.h"
+#include "control_tick.h"
+#include "control_params.h"
+#include "feedforward.h"
+#include "controller_registry.h"
+#include "command.h"
+#include "loop_profiler.h"
+
+// No controller switch requested.
+#define AXIS_NO_REQUEST 0xFF
+
+/**
+ * @brief Runtime data of one axis: its configuration, one instance of every
+ * registered controller and its last sample and timing.
+ */
+typedef struct {
+    axis_config_t config;
+    uint8_t id;
+
+    // One instance per registered controller; only the active one is stepped.
+    void *instances[CONTROLLER_MAX_COUNT];
+    uint8_t active;
+    atomic_uchar requested;       // Pending switch (AXIS_NO_REQUEST if none)
+
+    void *io;                     // Instance of the motor + encoder backend
+    volatile bool reset_pending;
+    uint32_t params_version;      // Version of the parameter block in use
+    control_params_t params;      // The block in use
+    float u_fb;                   // Feedback part of the last applied output (after the clamp)
+
+    telemetry_sample_t sample;
+    axis_timing_t timing;
+    uint64_t exec_sum_us;
+} axis_runtime_t;
+
+static axis_runtime_t axes[AXIS_MAX_COUNT];
+static uint8_t axis_count = 0;
+static uint32_t control_period_ms = 10;
+
+// --- Cross-core Scheduling State ---
+// Written by the tick handler before the worker is notified.
+static trajectory_point_t run_reference;
+static volatile uint64_t run_wake_us = 0;
+#ifdef ESP_PLATFORM
+static TaskHandle_t worker_task = NULL;
+static volatile bool worker_busy = false;
+#endif
+static volatile uint32_t worker_overruns = 0;
+
+/**
+ * @brief Time in microseconds (esp_timer time base on the device).
+ */
+static uint64_t axis_now_us(void) {
+#ifdef ESP_PLATFORM
+    return (uint64_t)esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#endif
+}
+
+/**
+ * @brief Re-initializes the controller instances and the backend of one axis.
+ */
+static void axis_reset_states(axis_runtime_t *ax) {
+    for (uint8_t c = 0; c < controller_count(); c++) {
+        if (ax->instances[c] != NULL) {
+            controller_get(c)->reset(ax->instances[c]);
+        }
+    }
+    ax->config.io->reset(ax->io);
+    ax->u_fb = 0.0f;
+    ax->sample.u_k = 0.0f;
+    ax->sample.error = 0.0f;
+}
+
+/**
+ * @brief Makes a requested controller active. The new controller is primed
+ * with the feedback part of the last applied output and the last error, so
+ * u_k continues from where it was.
+ */
+static void axis_apply_switch(axis_runtime_t *ax) {
+    uint8_t requested = atomic_exchange_explicit(&ax->requested, AXIS_NO_REQUEST, memory_order_acquire);
+    if (requested == AXIS_NO_REQUEST || requested == ax->active || ax->instances[requested] == NULL) {
+        return;
+    }
+    controller_get(requested)->track(ax->instances[requested], ax->u_fb, ax->sample.error);
+    ax->active = requested;
+}
+
+/**
+ * @brief One control period of one axis: reference, measurement, controller
+ * and PWM update, followed by the bookkeeping of its timing.
+ */
+static void axis_step(axis_runtime_t *ax) {
+    uint64_t start_us = axis_now_us();
+
+    if (ax->reset_pending) {
+        axis_reset_states(ax);
+        ax->reset_pending = false;
+    }
+
+    // New parameters take effect here, between two steps of this axis.
+    if (control_params_version() != ax->params_version) {
+        control_params_t params;
+        uint32_t version;
+        if (control_params_read(&params, &version)) {
+            for (uint8_t c = 0; c < controller_count(); c++) {
+                if (ax->instances[c] != NULL) {
+                    controller_get(c)->apply_params(ax->instances[c], &params);
+                }
+            }
+            ax->params = params;
+            ax->params_version = version;
+        }
+    }
+
+    axis_apply_switch(ax);
+
+    telemetry_sample_t *sample = &ax->sample;
+    sample->timestamp_us = (uint32_t)start_us;
+    float reference_rpm = run_reference.rpm;
+
+    LOOP_PROFILE_START(stage_cycles);
+    float measured_rpm = ax->config.io->read_rpm(ax->io, control_period_ms);
+
+    LOOP_PROFILE_LAP_IF(ax->id == LOOP_PROFILER_AXIS, LOOP_STAGE_ENCODER, stage_cycles);
+
+    float error = reference_rpm - measured_rpm;
+
+    float u_fb = controller_get(ax->active)->step(ax->instances[ax->active], error, sample->state);
+
+    // The model of the motor supplies most of the output; feedback corrects the rest.
+    float u_ff = feedforward_output(&ax->params.feedforward, reference_rpm, run_reference.rpm_per_s);
+    float u_k = u_fb + u_ff;
+
+    if (u_k > 1.0f) u_k = 1.0f;
+    if (u_k < 0.0f) u_k = 0.0f;
+    // A controller switched in takes over from what reached the motor, not
+    // from a wound-up output past the clamp.
+    ax->u_fb = u_k - u_ff;
+
+    LOOP_PROFILE_LAP_IF(ax->id == LOOP_PROFILER_AXIS, LOOP_STAGE_CONTROLLER, stage_cycles);
+
+    float duty_cycle_to_set = DUTY_CYCLE_MIN + (u_k * (DUTY_CYCLE_MAX - DUTY_CYCLE_MIN));
+    ax->config.io->set_duty(ax->io, duty_cycle_to_set);
+    LOOP_PROFILE_LAP_IF(ax->id == LOOP_PROFILER_AXIS, LOOP_STAGE_PWM, stage_cycles);
+
+    sample->reference_rpm = reference_rpm;
+    sample->measured_rpm = measured_rpm;
+    sample->error = error;
+    sample->u_k = u_k;
+
+    // --- Timing ---
+    uint32_t exec_us = (uint32_t)(axis_now_us() - start_us);
+    uint32_t lag_us = (uint32_t)(start_us - run_wake_us);
+    axis_timing_t *timing = &ax->timing;
+    if (timing->steps == 0 || exec_us < timing->exec_min_us) timing->exec_min_us = exec_us;
+    if (exec_us > timing->exec_max_us) timing->exec_max_us = exec_us;
+    if (lag_us > timing->start_lag_max_us) timing->start_lag_max_us = lag_us;
+    timing->steps++;
+    ax->exec_sum_us += exec_us;
+    timing->exec_mean_us = (float)ax->exec_sum_us / (float)timing->steps;
+}
+
+#ifdef ESP_PLATFORM
+// Worker pinned to the core that does not own the control tick. It runs the
+// axes assigned to that core once per notification from the tick handler.
+static void axis_worker_task(void *arg) {
+    int core = (int)(intptr_t)arg;
+    while (1) {
+        uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (pending > 1) {
+            worker_overruns += pending - 1;
+        }
+        worker_busy = true;
+        for (uint8_t i = 0; i < axis_count; i++) {
+            if (axes[i].config.core == core) {
+                axis_step(&axes[i]);
+            }
+        }
+        worker_busy = false;
+    }
+}
+#endif
+
+/**
+ * @brief SELECT_CONTROLLER command handler (command task).
+ */
+static size_t axis_cmd_select(const uint8_t *payload, size_t len, uint8_t *reply) {
+    if (len != 3) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+    }
+    bool ok = axis_control_select(payload[1], payload[2]);
+    return command_ack(reply, payload[0], ok ? COMMAND_STATUS_OK : COMMAND_STATUS_BAD_ID);
+}
+
+bool axis_control_init(const axis_config_t *table, uint8_t count, uint32_t period_ms) {
+    if (count > AXIS_MAX_COUNT) {
+        count = AXIS_MAX_COUNT;
+    }
+    axis_count = count;
+    control_period_ms = period_ms;
+    controller_registry_init();
+
+    int worker_core = -1;
+    for (uint8_t i = 0; i < count; i++) {
+        axis_runtime_t *ax = &axes[i];
+        memset(ax, 0, sizeof(*ax));
+        ax->config = table[i];
+        ax->id = i;
+
+        // Every axis starts from the current runtime parameter block, with
+        // an instance of every registered controller.
+        control_params_read(&ax->params, &ax->params_version);
+        for (uint8_t c = 0; c < controller_count(); c++) {
+            ax->instances[c] = controller_get(c)->create(&ax->params, period_ms);
+        }
+        if (ax->config.controller >= controller_count() || ax->instances[ax->config.controller] == NULL) {
+            return false;
+        }
+        ax->active = ax->config.controller;
+        atomic_init(&ax->requested, AXIS_NO_REQUEST);
+
+        const axis_io_config_t io_config = {
+            .pwm_pin = ax->config.pwm_pin, .pwm_channel = ax->config.pwm_channel,
+            .enc_a_pin = ax->config.enc_a_pin, .enc_b_pin = ax->config.enc_b_pin,
+            .filter_alpha = ax->config.filter_alpha, .period_ms = period_ms,
+        };
+        if (ax->config.io == NULL || (ax->io = ax->config.io->create(i, &io_config)) == NULL) {
+            return false;
+        }
+        axis_reset_states(ax);
+
+        if (ax->config.core != CONTROL_TICK_TASK_CORE) {
+            worker_core = ax->config.core;
+        }
+    }
+
+    command_register(AXIS_CMD_SELECT_CONTROLLER, axis_cmd_select);
+
+#ifdef ESP_PLATFORM
+    if (worker_core >= 0 && worker_task == NULL) {
+        if (xTaskCreatePinnedToCore(axis_worker_task, "axis_worker", AXIS_WORKER_STACK,
+                                    (void *)(intptr_t)worker_core, AXIS_WORKER_PRIORITY,
+                                    &worker_task, worker_core) != pdPASS) {
+            return false;
+        }
+    }
+#else
+    (void)worker_core;
+#endif
+    return true;
+}
+
+void axis_control_run(const trajectory_point_t *reference, uint64_t wake_us) {
+    run_reference = *reference;
+    run_wake_us = wake_us;
+
+#ifdef ESP_PLATFORM
+    // Release the other core first so both halves run in parallel.
+    if (worker_task != NULL) {
+        if (worker_busy) {
+            worker_overruns++;
+        }
+        xTaskNotifyGive(worker_task);
+    }
+
+    for (uint8_t i = 0; i < axis_count; i++) {
+        if (axes[i].config.core == CONTROL_TICK_TASK_CORE) {
+            axis_step(&axes[i]);
+        }
+    }
+#else
+    // No second core on the host: every axis runs here, in order.
+    for (uint8_t i = 0; i < axis_count; i++) {
+        axis_step(&axes[i]);
+    }
+#endif
+}
+
+void axis_control_reset(void) {
+    for (uint8_t i = 0; i < axis_count; i++) {
+        axes[i].reset_pending = true;
+    }
+}
+
+bool axis_control_select(uint8_t axis, uint8_t controller) {
+    if (controller >= controller_count() || (axis != AXIS_ALL && axis >= axis_count)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < axis_count; i++) {
+        if (axis == AXIS_ALL || axis == i) {
+            atomic_store_explicit(&axes[i].requested, controller, memory_order_release);
+        }
+    }
+    return true;
+}
+
+uint8_t axis_control_active_controller(uint8_t axis) {
+    return axes[axis].active;
+}
+
+void axis_control_get_sample(uint8_t axis, telemetry_sample_t *sample) {
+    *sample = axes[axis].sample;
+}
+
+void axis_control_get_params(uint8_t axis, control_params_t *params, uint32_t *version) {
+    *params = axes[axis].params;
+    *version = axes[axis].params_version;
+}
+
+void axis_control_get_timing(uint8_t axis, axis_timing_t *timing) {
+    *timing = axes[axis].timing;
+}
+
+void axis_control_reset_timing(void) {
+    for (uint8_t i = 0; i < axis_count; i++) {
+        memset(&axes[i].timing, 0, sizeof(axes[i].timing));
+        axes[i].exec_sum_us = 0;
+    }
+    worker_overruns = 0;
+}
+
+uint32_t axis_control_worker_overruns(void) {
+    return worker_overruns;
+}
+
+uint8_t axis_control_count(void) {
+    return axis_count;
+}
@@ -0,0 +1,128 @@
+#ifndef AXIS_CONTROL_H //header guard
+#define AXIS_CONTROL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "telemetry.h"
+#include "trajectory_generator.h"
+#include "axis_io.h"
+#include "control_params.h"
+
+// --- Axis Limits ---
+// Four axes fit easily in a 10 ms period: one PID step is a few microseconds
+// and the fuzzy step (surface lookup) is of the same order.
+#define AXIS_MAX_COUNT 4
+
+// --- Worker Task Configuration ---
+// Axes that are not assigned to the control tick core run in a worker task
+// pinned to the other core. It is woken by the tick handler at the start of
+// every period and runs at the same priority as the control tick task.
+#define AXIS_WORKER_PRIORITY (configMAX_PRIORITIES - 2)
+#define AXIS_WORKER_STACK    4096
+
+// --- Commands ---
+// SELECT_CONTROLLER: opcode | axis u8 (AXIS_ALL = every axis) | controller id u8 -> ACK
+// The switch happens at the next step of the axis, without a bump in u_k.
+#define AXIS_CMD_SELECT_CONTROLLER 0x12
+#define AXIS_ALL                   0xFF
+
+/**
+ * @brief Static configuration of one axis (one motor and its encoder).
+ */
+typedef struct {
+    int pwm_pin;                  // GPIO that drives the motor.
+    int pwm_channel;              // LEDC channel, unique per axis.
+    int enc_a_pin;                // Encoder channel A (GPIO below 32).
+    int enc_b_pin;                // Encoder channel B (GPIO below 32).
+    float filter_alpha;           // Smoothing factor of the RPM EMA filter.
+    uint8_t controller;           // Controller at startup (registry id, CONTROLLER_ID_*).
+    int core;                     // Core that runs the control step (0 or 1).
+    const axis_io_ops_t *io;      // Motor + encoder backend (&axis_io_esp32, &axis_io_sim, ...).
+} axis_config_t;
+
+/**
+ * @brief Execution timing of one axis since the last reset.
+ */
+typedef struct {
+    uint32_t steps;          // Control steps executed.
+    uint32_t exec_min_us;    // Shortest control step.
+    uint32_t exec_max_us;    // Longest control step.
+    float    exec_mean_us;   // Mean control step.
+    uint32_t start_lag_max_us; // Longest delay from the tick wake-up to the start of the step.
+} axis_timing_t;
+
+/**
+ * @brief Initializes the motor + encoder backends and controller instances of
+ * every axis in the table and starts the worker task if any axis runs on the core
+ * that does not own the control tick.
+ * @param table The axis configuration table (copied).
+ * @param count Number of axes in the table (at most AXIS_MAX_COUNT).
+ * @param period_ms The control period in milliseconds.
+ * @return true if every axis was set up.
+ * On the host every axis runs in axis_control_run(), whatever its core.
+ */
+bool axis_control_init(const axis_config_t *table, uint8_t count, uint32_t period_ms);
+
+/**
+ * @brief Runs one control period of every axis. Called from the control tick
+ * handler: the axes of the other core are released first, then the local
+ * axes run in order. Does not wait for the other core.
+ * @param reference Reference of this period, shared by every axis. Its speed
+ * closes the loop; speed and acceleration drive the feedforward.
+ * @param wake_us Wake-up time of the control tick (esp_timer time base).
+ */
+void axis_control_run(const trajectory_point_t *reference, uint64_t wake_us);
+
+/**
+ * @brief Requests a reset of every axis. Each axis re-initializes its
+ * controller at the start of its next step, on its own core.
+ */
+void axis_control_reset(void);
+
+/**
+ * @brief Requests a controller switch. The axis carries its feedback output
+ * over to the new controller (see controller_ops_t.track) at its next step.
+ * @param axis The axis, or AXIS_ALL.
+ * @param controller Registry id of the new controller.
+ * @return false if the axis or the controller does not exist.
+ */
+bool axis_control_select(uint8_t axis, uint8_t controller);
+
+/**
+ * @brief Registry id of the controller that closes the loop of one axis.
+ */
+uint8_t axis_control_active_controller(uint8_t axis);
+
+/**
+ * @brief Copies the last sample of one axis.
+ * Only consistent for axes that run on the control tick core.
+ */
+void axis_control_get_sample(uint8_t axis, telemetry_sample_t *sample);
+
+/**
+ * @brief Copies the parameter block one axis is using and its version.
+ * Only consistent for axes that run on the control tick core.
+ */
+void axis_control_get_params(uint8_t axis, control_params_t *params, uint32_t *version);
+
+/**
+ * @brief Copies the timing of one axis.
+ */
+void axis_control_get_timing(uint8_t axis, axis_timing_t *timing);
+
+/**
+ * @brief Clears the timing of every axis and the worker overrun counter.
+ */
+void axis_control_reset_timing(void);
+
+/**
+ * @brief Periods in which the worker had not finished the previous one.
+ */
+uint32_t axis_control_worker_overruns(void);
+
+/**
+ * @brief Number of configured axes.
+ */
+uint8_t axis_control_count(void);
+
+#endif //header guard
@@ -0,0 +1,204 @@
+#include "capture_buffer.h"
+
+#if CAPTURE_BUFFER
+
+#include <string.h>
+#include <stdatomic.h>
+#include "command.h"
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#endif
+
+_Static_assert((CAPTURE_CAPACITY & (CAPTURE_CAPACITY - 1)) == 0, "CAPTURE_CAPACITY must be a power of two");
+_Static_assert(CAPTURE_CAPACITY <= 32768, "CAPTURE frames count the entries with 16 bits");
+
+#ifdef CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY
+#define CAPTURE_BUFFER_ATTR EXT_RAM_BSS_ATTR
+#else
+#define CAPTURE_BUFFER_ATTR
+#endif
+
+typedef enum {
+    CAPTURE_IDLE = 0,   // Nothing captured since startup
+    CAPTURE_ARMED,      // Starts at the next reset
+    CAPTURE_ARMED_RING, // Starts at the next reset, in ring mode
+    CAPTURE_RUNNING,    // The control task is writing
+    CAPTURE_DONE,       // Stopped: the entries can be dumped
+} capture_state_t;
+
+static CAPTURE_BUFFER_ATTR capture_entry_t buffer[CAPTURE_CAPACITY];
+// Written by the control task while running; read by the command task once DONE is published.
+static uint32_t head = 0;          // Next entry to write
+static uint32_t count = 0;         // Entries stored (at most CAPTURE_CAPACITY)
+static bool running = false;       // Control task copy of CAPTURE_RUNNING
+static bool ring = false;          // Control task copy of the armed mode
+static int disarmed_state;         // Command task: state a disarm returns to (IDLE or DONE)
+static atomic_int state;
+static atomic_bool stop_requested;
+
+/**
+ * @brief Ends the capture (control task only).
+ */
+static void capture_buffer_finish(void) {
+    running = false;
+    atomic_store_explicit(&state, CAPTURE_DONE, memory_order_release);
+}
+
+void capture_buffer_reset(void) {
+    if (running) {
+        capture_buffer_finish();
+        return;
+    }
+    // The command task may disarm or re-arm at the same time: the state only
+    // becomes RUNNING through an exchange on the armed state it last saw. A
+    // stop request can only follow RUNNING, so a stale one is cleared first.
+    int armed = atomic_load_explicit(&state, memory_order_acquire);
+    while (armed == CAPTURE_ARMED || armed == CAPTURE_ARMED_RING) {
+        atomic_store_explicit(&stop_requested, false, memory_order_relaxed);
+        if (atomic_compare_exchange_weak_explicit(&state, &armed, CAPTURE_RUNNING,
+                                                  memory_order_acquire, memory_order_acquire)) {
+            ring = armed == CAPTURE_ARMED_RING;
+            head = 0;
+            count = 0;
+            running = true;
+            return;
+        }
+    }
+}
+
+void capture_buffer_tick(const telemetry_sample_t *sample, int32_t pulses, uint8_t controller) {
+    if (!running) {
+        return;
+    }
+    if (atomic_load_explicit(&stop_requested, memory_order_relaxed)) {
+        capture_buffer_finish();
+        return;
+    }
+
+    capture_entry_t *entry = &buffer[head];
+    entry->timestamp_us = sample->timestamp_us;
+    entry->pulses = pulses;
+    entry->reference_rpm = sample->reference_rpm;
+    entry->measured_rpm = sample->measured_rpm;
+    entry->state[0] = sample->state[0];
+    entry->state[1] = sample->state[1];
+    entry->u_k = sample->u_k;
+    entry->controller = controller;
+    head = (head + 1) & (CAPTURE_CAPACITY - 1);
+    if (count < CAPTURE_CAPACITY) {
+        count++;
+    }
+    if (count == CAPTURE_CAPACITY && !ring) {
+        capture_buffer_finish();
+    }
+}
+
+// --- Little-endian helpers for the CAPTURE frames ---
+static uint8_t *put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static uint8_t *put_f32(uint8_t *p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return put_u32(p, bits);
+}
+
+bool capture_buffer_arm(bool ring_mode) {
+    // Exchanged rather than stored: the control task may start an armed capture meanwhile.
+    int current = atomic_load_explicit(&state, memory_order_acquire);
+    do {
+        if (current == CAPTURE_RUNNING) {
+            return false;
+        }
+        if (current == CAPTURE_IDLE || current == CAPTURE_DONE) {
+            disarmed_state = current;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&state, &current,
+                                                    ring_mode ? CAPTURE_ARMED_RING : CAPTURE_ARMED,
+                                                    memory_order_acq_rel, memory_order_acquire));
+    return true;
+}
+
+/**
+ * @brief CAPTURE command handler (command task): arms or stops a capture.
+ */
+static size_t capture_cmd(const uint8_t *payload, size_t len, uint8_t *reply) {
+    if (len != 2) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+    }
+    if (payload[1] & CAPTURE_FLAG_ON) {
+        bool armed = capture_buffer_arm((payload[1] & CAPTURE_FLAG_RING) != 0);
+        return command_ack(reply, payload[0], armed ? COMMAND_STATUS_OK : COMMAND_STATUS_STATE);
+    }
+    int current = atomic_load_explicit(&state, memory_order_acquire);
+    if (current == CAPTURE_RUNNING) {
+        // The control task ends it at its next tick.
+        atomic_store_explicit(&stop_requested, true, memory_order_relaxed);
+    } else if (current == CAPTURE_ARMED || current == CAPTURE_ARMED_RING) {
+        // Disarm, unless the control task has just started it: then stop that.
+        if (!atomic_compare_exchange_strong(&state, &current, disarmed_state) &&
+            current == CAPTURE_RUNNING) {
+            atomic_store_explicit(&stop_requested, true, memory_order_relaxed);
+        }
+    }
+    return command_ack(reply, payload[0], COMMAND_STATUS_OK);
+}
+
+/**
+ * @brief CAPTURE_DUMP command handler (command task): streams the entries,
+ * blocking on the UART, then acknowledges.
+ */
+static size_t capture_cmd_dump(const uint8_t *payload, size_t len, uint8_t *reply) {
+    if (len != 1) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+    }
+    int current = atomic_load_explicit(&state, memory_order_acquire);
+    if (current == CAPTURE_ARMED || current == CAPTURE_ARMED_RING || current == CAPTURE_RUNNING) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_STATE);
+    }
+
+    // Frozen until the next CAPTURE, which this task would have to handle first.
+    uint32_t first = (head - count) & (CAPTURE_CAPACITY - 1);
+    for (uint32_t i = 0; i < count; i++) {
+        const capture_entry_t *entry = &buffer[(first + i) & (CAPTURE_CAPACITY - 1)];
+        uint8_t frame[CAPTURE_FRAME_LEN];
+        uint8_t *p = frame;
+        *p++ = TELEMETRY_FRAME_CAPTURE;
+        p = put_u16(p, (uint16_t)i);
+        p = put_u16(p, (uint16_t)count);
+        p = put_u32(p, entry->timestamp_us);
+        p = put_u32(p, (uint32_t)entry->pulses);
+        p = put_f32(p, entry->reference_rpm);
+        p = put_f32(p, entry->measured_rpm);
+        p = put_f32(p, entry->state[0]);
+        p = put_f32(p, entry->state[1]);
+        p = put_f32(p, entry->u_k);
+        *p = entry->controller;
+        telemetry_send_frame_now(frame, sizeof(frame));
+    }
+    return command_ack(reply, payload[0], COMMAND_STATUS_OK);
+}
+
+void capture_buffer_init(void) {
+    head = 0;
+    count = 0;
+    running = false;
+    disarmed_state = CAPTURE_IDLE;
+    atomic_init(&state, CAPTURE_IDLE);
+    atomic_init(&stop_requested, false);
+    command_register(CAPTURE_CMD, capture_cmd);
+    command_register(CAPTURE_CMD_DUMP, capture_cmd_dump);
+}
+
+#endif // CAPTURE_BUFFER
@@ -0,0 +1,99 @@
+#ifndef CAPTURE_BUFFER_H //header guard
+#define CAPTURE_BUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "telemetry.h"
+
+// 1 = keep the full state of every control tick of axis 0 in a RAM buffer,
+// dumped over the command channel after the run (idf.py -DCAPTURE_BUFFER=ON
+// build). At 0 the module adds no code, data or command.
+#ifndef CAPTURE_BUFFER
+#define CAPTURE_BUFFER 0
+#endif
+
+/*
+ * The UART carries one 100 Hz sample stream; the capture buffer keeps every
+ * tick instead, at any control rate, and sends it afterwards:
+ *
+ *   1. CAPTURE with CAPTURE_FLAG_ON arms it; the capture starts at the next
+ *      reset (button), like a session recording.
+ *   2. It stops at the following reset, on CAPTURE without CAPTURE_FLAG_ON,
+ *      or when the buffer is full. With CAPTURE_FLAG_RING it overwrites the
+ *      oldest entries instead and keeps the last CAPTURE_CAPACITY ticks.
+ *   3. CAPTURE_DUMP streams the entries, oldest first, as CAPTURE frames.
+ *
+ * Per tick the control task copies one 32-byte entry; it never waits.
+ */
+
+// --- Command Opcodes ---
+// CAPTURE:      opcode | flags u8 -> ACK (STATE: cannot arm while a capture runs)
+// CAPTURE_DUMP: opcode -> a CAPTURE frame per entry, then an ACK (STATE while armed or running)
+// CAPTURE frame: type u8 | index u16 | count u16 | timestamp_us u32 | pulses i32
+//   | reference_rpm f32 | measured_rpm f32 | state f32 x 2 | u_k f32
+//   | controller u8 (little endian; index 0 is the oldest entry of count)
+#define CAPTURE_CMD      0x33
+#define CAPTURE_CMD_DUMP 0x34
+#define CAPTURE_FLAG_ON   0x01
+#define CAPTURE_FLAG_RING 0x02
+
+#define CAPTURE_FRAME_LEN 34
+
+// Entries of the buffer (a power of two). In internal RAM by default; with
+// PSRAM mapped for .bss (CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY) the
+// buffer moves there and grows to 1 MB.
+#ifndef CAPTURE_CAPACITY
+#if defined(ESP_PLATFORM) && CAPTURE_BUFFER
+#include "sdkconfig.h"
+#endif
+#ifdef CONFIG_SPIRAM_ALLOW_BSS_SEG_EXTERNAL_MEMORY
+#define CAPTURE_CAPACITY 32768
+#else
+#define CAPTURE_CAPACITY 2048
+#endif
+#endif
+
+/**
+ * @brief State of axis 0 at the end of one control tick.
+ */
+typedef struct {
+    uint32_t timestamp_us;  // Start of the step.
+    int32_t pulses;         // Raw encoder pulses of the window.
+    float reference_rpm;
+    float measured_rpm;     // Filtered speed (error = reference_rpm - measured_rpm).
+    float state[2];         // Internal states of the active controller.
+    float u_k;              // Output (duty = DUTY_CYCLE_MIN + u_k * range).
+    uint8_t controller;     // Active controller (registry id).
+} capture_entry_t;
+
+#if CAPTURE_BUFFER
+
+/**
+ * @brief Clears the buffer and registers the CAPTURE and CAPTURE_DUMP command handlers.
+ */
+void capture_buffer_init(void);
+
+/**
+ * @brief Arms a capture, as CAPTURE with CAPTURE_FLAG_ON does (command task).
+ * @param ring_mode Keep the latest ticks instead of stopping when full.
+ * @return false while a capture runs.
+ */
+bool capture_buffer_arm(bool ring_mode);
+
+/**
+ * @brief The run was reset (control task only): starts an armed capture or
+ * ends a running one.
+ */
+void capture_buffer_reset(void);
+
+/**
+ * @brief Stores the tick that just ran while a capture runs (control task only).
+ * @param sample Sample of axis 0.
+ * @param pulses Raw encoder pulses of axis 0 in this tick.
+ * @param controller Active controller of axis 0.
+ */
+void capture_buffer_tick(const telemetry_sample_t *sample, int32_t pulses, uint8_t controller);
+
+#endif // CAPTURE_BUFFER
+
+#endif //header guard
@@ -0,0 +1,218 @@
+#include "control_params.h"
+#include <string.h>
+#include <math.h>
+#include <stdatomic.h>
+#include "command.h"
+#include "telemetry.h"
+#include "encoder_reader.h"
+
+// --- Published Parameter Block ---
+// Sequence lock: the sequence is odd while the command task writes the block.
+// Readers never wait (see control_params_read()). Only the command task writes.
+static control_params_t params;
+static atomic_uint params_seq;
+
+/**
+ * @brief Location of one controller parameter inside a block (NULL for the
+ * feedforward gains, see control_params_ff_field()).
+ */
+static real_T *control_params_field(control_params_t *block, uint8_t id) {
+    switch (id) {
+        case CONTROL_PARAM_PID_KP:          return &block->pid.Kp;
+        case CONTROL_PARAM_PID_KI:          return &block->pid.Ki;
+        case CONTROL_PARAM_PID_KD:          return &block->pid.Kd;
+        case CONTROL_PARAM_PID_N:           return &block->pid.N;
+        case CONTROL_PARAM_FUZZY_KP:        return &block->fuzzy.KP;
+        case CONTROL_PARAM_FUZZY_KI:        return &block->fuzzy.KI;
+        case CONTROL_PARAM_FUZZY_KD:        return &block->fuzzy.KD;
+        case CONTROL_PARAM_FUZZY_E_RANGE:   return &block->fuzzy.E_RANGE;
+        case CONTROL_PARAM_FUZZY_DE_RANGE:  return &block->fuzzy.DE_RANGE;
+        case CONTROL_PARAM_FUZZY_OUT_RANGE: return &block->fuzzy.OUT_RANGE;
+        default:                            return NULL;
+    }
+}
+
+/**
+ * @brief Location of one feedforward gain inside a block.
+ */
+static float *control_params_ff_field(control_params_t *block, uint8_t id) {
+    switch (id) {
+        case CONTROL_PARAM_FF_KS: return &block->feedforward.ks;
+        case CONTROL_PARAM_FF_KV: return &block->feedforward.kv;
+        case CONTROL_PARAM_FF_KA: return &block->feedforward.ka;
+        default:                  return NULL;
+    }
+}
+
+float control_params_get_value(control_params_t *block, uint8_t id) {
+    real_T *field = control_params_field(block, id);
+    return field != NULL ? (float)*field : *control_params_ff_field(block, id);
+}
+
+bool control_params_is_float(control_params_t *block, uint8_t id) {
+    real_T *field = control_params_field(block, id);
+    return field == NULL || (real_T)(float)*field == *field;
+}
+
+/**
+ * @brief Writes one parameter of a block (id below CONTROL_PARAM_COUNT).
+ */
+static void control_params_set_value(control_params_t *block, uint8_t id, float value) {
+    real_T *field = control_params_field(block, id);
+    if (field != NULL) {
+        *field = (real_T)value;
+    } else {
+        *control_params_ff_field(block, id) = value;
+    }
+}
+
+/**
+ * @brief Range check of one value. Every value must be finite. Gains may
+ * not be negative; the PID global gain, the filter coefficient and the
+ * universes must be positive. The feedforward offset may have either sign.
+ */
+static bool control_params_valid(uint8_t id, float value) {
+    if (!isfinite(value)) { // NaN or +-Inf
+        return false;
+    }
+    switch (id) {
+        case CONTROL_PARAM_FF_KS:
+            return true;
+        case CONTROL_PARAM_PID_KP:
+        case CONTROL_PARAM_PID_N:
+        case CONTROL_PARAM_FUZZY_E_RANGE:
+        case CONTROL_PARAM_FUZZY_DE_RANGE:
+        case CONTROL_PARAM_FUZZY_OUT_RANGE:
+            return value > 0.0f;
+        default:
+            return value >= 0.0f;
+    }
+}
+
+uint32_t control_params_version(void) {
+    return atomic_load_explicit(&params_seq, memory_order_acquire) / 2;
+}
+
+bool control_params_read(control_params_t *out, uint32_t *version) {
+    unsigned before = atomic_load_explicit(&params_seq, memory_order_acquire);
+    if (before & 1u) {
+        return false; // Being written
+    }
+    *out = params;
+    atomic_thread_fence(memory_order_acquire);
+    unsigned after = atomic_load_explicit(&params_seq, memory_order_relaxed);
+    *version = before / 2;
+    return before == after;
+}
+
+/**
+ * @brief Publishes a new block (command task only).
+ */
+static void control_params_publish(const control_params_t *block) {
+    unsigned seq = atomic_load_explicit(&params_seq, memory_order_relaxed);
+    atomic_store_explicit(&params_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    params = *block;
+    atomic_store_explicit(&params_seq, seq + 2, memory_order_release);
+}
+
+void control_params_apply_pid(RT_MODEL_simulink_control_T *const rtM, const P_simulink_control_T *new_params) {
+    real_T old_kp = rtM->defaultParam->Kp;
+    if (old_kp != new_params->Kp && new_params->Kp > (real_T)0.0) {
+        rtM->dwork->Integrator_DSTATE *= old_kp / new_params->Kp;
+    }
+    *rtM->defaultParam = *new_params;
+    // The integrator gain depends on Ki.
+    simulink_control_discretize_r(rtM, rtM->dwork->Ts);
+}
+
+void control_params_apply_fuzzy(RT_MODEL_PID_Difuso_T *const rtM, const P_PID_Difuso_T *new_params) {
+    real_T old_ki = rtM->defaultParam->KI;
+    if (old_ki != new_params->KI && new_params->KI > (real_T)0.0) {
+        rtM->dwork->DiscreteTimeIntegrator_DSTATE *= old_ki / new_params->KI;
+    }
+    *rtM->defaultParam = *new_params;
+}
+
+// --- Little-endian helpers for the command payloads ---
+static float get_f32(const uint8_t *p) {
+    uint32_t bits = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @brief Builds the PARAMS reply from the current block.
+ */
+static size_t control_params_reply(uint8_t *reply) {
+    control_params_t block;
+    uint32_t version = 0;
+    // The command task is the only writer, so this read cannot fail here.
+    control_params_read(&block, &version);
+
+    reply[0] = TELEMETRY_FRAME_PARAMS;
+    put_u32(&reply[1], version);
+    reply[5] = CONTROL_PARAM_COUNT;
+    for (uint8_t id = 0; id < CONTROL_PARAM_COUNT; id++) {
+        float value = control_params_get_value(&block, id);
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        put_u32(&reply[6 + 4 * id], bits);
+    }
+    return 6 + 4 * CONTROL_PARAM_COUNT;
+}
+
+static size_t control_params_cmd_get(const uint8_t *payload, size_t len, uint8_t *reply) {
+    if (len != 1) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+    }
+    return control_params_reply(reply);
+}
+
+static size_t control_params_cmd_set(const uint8_t *payload, size_t len, uint8_t *reply) {
+    if (len < 6 || (len - 1) % 5 != 0) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+    }
+
+    // Validate everything on a copy, then publish it in one go.
+    control_params_t block;
+    uint32_t version;
+    control_params_read(&block, &version);
+    for (size_t pos = 1; pos < len; pos += 5) {
+        uint8_t id = payload[pos];
+        float value = get_f32(&payload[pos + 1]);
+        if (id >= CONTROL_PARAM_COUNT) {
+            return command_ack(reply, payload[0], COMMAND_STATUS_BAD_ID);
+        }
+        if (!control_params_valid(id, value)) {
+            return command_ack(reply, payload[0], COMMAND_STATUS_BAD_VALUE);
+        }
+        control_params_set_value(&block, id, value);
+    }
+    control_params_publish(&block);
+    return control_params_reply(reply);
+}
+
+void control_params_init(void) {
+    control_params_t block;
+    block.pid = simulink_control_P;
+#if ENCODER_OBSERVER
+    block.pid.Kp = (real_T)ENCODER_OBSERVER_PID_KP;
+    block.pid.Ki = (real_T)ENCODER_OBSERVER_PID_KI;
+    block.pid.Kd = (real_T)ENCODER_OBSERVER_PID_KD;
+#endif
+    block.fuzzy = PID_Difuso_P;
+    memset(&block.feedforward, 0, sizeof(block.feedforward));
+    control_params_publish(&block);
+
+    command_register(CONTROL_CMD_PARAM_GET, control_params_cmd_get);
+    command_register(CONTROL_CMD_PARAM_SET, control_params_cmd_set);
+}
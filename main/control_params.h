@@ -0,0 +1,99 @@
+#ifndef CONTROL_PARAMS_H //header guard
+#define CONTROL_PARAMS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "simulink_control.h"
+#include "PID_Difuso.h"
+#include "feedforward.h"
+
+// --- Command Opcodes ---
+// PARAM_GET: opcode                              -> TELEMETRY_FRAME_PARAMS
+// PARAM_SET: opcode | (id u8 | value f32) x n    -> TELEMETRY_FRAME_PARAMS, or an ACK with the error
+// A SET is validated as a whole and published as one new version, so the
+// control task sees either none or all of its values.
+#define CONTROL_CMD_PARAM_GET 0x10
+#define CONTROL_CMD_PARAM_SET 0x11
+
+// PARAMS reply: type u8 | version u32 | count u8 | value f32 x count (ordered by id)
+
+/**
+ * @brief Identifiers of the runtime parameters.
+ */
+typedef enum {
+    CONTROL_PARAM_PID_KP = 0,
+    CONTROL_PARAM_PID_KI,
+    CONTROL_PARAM_PID_KD,
+    CONTROL_PARAM_PID_N,
+    CONTROL_PARAM_FUZZY_KP,
+    CONTROL_PARAM_FUZZY_KI,
+    CONTROL_PARAM_FUZZY_KD,
+    CONTROL_PARAM_FUZZY_E_RANGE,
+    CONTROL_PARAM_FUZZY_DE_RANGE,
+    CONTROL_PARAM_FUZZY_OUT_RANGE,
+    CONTROL_PARAM_FF_KS,
+    CONTROL_PARAM_FF_KV,
+    CONTROL_PARAM_FF_KA,
+    CONTROL_PARAM_COUNT
+} control_param_id_t;
+
+/**
+ * @brief The runtime parameter block: the parameters of both controllers
+ * and the feedforward gains shared by every axis.
+ */
+typedef struct {
+    P_simulink_control_T pid;
+    P_PID_Difuso_T fuzzy;
+    feedforward_params_t feedforward;
+} control_params_t;
+
+/**
+ * @brief Loads the defaults (the parameters of the global controller
+ * instances, feedforward off) and registers the PARAM_GET / PARAM_SET command handlers.
+ */
+void control_params_init(void);
+
+/**
+ * @brief Version of the parameter block; it changes with every accepted SET.
+ */
+uint32_t control_params_version(void);
+
+/**
+ * @brief Copies the parameter block without blocking.
+ * Safe from the control task: if an update is being written at that moment
+ * it returns false and the caller simply tries again at the next tick.
+ * @param params Destination.
+ * @param version Version of the copied block.
+ * @return true if a consistent copy was made.
+ */
+bool control_params_read(control_params_t *params, uint32_t *version);
+
+/**
+ * @brief Reads one parameter of a block (id below CONTROL_PARAM_COUNT) as a float.
+ */
+float control_params_get_value(control_params_t *block, uint8_t id);
+
+/**
+ * @brief true if the parameter holds exactly its float value. Every value
+ * set over the command channel does; a compiled default may not (real_T = double).
+ */
+bool control_params_is_float(control_params_t *block, uint8_t id);
+
+/**
+ * @brief Applies a parameter set to a PID instance without a bump in u_k:
+ * the integrator enters the output as Kp * Integrator_DSTATE, so it is
+ * rescaled by Kp_old / Kp_new before the new parameters are copied. The
+ * integrator gain Ki * Ts is then recomputed. N only scales the D output:
+ * the derivative filter pole stays at the generated 10 ms value, rescaled
+ * for Ts.
+ */
+void control_params_apply_pid(RT_MODEL_simulink_control_T *const rtM, const P_simulink_control_T *params);
+
+/**
+ * @brief Applies a parameter set to a fuzzy PID instance without a bump in
+ * the integral part (KI * DiscreteTimeIntegrator_DSTATE).
+ */
+void control_params_apply_fuzzy(RT_MODEL_PID_Difuso_T *const rtM, const P_PID_Difuso_T *params);
+
+#endif //header guard
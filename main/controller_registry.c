@@ -0,0 +1,167 @@
+#include "controller_registry.h"
+#include <stdbool.h>
+#include <string.h>
+
+static const controller_ops_t *registry[CONTROLLER_MAX_COUNT];
+static uint8_t registry_count = 0;
+static bool registry_initialized = false;
+
+// ===================================================================
+// ===== CONVENTIONAL PID (simulink_control) =========================
+typedef struct {
+    P_simulink_control_T P;
+    DW_simulink_control_T DW;
+    ExtU_simulink_control_T U;
+    ExtY_simulink_control_T Y;
+    RT_MODEL_simulink_control_T M;
+} pid_instance_t;
+
+static pid_instance_t pid_pool[CONTROLLER_MAX_INSTANCES];
+static uint8_t pid_used = 0;
+
+static void *pid_create(const control_params_t *params, uint32_t period_ms) {
+    if (pid_used >= CONTROLLER_MAX_INSTANCES) {
+        return NULL;
+    }
+    pid_instance_t *inst = &pid_pool[pid_used++];
+    memset(inst, 0, sizeof(*inst));
+    inst->P = params->pid;
+    inst->M.defaultParam = &inst->P;
+    inst->M.dwork = &inst->DW;
+    inst->M.inputs = &inst->U;
+    inst->M.outputs = &inst->Y;
+    simulink_control_discretize_r(&inst->M, (real_T)period_ms / (real_T)1000.0);
+    simulink_control_initialize_r(&inst->M);
+    return inst;
+}
+
+static void pid_reset(void *instance) {
+    simulink_control_initialize_r(&((pid_instance_t *)instance)->M);
+}
+
+static float pid_step(void *instance, float error, float state[2]) {
+    pid_instance_t *inst = instance;
+    inst->U.error_signal = error;
+    simulink_control_step_r(&inst->M);
+    state[0] = inst->DW.Integrator_DSTATE;
+    state[1] = inst->DW.FilterDifferentiatorTF_states;
+    return inst->Y.u_k;
+}
+
+static void pid_apply_params(void *instance, const control_params_t *params) {
+    control_params_apply_pid(&((pid_instance_t *)instance)->M, &params->pid);
+}
+
+static void pid_track(void *instance, float u_k, float error) {
+    simulink_control_track_r(&((pid_instance_t *)instance)->M, u_k, error);
+}
+
+static const controller_ops_t pid_ops = {
+    .name = "pid",
+    .create = pid_create,
+    .reset = pid_reset,
+    .step = pid_step,
+    .apply_params = pid_apply_params,
+    .track = pid_track,
+};
+
+// ===================================================================
+// ===== FUZZY PID (PID_Difuso) ======================================
+typedef struct {
+    P_PID_Difuso_T P;
+    DW_PID_Difuso_T DW;
+    ExtU_PID_Difuso_T U;
+    ExtY_PID_Difuso_T Y;
+    RT_MODEL_PID_Difuso_T M;
+} fuzzy_instance_t;
+
+static fuzzy_instance_t fuzzy_pool[CONTROLLER_MAX_INSTANCES];
+static uint8_t fuzzy_used = 0;
+
+static void *fuzzy_create(const control_params_t *params, uint32_t period_ms) {
+    if (fuzzy_used >= CONTROLLER_MAX_INSTANCES) {
+        return NULL;
+    }
+    fuzzy_instance_t *inst = &fuzzy_pool[fuzzy_used++];
+    memset(inst, 0, sizeof(*inst));
+    inst->P = params->fuzzy;
+    inst->M.defaultParam = &inst->P;
+    inst->M.dwork = &inst->DW;
+    inst->M.inputs = &inst->U;
+    inst->M.outputs = &inst->Y;
+    PID_Difuso_discretize_r(&inst->M, (real_T)period_ms / (real_T)1000.0);
+    PID_Difuso_initialize_r(&inst->M);
+    return inst;
+}
+
+static void fuzzy_reset(void *instance) {
+    PID_Difuso_initialize_r(&((fuzzy_instance_t *)instance)->M);
+}
+
+static float fuzzy_step(void *instance, float error, float state[2]) {
+    fuzzy_instance_t *inst = instance;
+    inst->U.error_signal = error;
+    PID_Difuso_step_r(&inst->M);
+    state[0] = inst->DW.DiscreteTimeIntegrator_DSTATE;
+    state[1] = inst->DW.UD_DSTATE;
+    // The output universe [0, OUT_RANGE] maps to u_k in [0, 1]; OUT_RANGE is a
+    // runtime parameter, so the scale follows the instance's own value.
+    return inst->Y.out / inst->P.OUT_RANGE;
+}
+
+static void fuzzy_apply_params(void *instance, const control_params_t *params) {
+    control_params_apply_fuzzy(&((fuzzy_instance_t *)instance)->M, &params->fuzzy);
+}
+
+static void fuzzy_track(void *instance, float u_k, float error) {
+    fuzzy_instance_t *inst = instance;
+    PID_Difuso_track_r(&inst->M, (real_T)u_k * inst->P.OUT_RANGE, error);
+}
+
+static const controller_ops_t fuzzy_ops = {
+    .name = "fuzzy",
+    .create = fuzzy_create,
+    .reset = fuzzy_reset,
+    .step = fuzzy_step,
+    .apply_params = fuzzy_apply_params,
+    .track = fuzzy_track,
+};
+
+// ===================================================================
+// ===== REGISTRY ====================================================
+void controller_registry_init(void) {
+    if (registry_initialized) {
+        return;
+    }
+    registry_initialized = true;
+    registry[CONTROLLER_ID_PID] = &pid_ops;
+    registry[CONTROLLER_ID_FUZZY] = &fuzzy_ops;
+    registry_count = 2;
+}
+
+int controller_register(const controller_ops_t *ops) {
+    // The built-in controllers always take the first ids.
+    controller_registry_init();
+    if (registry_count >= CONTROLLER_MAX_COUNT) {
+        return -1;
+    }
+    registry[registry_count] = ops;
+    return registry_count++;
+}
+
+const controller_ops_t *controller_get(uint8_t id) {
+    return id < registry_count ? registry[id] : NULL;
+}
+
+int controller_find(const char *name) {
+    for (uint8_t i = 0; i < registry_count; i++) {
+        if (strcmp(registry[i]->name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint8_t controller_count(void) {
+    return registry_count;
+}
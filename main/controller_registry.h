@@ -0,0 +1,87 @@
+#ifndef CONTROLLER_REGISTRY_H //header guard
+#define CONTROLLER_REGISTRY_H
+
+#include <stdint.h>
+#include "control_params.h"
+
+// --- Registry Limits ---
+// Controllers that can be registered, and instances each built-in controller
+// can hand out (one per axis).
+#define CONTROLLER_MAX_COUNT     4
+#define CONTROLLER_MAX_INSTANCES 4
+
+// --- Built-in Controllers ---
+// Registered first, in this order, so these are their ids.
+#define CONTROLLER_ID_PID   0 // Conventional PID (simulink_control)
+#define CONTROLLER_ID_FUZZY 1 // Fuzzy PID (PID_Difuso)
+
+/**
+ * @brief Common interface of a speed controller.
+ *
+ * Every axis holds one instance of each registered controller and steps only
+ * the active one. The instance is opaque to the caller. Apart from create(),
+ * every function runs in the control task of the axis and must not block.
+ */
+typedef struct {
+    const char *name;  // Short name used by commands and reports.
+
+    /**
+     * @brief Takes an instance from the controller's static pool, discretizes
+     * it for the control period and resets it (startup only). Returns NULL
+     * when the pool is exhausted.
+     */
+    void *(*create)(const control_params_t *params, uint32_t period_ms);
+
+    /**
+     * @brief Clears the states of an instance.
+     */
+    void (*reset)(void *instance);
+
+    /**
+     * @brief Runs one step.
+     * @param error Reference minus measured speed (RPM).
+     * @param state Receives the two internal states sent over telemetry.
+     * @return The normalized control signal, before the [0, 1] clamp.
+     */
+    float (*step)(void *instance, float error, float state[2]);
+
+    /**
+     * @brief Applies a new parameter block without a bump in the output.
+     */
+    void (*apply_params)(void *instance, const control_params_t *params);
+
+    /**
+     * @brief Primes the states so that the next step with 'error' outputs
+     * about 'u_k'. Called when the axis switches to this controller.
+     */
+    void (*track)(void *instance, float u_k, float error);
+} controller_ops_t;
+
+/**
+ * @brief Registers the built-in controllers (PID, then fuzzy PID) once.
+ */
+void controller_registry_init(void);
+
+/**
+ * @brief Adds a controller to the registry, after the built-in ones (also
+ * when called before controller_registry_init()). The table must stay valid.
+ * @return Its id, or -1 if the registry is full.
+ */
+int controller_register(const controller_ops_t *ops);
+
+/**
+ * @brief The controller with the given id, or NULL.
+ */
+const controller_ops_t *controller_get(uint8_t id);
+
+/**
+ * @brief Id of the controller with the given name, or -1.
+ */
+int controller_find(const char *name);
+
+/**
+ * @brief Number of registered controllers.
+ */
+uint8_t controller_count(void);
+
+#endif //header guard
@@ -0,0 +1,126 @@
+#include "loop_profiler.h"
+
+#if LOOP_PROFILER
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "esp_rom_sys.h"
+#include "command.h"
+
+static const char *const stage_names[LOOP_STAGE_COUNT] = {
+    "reference", "axes", "encoder", "controller", "pwm", "metrics", "telemetry", "total"
+};
+
+// Written by the control task only; read (without locking) by the command task.
+static loop_stage_stats_t stages[LOOP_STAGE_COUNT];
+static loop_jitter_stats_t jitter;
+static uint32_t nominal_cycles = 0;
+static uint32_t last_tick_cycles = 0;
+static bool have_last_tick = false;
+static atomic_bool clear_requested;
+
+/**
+ * @brief Histogram bucket of a duration: its bit length (0 for 0 cycles),
+ * with the last bucket taking everything longer.
+ */
+static inline uint32_t loop_profiler_bucket(uint32_t cycles) {
+    uint32_t bits = cycles == 0 ? 0 : (uint32_t)(32 - __builtin_clz(cycles));
+    return bits < LOOP_PROFILER_BUCKETS ? bits : LOOP_PROFILER_BUCKETS - 1;
+}
+
+static void loop_profiler_reset_stats(void) {
+    memset(stages, 0, sizeof(stages));
+    memset(&jitter, 0, sizeof(jitter));
+    have_last_tick = false;
+}
+
+/**
+ * @brief PROFILE_GET command handler (command task).
+ */
+static size_t loop_profiler_cmd_get(const uint8_t *payload, size_t len, uint8_t *reply) {
+    if (len != 2) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+    }
+    loop_profiler_print();
+    if (payload[1] & LOOP_PROFILE_FLAG_CLEAR) {
+        loop_profiler_clear();
+    }
+    return command_ack(reply, payload[0], COMMAND_STATUS_OK);
+}
+
+void loop_profiler_init(uint32_t period_us) {
+    nominal_cycles = period_us * esp_rom_get_cpu_ticks_per_us();
+    loop_profiler_reset_stats();
+    atomic_init(&clear_requested, false);
+    command_register(LOOP_PROFILE_CMD_GET, loop_profiler_cmd_get);
+}
+
+uint32_t loop_profiler_tick(void) {
+    uint32_t now = esp_cpu_get_cycle_count();
+    if (atomic_exchange_explicit(&clear_requested, false, memory_order_acquire)) {
+        loop_profiler_reset_stats();
+    }
+    if (have_last_tick) {
+        int32_t deviation = (int32_t)(now - last_tick_cycles - nominal_cycles);
+        uint32_t magnitude = deviation < 0 ? (uint32_t)-deviation : (uint32_t)deviation;
+        if (jitter.count == 0 || deviation < jitter.min) jitter.min = deviation;
+        if (jitter.count == 0 || deviation > jitter.max) jitter.max = deviation;
+        jitter.sum_abs += magnitude;
+        jitter.histogram[loop_profiler_bucket(magnitude)]++;
+        jitter.count++;
+    }
+    last_tick_cycles = now;
+    have_last_tick = true;
+    return now;
+}
+
+void loop_profiler_record(loop_stage_t stage, uint32_t cycles) {
+    loop_stage_stats_t *s = &stages[stage];
+    if (s->count == 0 || cycles < s->min) s->min = cycles;
+    if (cycles > s->max) s->max = cycles;
+    s->sum += cycles;
+    s->histogram[loop_profiler_bucket(cycles)]++;
+    s->count++;
+}
+
+void loop_profiler_get(loop_stage_t stage, loop_stage_stats_t *stats, loop_jitter_stats_t *jitter_stats) {
+    *stats = stages[stage];
+    *jitter_stats = jitter;
+}
+
+/**
+ * @brief Prints the non-empty histogram buckets as " hist=b:n,b:n".
+ */
+static void loop_profiler_print_histogram(const uint32_t *histogram) {
+    const char *sep = ";hist=";
+    for (int b = 0; b < LOOP_PROFILER_BUCKETS; b++) {
+        if (histogram[b] > 0) {
+            printf("%s%d:%lu", sep, b, (unsigned long)histogram[b]);
+            sep = ",";
+        }
+    }
+    printf("\n");
+}
+
+void loop_profiler_print(void) {
+    loop_jitter_stats_t j;
+    for (int i = 0; i < LOOP_STAGE_COUNT; i++) {
+        loop_stage_stats_t s;
+        loop_profiler_get((loop_stage_t)i, &s, &j);
+        printf("PROFILE:stage=%s;count=%lu;min=%lu;mean=%lu;max=%lu",
+               stage_names[i], (unsigned long)s.count, (unsigned long)s.min,
+               (unsigned long)(s.count > 0 ? s.sum / s.count : 0), (unsigned long)s.max);
+        loop_profiler_print_histogram(s.histogram);
+    }
+    printf("PROFILE_JITTER:count=%lu;nominal=%lu;min=%ld;max=%ld;mean_abs=%lu",
+           (unsigned long)j.count, (unsigned long)nominal_cycles, (long)j.min, (long)j.max,
+           (unsigned long)(j.count > 0 ? j.sum_abs / j.count : 0));
+    loop_profiler_print_histogram(j.histogram);
+}
+
+void loop_profiler_clear(void) {
+    atomic_store_explicit(&clear_requested, true, memory_order_release);
+}
+
+#endif // LOOP_PROFILER
@@ -0,0 +1,125 @@
+#ifndef LOOP_PROFILER_H //header guard
+#define LOOP_PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 1 = time every stage of the control loop with the CPU cycle counter
+// (idf.py -DLOOP_PROFILER=ON build). At 0 the macros below expand to nothing
+// and the profiler adds no code, data or command.
+#ifndef LOOP_PROFILER
+#define LOOP_PROFILER 0
+#endif
+
+// --- Command Opcodes ---
+// PROFILE_GET: opcode | flags u8 -> ACK; the command task prints one PROFILE:
+// line per stage and a PROFILE_JITTER: line. LOOP_PROFILE_FLAG_CLEAR starts
+// new statistics at the next tick.
+#define LOOP_PROFILE_CMD_GET    0x31
+#define LOOP_PROFILE_FLAG_CLEAR 0x01
+
+// Axis whose stages are timed (the one sent over telemetry).
+#define LOOP_PROFILER_AXIS 0
+// Histogram buckets: bucket b counts durations of 2^(b-1) to 2^b - 1 cycles
+// (bucket 0 counts zero, the last bucket everything longer).
+#define LOOP_PROFILER_BUCKETS 32
+
+/**
+ * @brief Stages of one control period.
+ */
+typedef enum {
+    LOOP_STAGE_REFERENCE = 0,   // trajectory_stream_reference()
+    LOOP_STAGE_AXES,            // axis_control_run(): every axis of the control tick core
+    LOOP_STAGE_ENCODER,         // encoder_get_rpm_axis() (LOOP_PROFILER_AXIS only, as the next two)
+    LOOP_STAGE_CONTROLLER,      // Controller step and feedforward
+    LOOP_STAGE_PWM,             // motor_set_duty_cycle_channel()
+    LOOP_STAGE_METRICS,         // run_metrics_update()
+    LOOP_STAGE_TELEMETRY,       // telemetry_send_sample()
+    LOOP_STAGE_TOTAL,           // The whole control_step()
+    LOOP_STAGE_COUNT
+} loop_stage_t;
+
+/**
+ * @brief Statistics of one stage, in CPU cycles.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t histogram[LOOP_PROFILER_BUCKETS];
+} loop_stage_stats_t;
+
+/**
+ * @brief Tick-to-tick deviation from the nominal period, in CPU cycles.
+ */
+typedef struct {
+    uint32_t count;
+    int32_t min;
+    int32_t max;
+    uint64_t sum_abs;
+    uint32_t histogram[LOOP_PROFILER_BUCKETS]; // Of |deviation|
+} loop_jitter_stats_t;
+
+#if LOOP_PROFILER
+
+#include "esp_cpu.h"
+
+/**
+ * @brief Clears the statistics and registers the PROFILE_GET command handler.
+ * @param period_us The nominal control period.
+ */
+void loop_profiler_init(uint32_t period_us);
+
+/**
+ * @brief Marks the start of a control period: applies a pending clear and
+ * records the jitter (control task only).
+ * @return The cycle count at the start of the period.
+ */
+uint32_t loop_profiler_tick(void);
+
+/**
+ * @brief Adds one duration to a stage (control task only).
+ */
+void loop_profiler_record(loop_stage_t stage, uint32_t cycles);
+
+/**
+ * @brief Copies the statistics of one stage and the jitter. Can be slightly
+ * inconsistent if the control task records at the same time.
+ */
+void loop_profiler_get(loop_stage_t stage, loop_stage_stats_t *stats, loop_jitter_stats_t *jitter);
+
+/**
+ * @brief Prints a PROFILE: line per stage and a PROFILE_JITTER: line (cycles,
+ * with the histogram as bucket:count pairs of the non-empty buckets).
+ */
+void loop_profiler_print(void);
+
+/**
+ * @brief Requests new statistics; the control task clears them at its next tick.
+ */
+void loop_profiler_clear(void);
+
+// Starts timing in a local variable.
+#define LOOP_PROFILE_START(var)       uint32_t var = esp_cpu_get_cycle_count()
+// Records the time since 'var' for a stage and restarts 'var', so consecutive
+// stages cost one counter read each.
+#define LOOP_PROFILE_LAP_IF(cond, stage, var)                           \
+    do {                                                                \
+        uint32_t lap_now_ = esp_cpu_get_cycle_count();                  \
+        if (cond) loop_profiler_record((stage), lap_now_ - (var));      \
+        (var) = lap_now_;                                               \
+    } while (0)
+#define LOOP_PROFILE_LAP(stage, var)  LOOP_PROFILE_LAP_IF(true, stage, var)
+#define LOOP_PROFILE_TICK(var)        uint32_t var = loop_profiler_tick()
+
+#else
+
+#define LOOP_PROFILE_START(var)                 ((void)0)
+#define LOOP_PROFILE_LAP_IF(cond, stage, var)   ((void)0)
+#define LOOP_PROFILE_LAP(stage, var)            ((void)0)
+#define LOOP_PROFILE_TICK(var)                  ((void)0)
+
+#endif // LOOP_PROFILER
+
+#endif //header guard
@@ -1,5 +1,5 @@
 #include <stdio.h>
-#include <math.h> // Para pow()
+#include <stdatomic.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
@@ -8,23 +8,67 @@
 
 #include "motor_control.h"
 #include "encoder_reader.h"
+#include "axis_io.h"
 #include "trajectory_generator.h"
 #include "simulink_control.h"
 #include "PID_Difuso.h"
+#include "control_tick.h"
+#include "telemetry.h"
+#include "axis_control.h"
+#include "control_params.h"
+#include "controller_registry.h"
+#include "trajectory_stream.h"
+#include "run_metrics.h"
+#include "loop_profiler.h"
+#include "session_record.h"
+#include "capture_buffer.h"
+#include "command.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
 
 // ===================================================================
 // ===== CONTROLLER SELECTION ========================================
+// Controller of axis 0 at startup; it can be switched at runtime with the
+// SELECT_CONTROLLER command (see axis_control.h).
 #define USE_FUZZY_PID 0 // 0 = Conventional PID, 1 = Fuzzy PID
 // ===================================================================
 
-#define SIMULATE_ENCODER 0 // 1 = Simulate, 0 = Real Encoder
+// Motor + encoder backend of the axes: &axis_io_esp32 drives the real motor,
+// &axis_io_sim replaces it by a first-order model (no hardware needed) and
+// &axis_io_replay plays back recorded speeds (see axis_io.h).
+#define AXIS_IO (&axis_io_esp32)
 
-const int TS_MS = 10;
-#define RESET_BUTTON_PIN GPIO_NUM_0
+// ===================================================================
+// ===== AXIS CONFIGURATION ==========================================
+// Number of motors in use (1 to AXIS_MAX_COUNT). Axis 0 is the original
+// motor; it runs on the control tick core and is the one sent over telemetry.
+#define AXIS_COUNT 1
 
-// --- Global variables for MSE calculation ---
-static double sum_squared_error = 0.0;
-static long sample_count = 0;
+static const axis_config_t axis_table[AXIS_MAX_COUNT] = {
+    { .pwm_pin = PWM_PIN, .pwm_channel = PWM_CHANNEL, .enc_a_pin = ENC_A_PIN, .enc_b_pin = ENC_B_PIN,
+      .filter_alpha = RPM_FILTER_ALPHA, .controller = USE_FUZZY_PID ? CONTROLLER_ID_FUZZY : CONTROLLER_ID_PID,
+      .core = 1, .io = AXIS_IO },
+    { .pwm_pin = 14, .pwm_channel = 1, .enc_a_pin = 16, .enc_b_pin = 17,
+      .filter_alpha = RPM_FILTER_ALPHA, .controller = CONTROLLER_ID_PID,
+      .core = 0, .io = AXIS_IO },
+    { .pwm_pin = 27, .pwm_channel = 2, .enc_a_pin = 18, .enc_b_pin = 19,
+      .filter_alpha = RPM_FILTER_ALPHA, .controller = CONTROLLER_ID_PID,
+      .core = 1, .io = AXIS_IO },
+    { .pwm_pin = 23, .pwm_channel = 3, .enc_a_pin = 21, .enc_b_pin = 22,
+      .filter_alpha = RPM_FILTER_ALPHA, .controller = CONTROLLER_ID_PID,
+      .core = 0, .io = AXIS_IO },
+};
+// ===================================================================
+
+// Control period (idf.py -DCONTROL_PERIOD_MS=<ms> build). The controllers are
+// discretized for it; RPM_FILTER_ALPHA is per period, so keep its time
+// constant in mind at faster rates.
+#ifndef CONTROL_PERIOD_MS
+#define CONTROL_PERIOD_MS 10
+#endif
+const int TS_MS = CONTROL_PERIOD_MS;
+#define RESET_BUTTON_PIN GPIO_NUM_0
+#define RESET_HOLDOFF_MS 500
 
 // --- Configure Reset Button (no changes) ---
 static void configure_reset_button(void) {
@@ -39,97 +83,235 @@ static void configure_reset_button(void) {
     printf("Reset button configured on GPIO %d\n", RESET_BUTTON_PIN);
 }
 
-void app_main(void) {
-    // --- Initializations (no changes) ---
-    motor_init();
-    #if !SIMULATE_ENCODER
-    encoder_init();
-    #endif
-    configure_reset_button();
-    simulink_control_initialize();
-    PID_Difuso_initialize();
+// --- Control loop state ---
+static uint32_t time_counter_ms = 0;
+// Ticks left to skip after a reset (replaces the old blocking 500 ms delay).
+static uint32_t reset_holdoff_ticks = 0;
+// Start of the current statistics window (encoder ISR load).
+static uint64_t stats_start_us = 0;
 
-    #if USE_FUZZY_PID
-    printf("Initializing system with FUZZY PID control...\n");
-    #else
-    printf("Initializing system with Conventional PID control...\n");
-    #endif
-    #if SIMULATE_ENCODER
-    printf("!!! ENCODER SIMULATION MODE ACTIVE !!!\n");
-    #endif
-    printf("---------------------------------------------------------\n");
+// --- End-of-run report ---
+// The control task only takes a snapshot of the statistics at a reset; the
+// app_main task (lowest priority) formats and prints it, so no printf runs
+// inside the control step. A reset that comes while the previous report is
+// still being printed takes no snapshot.
+typedef struct {
+    control_tick_stats_t tick;
+    axis_timing_t timing[AXIS_MAX_COUNT];
+    uint8_t controller[AXIS_MAX_COUNT];
+    uint32_t worker_overruns;
+    encoder_isr_stats_t isr[AXIS_MAX_COUNT];
+    uint64_t isr_window_us;     // Length of the encoder ISR statistics window
+    trajectory_queue_stats_t traj;
+    telemetry_stats_t tx;
+} run_report_t;
 
-    uint32_t time_counter_ms = 0;
-    static float simulated_rpm = 0.0f;
-    sum_squared_error = 0.0;
-    sample_count = 0;
+static run_report_t run_report;
+static atomic_bool report_pending;
+static TaskHandle_t report_task = NULL;
 
-    while (1) {
-        // --- Reset Logic and MSE Calculation ---
-        if (gpio_get_level(RESET_BUTTON_PIN) == 0) {
-            // --- CAMBIO AQUÍ: Calcular y ENVIAR MSE por UART ---
-            if (sample_count > 0) {
-                double mse = sum_squared_error / sample_count;
-                // Send MSE result in a specific format for Python to catch
-                printf("MSE_RESULT:%.4f\n", mse); // <--- MENSAJE ESPECIAL
-            }
-            // --- FIN DEL CAMBIO ---
-
-            printf("--- RESET ---\n"); // Send reset signal to Python
-            time_counter_ms = 0;
-            simulink_control_initialize();
-            PID_Difuso_initialize();
-            simulated_rpm = 0.0f;
-            sum_squared_error = 0.0;
-            sample_count = 0;
-            vTaskDelay(pdMS_TO_TICKS(500));
-        }
+/**
+ * @brief Copies the statistics gathered since the last reset and wakes up the
+ * report task (control task only).
+ */
+static void take_run_report(void) {
+    if (atomic_exchange_explicit(&report_pending, true, memory_order_acquire)) {
+        return; // The previous report is still being printed
+    }
+    control_tick_get_stats(&run_report.tick);
+    for (uint8_t i = 0; i < axis_control_count(); i++) {
+        axis_control_get_timing(i, &run_report.timing[i]);
+        run_report.controller[i] = axis_control_active_controller(i);
+        encoder_get_isr_stats(i, &run_report.isr[i]);
+    }
+    run_report.worker_overruns = axis_control_worker_overruns();
+    run_report.isr_window_us = (uint64_t)esp_timer_get_time() - stats_start_us;
+    trajectory_stream_get_stats(&run_report.traj);
+    telemetry_get_stats(&run_report.tx);
+    xTaskNotifyGive(report_task);
+}
 
-        // --- Control Loop Logic (no changes below this point) ---
-        float t_seconds = time_counter_ms / 1000.0f;
-        float reference_rpm = trajectory_get_reference_rpm(t_seconds);
+/**
+ * @brief Prints the control tick timing statistics of a run and the counters
+ * of the telemetry pipeline (report task).
+ */
+static void print_run_report(const run_report_t *r) {
+    printf("TICK_STATS:ticks=%lu;overruns=%lu;jitter_min_us=%ld;jitter_max_us=%ld;jitter_mean_us=%.1f;exec_max_us=%lu\n",
+           (unsigned long)r->tick.ticks, (unsigned long)r->tick.overruns,
+           (long)r->tick.jitter_min_us, (long)r->tick.jitter_max_us,
+           r->tick.jitter_mean_abs_us, (unsigned long)r->tick.exec_max_us);
 
-        float measured_rpm;
-        #if SIMULATE_ENCODER
-            measured_rpm = simulated_rpm;
-        #else
-            measured_rpm = encoder_get_rpm(TS_MS);
-        #endif
+    for (uint8_t i = 0; i < axis_control_count(); i++) {
+        const axis_timing_t *timing = &r->timing[i];
+        printf("AXIS_STATS:axis=%u;controller=%s;steps=%lu;exec_min_us=%lu;exec_max_us=%lu;exec_mean_us=%.1f;start_lag_max_us=%lu\n",
+               (unsigned)i, controller_get(r->controller[i])->name,
+               (unsigned long)timing->steps, (unsigned long)timing->exec_min_us,
+               (unsigned long)timing->exec_max_us, timing->exec_mean_us,
+               (unsigned long)timing->start_lag_max_us);
+    }
+    printf("AXIS_WORKER:overruns=%lu\n", (unsigned long)r->worker_overruns);
 
-        float error = reference_rpm - measured_rpm;
+    // CPU time taken by the encoder interrupts (all zero with the PCNT backend
+    // or without ENCODER_ISR_STATS)
+    uint64_t window_cycles = r->isr_window_us * esp_rom_get_cpu_ticks_per_us();
+    for (uint8_t i = 0; i < axis_control_count(); i++) {
+        const encoder_isr_stats_t *isr = &r->isr[i];
+        float load_pct = window_cycles > 0 ? 100.0f * (float)isr->cycles / (float)window_cycles : 0.0f;
+        printf("ENCODER_ISR:axis=%u;calls=%lu;cycles=%llu;cycles_per_call=%lu;cpu_load_pct=%.2f\n",
+               (unsigned)i, (unsigned long)isr->calls, (unsigned long long)isr->cycles,
+               (unsigned long)(isr->calls > 0 ? isr->cycles / isr->calls : 0), load_pct);
+    }
+
+    printf("TRAJECTORY:committed=%lu;played=%lu;replaced=%lu;late=%lu;restarts=%lu\n",
+           (unsigned long)r->traj.committed, (unsigned long)r->traj.played, (unsigned long)r->traj.replaced,
+           (unsigned long)r->traj.late, (unsigned long)r->traj.restarts);
+
+    printf("TELEMETRY_STATS:queued=%lu;dropped=%lu;overflows=%lu;high_water=%lu;bytes=%lu\n",
+           (unsigned long)r->tx.queued, (unsigned long)r->tx.dropped, (unsigned long)r->tx.overflows,
+           (unsigned long)r->tx.high_water, (unsigned long)r->tx.bytes_sent);
+}
+
+/**
+ * @brief One control period. Runs in the high-priority control task every TS_MS,
+ * woken up by the hardware timer in control_tick.
+ */
+static void control_step(uint32_t tick_index, void *arg) {
+    // Every tick counts for the jitter, including the skipped ones.
+    LOOP_PROFILE_TICK(tick_cycles);
+    if (reset_holdoff_ticks > 0) {
+        reset_holdoff_ticks--;
+        return;
+    }
 
-        // --- Accumulate error for MSE ---
-        if (t_seconds <= 40.0f) { // Adjust duration if needed
-             sum_squared_error += pow(error, 2);
-             sample_count++;
+    // --- Reset Logic ---
+    if (gpio_get_level(RESET_BUTTON_PIN) == 0) {
+        // Send the MSE of the finished run as a telemetry frame for Python to catch
+        metrics_summary_t run;
+        run_metrics_get_run(&run);
+        if (run.samples > 0) {
+            telemetry_send_mse(run.mse);
         }
+        take_run_report();
 
-        float u_k = 0.0f;
-        #if USE_FUZZY_PID
-            PID_Difuso_U.error_signal = error;
-            PID_Difuso_step();
-            float u_fuzzy_pi = PID_Difuso_Y.out;
-            u_k = u_fuzzy_pi / 60.0f;
-        #else
-            simulink_control_U.error_signal = error;
-            simulink_control_step();
-            u_k = simulink_control_Y.u_k;
+        telemetry_send_reset(); // Send reset signal to Python
+        time_counter_ms = 0;
+        axis_control_reset();
+        session_record_reset();
+        #if CAPTURE_BUFFER
+        capture_buffer_reset();
         #endif
+        run_metrics_reset();
+        control_tick_reset_stats();
+        axis_control_reset_timing();
+        encoder_reset_isr_stats();
+        stats_start_us = (uint64_t)esp_timer_get_time();
+        reset_holdoff_ticks = RESET_HOLDOFF_MS / TS_MS;
+        return;
+    }
 
-        if (u_k > 1.0) u_k = 1.0;
-        if (u_k < 0.0) u_k = 0.0;
+    // --- Control Loop Logic ---
+    // Every axis runs its own step; the axes of the other core start in parallel.
+    uint64_t wake_us = (uint64_t)esp_timer_get_time();
+    float t_seconds = time_counter_ms / 1000.0f;
+    // The reference is evaluated once per period: the built-in profile, then
+    // any profile streamed from the host.
+    LOOP_PROFILE_START(stage_cycles);
+    trajectory_point_t reference;
+    trajectory_stream_reference(t_seconds, &reference);
+    LOOP_PROFILE_LAP(LOOP_STAGE_REFERENCE, stage_cycles);
+    axis_control_run(&reference, wake_us);
+    LOOP_PROFILE_LAP(LOOP_STAGE_AXES, stage_cycles);
 
-        float duty_cycle_to_set = DUTY_CYCLE_MIN + (u_k * (DUTY_CYCLE_MAX - DUTY_CYCLE_MIN));
-        motor_set_duty_cycle(duty_cycle_to_set);
+    telemetry_sample_t sample;
+    axis_control_get_sample(0, &sample);
 
-        #if SIMULATE_ENCODER
-            simulated_rpm = (0.95f * simulated_rpm) + (25.0f * u_k);
-        #endif
+    // --- Tracking metrics of axis 0 (METRICS_GET reads them at any time) ---
+    run_metrics_update(t_seconds, &reference, sample.measured_rpm, trajectory_stream_segment_key());
+    LOOP_PROFILE_LAP(LOOP_STAGE_METRICS, stage_cycles);
+
+    // Send telemetry data as a binary frame (no float formatting on the control task)
+    telemetry_send_sample(&sample);
+    // Raw inputs of the step, while a session is being recorded
+    session_record_tick(&reference, &sample);
+    #if CAPTURE_BUFFER
+    // Full state of every tick while a capture runs, dumped after the run
+    encoder_window_t window;
+    encoder_get_window(0, &window);
+    capture_buffer_tick(&sample, window.pulses, axis_control_active_controller(0));
+    #endif
+    LOOP_PROFILE_LAP(LOOP_STAGE_TELEMETRY, stage_cycles);
+    LOOP_PROFILE_LAP(LOOP_STAGE_TOTAL, tick_cycles);
 
-        // Send telemetry data
-        printf("%.2f,%.2f,%.2f\n", reference_rpm, measured_rpm, u_k);
+    time_counter_ms += TS_MS;
+}
+
+void app_main(void) {
+    // --- Initializations ---
+    configure_reset_button();
+    telemetry_init();
+    simulink_control_initialize();
+    PID_Difuso_initialize();
+    // Runtime parameters, tunable over the UART command channel
+    control_params_init();
+    trajectory_stream_init();
+    run_metrics_init(TS_MS);
+    #if LOOP_PROFILER
+    loop_profiler_init(TS_MS * 1000);
+    #endif
+    #if CAPTURE_BUFFER
+    capture_buffer_init();
+    #endif
+    // Session recording needs the encoder windows of axis 0, and replays the EMA
+    // (the observer would also need the duty cycles)
+    if (AXIS_IO == &axis_io_esp32 && !ENCODER_OBSERVER) {
+        session_record_init(TS_MS, ENCODER_MT_METHOD);
+    }
+    command_init();
+    // Motors, encoders and an instance of every registered controller per axis
+    if (!axis_control_init(axis_table, AXIS_COUNT, TS_MS)) {
+        printf("Error: could not start the axis worker\n");
+    }
 
-        time_counter_ms += TS_MS;
-        vTaskDelay(pdMS_TO_TICKS(TS_MS));
+    printf("Initializing system with %s control...\n",
+           controller_get(axis_control_active_controller(0))->name);
+    if (AXIS_IO != &axis_io_esp32) {
+        printf("!!! NO HARDWARE: %s BACKEND ACTIVE !!!\n", AXIS_IO->name);
+    }
+    printf("Axes in use: %d\n", AXIS_COUNT);
+    #if LOOP_PROFILER
+    printf("Loop profiler enabled (PROFILE_GET 0x%02x)\n", LOOP_PROFILE_CMD_GET);
+    #endif
+    #if CAPTURE_BUFFER
+    printf("Capture buffer enabled: %d ticks (CAPTURE 0x%02x, CAPTURE_DUMP 0x%02x)\n",
+           CAPTURE_CAPACITY, CAPTURE_CMD, CAPTURE_CMD_DUMP);
+    #endif
+    #if ENCODER_OBSERVER
+    printf("Speed estimate: observer (ENCODER_OBSERVER_MODEL)\n");
+    #endif
+    #if ENCODER_BACKEND == ENCODER_BACKEND_PCNT
+    printf("Encoder backend: PCNT\n");
+    #else
+    printf("Encoder backend: GPIO ISR\n");
+    #endif
+    printf("---------------------------------------------------------\n");
+
+    stats_start_us = (uint64_t)esp_timer_get_time();
+    report_task = xTaskGetCurrentTaskHandle();
+
+    // The control loop now runs in its own task, paced by a hardware timer,
+    // so the period no longer stretches by the time spent in the step itself.
+    if (!control_tick_start(TS_MS * 1000, control_step, NULL)) {
+        printf("Error: could not start the control tick\n");
+    }
+
+    // This task stays alive to print the report of every finished run.
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        print_run_report(&run_report);
+        #if LOOP_PROFILER
+        loop_profiler_print();
+        loop_profiler_clear();
+        #endif
+        atomic_store_explicit(&report_pending, false, memory_order_release);
     }
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "run_metrics.h"
+#include <string.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "command.h"
+#include "telemetry.h"
+
+// --- Published Metrics ---
+// Sequence lock, as for the parameter block but with the roles swapped: the
+// control task writes every period and never waits, the command task copies
+// what it needs and tries again if a write overlapped its copy.
+static metrics_t metrics;
+static atomic_uint metrics_seq;
+static float metrics_period_s = 0.01f;
+
+/**
+ * @brief Opens a write (control task only).
+ */
+static void run_metrics_write_begin(void) {
+    unsigned seq = atomic_load_explicit(&metrics_seq, memory_order_relaxed);
+    atomic_store_explicit(&metrics_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+/**
+ * @brief Publishes a write (control task only).
+ */
+static void run_metrics_write_end(void) {
+    unsigned seq = atomic_load_explicit(&metrics_seq, memory_order_relaxed);
+    atomic_store_explicit(&metrics_seq, seq + 1, memory_order_release);
+}
+
+/**
+ * @brief Copies one summary without blocking the control task.
+ * @param index RUN_METRICS_WHOLE_RUN or a stored segment.
+ * @param summary Destination.
+ * @param stored Number of stored segments at the time of the copy.
+ * @param found Set to false if the segment is not stored.
+ * @return true if the copy is consistent.
+ */
+static bool run_metrics_read(uint8_t index, metrics_summary_t *summary, uint8_t *stored, bool *found) {
+    unsigned before = atomic_load_explicit(&metrics_seq, memory_order_acquire);
+    if (before & 1u) {
+        return false; // Being written
+    }
+    const metrics_summary_t *source = (index == RUN_METRICS_WHOLE_RUN) ? &metrics.run : metrics_segment(&metrics, index);
+    *found = source != NULL;
+    if (*found) {
+        *summary = *source;
+    }
+    *stored = metrics_segments_stored(&metrics);
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&metrics_seq, memory_order_relaxed) == before;
+}
+
+void run_metrics_update(float t_seconds, const trajectory_point_t *reference, float measured_rpm,
+                        uint32_t segment_key) {
+    run_metrics_write_begin();
+    metrics_update(&metrics, t_seconds, reference->rpm, reference->rpm_per_s, measured_rpm, segment_key);
+    run_metrics_write_end();
+}
+
+void run_metrics_reset(void) {
+    run_metrics_write_begin();
+    metrics_reset(&metrics, metrics_period_s);
+    run_metrics_write_end();
+}
+
+void run_metrics_get_run(metrics_summary_t *summary) {
+    *summary = metrics.run;
+}
+
+// --- Little-endian helpers for the reply payload ---
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void put_f32(uint8_t *p, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    put_u32(p, bits);
+}
+
+static size_t run_metrics_cmd_get(const uint8_t *payload, size_t len, uint8_t *reply) {
+    if (len != 2) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+    }
+    metrics_summary_t s;
+    uint8_t stored = 0;
+    bool found = false;
+    int tries = 0;
+    while (!run_metrics_read(payload[1], &s, &stored, &found)) {
+        if (++tries >= RUN_METRICS_READ_TRIES) {
+            return command_ack(reply, payload[0], COMMAND_STATUS_BUSY);
+        }
+        vTaskDelay(1);
+    }
+    if (!found) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_BAD_ID);
+    }
+
+    reply[0] = TELEMETRY_FRAME_METRICS;
+    reply[1] = payload[1];
+    reply[2] = stored;
+    reply[3] = (uint8_t)s.number;
+    reply[4] = (uint8_t)(s.number >> 8);
+    put_u32(&reply[5], s.samples);
+    const float values[9] = { s.t_start, s.duration, s.mse, s.iae, s.itae,
+                              s.max_error, s.overshoot, s.settling_time, s.reference_end };
+    for (int i = 0; i < 9; i++) {
+        put_f32(&reply[9 + 4 * i], values[i]);
+    }
+    return 9 + 4 * 9;
+}
+
+void run_metrics_init(uint32_t period_ms) {
+    metrics_period_s = (float)period_ms / 1000.0f;
+    run_metrics_reset();
+    command_register(RUN_METRICS_CMD_GET, run_metrics_cmd_get);
+}
@@ -0,0 +1,47 @@
+#ifndef RUN_METRICS_H //header guard
+#define RUN_METRICS_H
+
+#include <stdint.h>
+#include "metrics.h"
+#include "trajectory_generator.h"
+
+// --- Command Opcodes ---
+// METRICS_GET: opcode | index u8  -> TELEMETRY_FRAME_METRICS, or an ACK (BAD_ID if not stored)
+//   index RUN_METRICS_WHOLE_RUN is the whole run, otherwise a stored segment (0 = oldest).
+// METRICS reply: type u8 | index u8 | stored u8 | number u16 | samples u32 | t_start f32
+//   | duration f32 | mse f32 | iae f32 | itae f32 | max_error f32 | overshoot f32
+//   | settling_time f32 | reference_end f32
+// The run keeps going; the reply is a snapshot of the metrics at that tick.
+#define RUN_METRICS_CMD_GET   0x30
+#define RUN_METRICS_WHOLE_RUN 0xFF
+
+// Attempts of the command task to get a consistent snapshot (one per RTOS tick).
+#define RUN_METRICS_READ_TRIES 4
+
+/**
+ * @brief Clears the metrics and registers the METRICS_GET command handler.
+ * @param period_ms The control period in milliseconds.
+ */
+void run_metrics_init(uint32_t period_ms);
+
+/**
+ * @brief Adds the sample of one control period (control task only).
+ * @param t_seconds Time since the start of the run.
+ * @param reference Reference of the period (its slope gives the direction of an overshoot).
+ * @param measured_rpm Measured speed of the tracked axis.
+ * @param segment_key Key of the trajectory segment (trajectory_stream_segment_key()).
+ */
+void run_metrics_update(float t_seconds, const trajectory_point_t *reference, float measured_rpm,
+                        uint32_t segment_key);
+
+/**
+ * @brief Starts a new run (control task only).
+ */
+void run_metrics_reset(void);
+
+/**
+ * @brief Whole-run results so far (control task only).
+ */
+void run_metrics_get_run(metrics_summary_t *summary);
+
+#endif //header guard
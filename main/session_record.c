@@ -0,0 +1,151 @@
+#include "session_record.h"
+#include <string.h>
+#include <stdatomic.h>
+#include "encoder_reader.h"
+#include "axis_control.h"
+#include "control_params.h"
+#include "command.h"
+
+// Axis whose inputs are recorded (the one sent over telemetry).
+#define SESSION_RECORD_AXIS 0
+
+static atomic_bool armed;             // Written by the command task
+static bool recording = false;        // Control task only
+static uint16_t tick_seq = 0;
+static uint32_t params_version = 0;   // Version of the last PARAMS record
+static uint32_t record_period_ms = 10;
+static bool record_mt_method = false;
+
+// --- Little-endian helpers for the records ---
+static uint8_t *put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static uint8_t *put_f32(uint8_t *p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return put_u32(p, bits);
+}
+
+static void session_record_header(void) {
+    encoder_filter_t filter;
+    encoder_get_filter(SESSION_RECORD_AXIS, &filter);
+    uint8_t flags = (record_mt_method ? SESSION_RECORD_FLAG_MT : 0) |
+                    (sizeof(real_T) == sizeof(float) ? SESSION_RECORD_FLAG_SINGLE : 0);
+
+    uint8_t record[SESSION_RECORD_HEADER_LEN];
+    uint8_t *p = record;
+    *p++ = TELEMETRY_FRAME_RECORD;
+    *p++ = SESSION_RECORD_HEADER;
+    *p++ = SESSION_RECORD_FORMAT;
+    *p++ = flags;
+    p = put_u16(p, (uint16_t)record_period_ms);
+    *p++ = axis_control_active_controller(SESSION_RECORD_AXIS);
+    p = put_f32(p, filter.filter_alpha);
+    p = put_f32(p, filter.filtered_rpm);
+    p = put_u32(p, filter.prev_edge_us);
+    *p++ = (uint8_t)filter.prev_edge_dir;
+    *p++ = filter.has_prev_edge ? 1 : 0;
+    put_f32(p, filter.mt_rpm);
+    telemetry_send_record(record, sizeof(record));
+}
+
+static void session_record_params(void) {
+    control_params_t params;
+    axis_control_get_params(SESSION_RECORD_AXIS, &params, &params_version);
+
+    uint8_t record[SESSION_RECORD_PARAMS_LEN];
+    uint16_t float_mask = 0;
+    for (uint8_t id = 0; id < CONTROL_PARAM_COUNT; id++) {
+        if (control_params_is_float(&params, id)) {
+            float_mask |= (uint16_t)(1u << id);
+        }
+        put_f32(&record[4 + 4 * id], control_params_get_value(&params, id));
+    }
+    record[0] = TELEMETRY_FRAME_RECORD;
+    record[1] = SESSION_RECORD_PARAMS;
+    put_u16(&record[2], float_mask);
+    telemetry_send_record(record, sizeof(record));
+}
+
+static void session_record_event(uint8_t kind) {
+    uint8_t record[2] = { TELEMETRY_FRAME_RECORD, kind };
+    telemetry_send_record(record, sizeof(record));
+}
+
+void session_record_reset(void) {
+    if (recording) {
+        session_record_event(SESSION_RECORD_RESET);
+    } else if (atomic_load_explicit(&armed, memory_order_relaxed)) {
+        recording = true;
+        tick_seq = 0;
+        session_record_header();
+        session_record_params();
+        session_record_event(SESSION_RECORD_RESET);
+    }
+}
+
+void session_record_tick(const trajectory_point_t *reference, const telemetry_sample_t *sample) {
+    if (!recording) {
+        return;
+    }
+    if (!atomic_load_explicit(&armed, memory_order_relaxed)) {
+        recording = false;
+        return;
+    }
+
+    // A new block takes effect at the start of a step, so it goes before that step.
+    control_params_t params;
+    uint32_t version;
+    axis_control_get_params(SESSION_RECORD_AXIS, &params, &version);
+    if (version != params_version) {
+        session_record_params();
+    }
+
+    encoder_window_t window;
+    encoder_get_window(SESSION_RECORD_AXIS, &window);
+
+    uint8_t record[SESSION_RECORD_TICK_LEN];
+    uint8_t *p = record;
+    *p++ = TELEMETRY_FRAME_RECORD;
+    *p++ = SESSION_RECORD_TICK;
+    p = put_u16(p, tick_seq++);
+    p = put_u32(p, (uint32_t)window.pulses);
+    p = put_u16(p, (uint16_t)window.delta_time_ms);
+    p = put_u32(p, window.last_edge_us);
+    *p++ = (uint8_t)window.last_edge_dir;
+    p = put_u32(p, window.now_us);
+    p = put_f32(p, reference->rpm);
+    p = put_f32(p, reference->rpm_per_s);
+    *p++ = axis_control_active_controller(SESSION_RECORD_AXIS);
+    put_f32(p, sample->u_k);
+    telemetry_send_record(record, sizeof(record));
+}
+
+/**
+ * @brief RECORD command handler (command task).
+ */
+static size_t session_record_cmd(const uint8_t *payload, size_t len, uint8_t *reply) {
+    if (len != 2) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+    }
+    atomic_store_explicit(&armed, (payload[1] & SESSION_RECORD_FLAG_ON) != 0, memory_order_relaxed);
+    return command_ack(reply, payload[0], COMMAND_STATUS_OK);
+}
+
+void session_record_init(uint32_t period_ms, bool mt_method) {
+    record_period_ms = period_ms;
+    record_mt_method = mt_method;
+    atomic_init(&armed, false);
+    command_register(SESSION_RECORD_CMD, session_record_cmd);
+}
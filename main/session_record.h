@@ -0,0 +1,73 @@
+#ifndef SESSION_RECORD_H //header guard
+#define SESSION_RECORD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "trajectory_generator.h"
+#include "telemetry.h"
+
+/*
+ * Session log of axis 0: the raw inputs of every control step, sent as
+ * TELEMETRY_FRAME_RECORD frames so a run on the bench can be replayed offline
+ * (host/session_replay.c) and give the same u_k sequence bit for bit.
+ *
+ * A recording is armed with RECORD and starts at the next run reset. It
+ * begins with HEADER, PARAMS and RESET records. After that there is one TICK
+ * per control step, a PARAMS record whenever the axis picks up a new
+ * parameter block, and a RESET record for every press of the reset button.
+ * Axis 0 must run on the ESP32 backend (its encoder windows are recorded).
+ */
+
+// --- Command Opcodes ---
+// RECORD: opcode | flags u8 -> ACK. SESSION_RECORD_FLAG_ON arms a recording
+// (it starts at the next reset); without it a running recording stops.
+#define SESSION_RECORD_CMD     0x32
+#define SESSION_RECORD_FLAG_ON 0x01
+
+// --- Record Format ---
+// Every record is: TELEMETRY_FRAME_RECORD u8 | kind u8 | fields (little endian)
+//   HEADER: format u8 | flags u8 | period_ms u16 | controller u8 | filter_alpha f32
+//           | filtered_rpm f32 | prev_edge_us u32 | prev_edge_dir i8 | has_prev_edge u8 | mt_rpm f32
+//   PARAMS: float_mask u16 | value f32 x CONTROL_PARAM_COUNT (ordered by id; bit i of
+//           the mask: value i is exact, otherwise it is the compiled default)
+//   RESET:  (nothing)
+//   TICK:   seq u16 | pulses i32 | delta_ms u16 | last_edge_us u32 | last_edge_dir i8
+//           | now_us u32 | reference_rpm f32 | reference_rpm_per_s f32 | controller u8 | u_k f32
+// The header carries the state of the speed estimate at the start, since the
+// encoder keeps running across resets.
+#define SESSION_RECORD_FORMAT 1
+
+#define SESSION_RECORD_HEADER 0
+#define SESSION_RECORD_PARAMS 1
+#define SESSION_RECORD_RESET  2
+#define SESSION_RECORD_TICK   3
+
+#define SESSION_RECORD_HEADER_LEN 25
+#define SESSION_RECORD_PARAMS_LEN 56
+#define SESSION_RECORD_TICK_LEN   32
+
+// Header flags
+#define SESSION_RECORD_FLAG_MT     0x01 // Speed from the hybrid M/T estimate
+#define SESSION_RECORD_FLAG_SINGLE 0x02 // Controllers built with real_T = float
+
+/**
+ * @brief Registers the RECORD command handler.
+ * @param period_ms The control period in milliseconds.
+ * @param mt_method Whether the encoder of axis 0 uses the M/T estimate (ENCODER_MT_METHOD).
+ */
+void session_record_init(uint32_t period_ms, bool mt_method);
+
+/**
+ * @brief The run was reset (control task only, after axis_control_reset()).
+ * Starts an armed recording, or logs the reset in a running one.
+ */
+void session_record_reset(void);
+
+/**
+ * @brief Logs the control step that just ran (control task only, after axis_control_run()).
+ * @param reference Reference of the period.
+ * @param sample Sample of axis 0.
+ */
+void session_record_tick(const trajectory_point_t *reference, const telemetry_sample_t *sample);
+
+#endif //header guard
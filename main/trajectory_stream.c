@@ -0,0 +1,106 @@
+#include "trajectory_stream.h"
+#include <string.h>
+#include <math.h>
+#include "command.h"
+
+// Built-in profile and the queue the host streams into.
+static trajectory_t builtin_profile;
+static trajectory_queue_t queue;
+
+// --- Little-endian helper for the command payloads ---
+static float get_f32(const uint8_t *p) {
+    uint32_t bits = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static size_t trajectory_cmd_begin(const uint8_t *payload, size_t len, uint8_t *reply) {
+    if (len != 1) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+    }
+    bool ok = trajectory_queue_begin(&queue) != NULL;
+    return command_ack(reply, payload[0], ok ? COMMAND_STATUS_OK : COMMAND_STATUS_BUSY);
+}
+
+static size_t trajectory_cmd_segment(const uint8_t *payload, size_t len, uint8_t *reply) {
+    trajectory_t *bank = trajectory_queue_filling(&queue);
+    if (bank == NULL) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_STATE);
+    }
+    if (len < 6) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+    }
+
+    // Every value after the kind byte is a float, apart from the degree of POLY.
+    uint8_t kind = payload[1];
+    float duration = get_f32(&payload[2]);
+    float values[TRAJECTORY_MAX_DEGREE + 1];
+    size_t count;
+    size_t pos = 6;
+    if (kind == TRAJ_SEGMENT_HOLD) {
+        count = 1;
+    } else if (kind == TRAJ_SEGMENT_BEZIER) {
+        count = 2;
+    } else if (kind == TRAJ_SEGMENT_POLY) {
+        if (len < 7 || payload[6] > TRAJECTORY_MAX_DEGREE) {
+            return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+        }
+        count = (size_t)payload[6] + 1;
+        pos = 7;
+    } else {
+        return command_ack(reply, payload[0], COMMAND_STATUS_BAD_ID);
+    }
+    if (len != pos + 4 * count) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+    }
+    for (size_t i = 0; i < count; i++) {
+        values[i] = get_f32(&payload[pos + 4 * i]);
+        if (!isfinite(values[i])) {
+            return command_ack(reply, payload[0], COMMAND_STATUS_BAD_VALUE);
+        }
+    }
+    if (!isfinite(duration)) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_BAD_VALUE);
+    }
+
+    bool ok;
+    if (kind == TRAJ_SEGMENT_HOLD) {
+        ok = trajectory_add_hold(bank, duration, values[0]);
+    } else if (kind == TRAJ_SEGMENT_BEZIER) {
+        ok = trajectory_add_bezier(bank, duration, values[0], values[1]);
+    } else {
+        ok = trajectory_add_polynomial(bank, duration, values, (uint8_t)(count - 1));
+    }
+    // Fails on a non-positive duration or a full bank.
+    return command_ack(reply, payload[0], ok ? COMMAND_STATUS_OK : COMMAND_STATUS_BAD_VALUE);
+}
+
+static size_t trajectory_cmd_commit(const uint8_t *payload, size_t len, uint8_t *reply) {
+    if (len != 2) {
+        return command_ack(reply, payload[0], COMMAND_STATUS_MALFORMED);
+    }
+    bool ok = trajectory_queue_commit(&queue, (payload[1] & TRAJ_FLAG_REPLACE) != 0);
+    return command_ack(reply, payload[0], ok ? COMMAND_STATUS_OK : COMMAND_STATUS_STATE);
+}
+
+void trajectory_stream_init(void) {
+    trajectory_build_default(&builtin_profile);
+    trajectory_queue_init(&queue, &builtin_profile);
+
+    command_register(TRAJ_CMD_BEGIN, trajectory_cmd_begin);
+    command_register(TRAJ_CMD_SEGMENT, trajectory_cmd_segment);
+    command_register(TRAJ_CMD_COMMIT, trajectory_cmd_commit);
+}
+
+void trajectory_stream_reference(float t_seconds, trajectory_point_t *reference) {
+    trajectory_queue_eval(&queue, t_seconds, reference);
+}
+
+uint32_t trajectory_stream_segment_key(void) {
+    return trajectory_queue_segment_key(&queue);
+}
+
+void trajectory_stream_get_stats(trajectory_queue_stats_t *stats) {
+    trajectory_queue_get_stats(&queue, stats);
+}
@@ -0,0 +1,48 @@
+#ifndef TRAJECTORY_STREAM_H //header guard
+#define TRAJECTORY_STREAM_H
+
+#include "trajectory_queue.h"
+
+// --- Command Opcodes ---
+// A profile is uploaded bank by bank (up to TRAJECTORY_MAX_SEGMENTS segments each):
+// TRAJ_BEGIN:   opcode                                   -> ACK (BUSY while both banks are in use)
+// TRAJ_SEGMENT: opcode | kind u8 | duration f32 | data   -> ACK
+//   HOLD:       rpm f32
+//   BEZIER:     from_rpm f32 | to_rpm f32
+//   POLY:       degree u8 | coef f32 x (degree + 1)      (powers of the progress 0..1)
+// TRAJ_COMMIT:  opcode | flags u8                        -> ACK
+// Each bank starts when the one before it ends, or at once with TRAJ_FLAG_REPLACE.
+#define TRAJ_CMD_BEGIN   0x20
+#define TRAJ_CMD_SEGMENT 0x21
+#define TRAJ_CMD_COMMIT  0x22
+
+#define TRAJ_SEGMENT_HOLD   0
+#define TRAJ_SEGMENT_BEZIER 1
+#define TRAJ_SEGMENT_POLY   2
+
+#define TRAJ_FLAG_REPLACE 0x01
+
+/**
+ * @brief Compiles the built-in profile, makes it the base of the queue and
+ * registers the upload commands.
+ */
+void trajectory_stream_init(void);
+
+/**
+ * @brief Reference speed and its derivatives at time 't_seconds' of the run
+ * (control task only). Plays the built-in profile, then the uploaded banks in
+ * order; a time earlier than the last call restarts the built-in profile.
+ */
+void trajectory_stream_reference(float t_seconds, trajectory_point_t *reference);
+
+/**
+ * @brief Key of the segment of the last reference (see trajectory_queue_segment_key()).
+ */
+uint32_t trajectory_stream_segment_key(void);
+
+/**
+ * @brief Copies the queue counters.
+ */
+void trajectory_stream_get_stats(trajectory_queue_stats_t *stats);
+
+#endif //header guard
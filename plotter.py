@@ -1,4 +1,5 @@
 import sys
+import struct
 import serial
 import pyqtgraph as pg
 from pyqtgraph.Qt import QtCore, QtWidgets
@@ -9,6 +10,186 @@ PORT = '/dev/ttyUSB0' # ❗ Change this to your port
 BAUD = 115200
 # ====================================================================
 
+# ===== BINARY TELEMETRY FORMAT (see drivers/telemetry/telemetry.h) ==
+FRAME_SAMPLE = 0x01
+FRAME_RESET = 0x02
+FRAME_MSE = 0x03
+FRAME_PARAMS = 0x04
+FRAME_ACK = 0x05
+FRAME_METRICS = 0x06
+FRAME_RECORD = 0x07
+FRAME_CAPTURE = 0x08
+FRAME_STATES = 0x09
+RPM_SCALE = 0.1
+# type, seq, timestamp_us, reference, measured, u_k (Q16)
+SAMPLE_STRUCT = struct.Struct('<BHIhhH')
+# type, seq, state0, state1 (TELEMETRY_STATES builds)
+STATES_STRUCT = struct.Struct('<BHff')
+
+# ===== COMMANDS (see main/control_params.h) =========================
+CMD_PARAM_GET = 0x10
+CMD_PARAM_SET = 0x11
+CMD_SELECT_CONTROLLER = 0x12
+# Registry ids of the built-in controllers (see main/controller_registry.h)
+CONTROLLER_IDS = {'pid': 0, 'fuzzy': 1}
+# Parameter ids, in the order of the PARAMS reply
+PARAM_NAMES = ['pid_kp', 'pid_ki', 'pid_kd', 'pid_n',
+               'fuzzy_kp', 'fuzzy_ki', 'fuzzy_kd',
+               'fuzzy_e_range', 'fuzzy_de_range', 'fuzzy_out_range',
+               'ff_ks', 'ff_kv', 'ff_ka']
+ACK_STATUS = {0: 'ok', 1: 'unknown command', 2: 'malformed', 3: 'bad id', 4: 'bad value', 5: 'busy',
+              6: 'wrong state'}
+ACK_OK, ACK_BUSY = 0, 5
+
+# ===== TRAJECTORY UPLOAD (see main/trajectory_stream.h) ============
+CMD_TRAJ_BEGIN = 0x20
+CMD_TRAJ_SEGMENT = 0x21
+CMD_TRAJ_COMMIT = 0x22
+TRAJ_FLAG_REPLACE = 0x01
+TRAJ_SEGMENT_KINDS = {'hold': (0, 1), 'bezier': (1, 2), 'poly': (2, None)}  # kind, number of values
+TRAJ_BANK_SEGMENTS = 16  # TRAJECTORY_MAX_SEGMENTS
+
+# ===== RUN METRICS (see main/run_metrics.h) ========================
+CMD_METRICS_GET = 0x30
+METRICS_WHOLE_RUN = 0xFF
+# type, index, stored, number, samples, then the values of METRICS_FIELDS
+METRICS_STRUCT = struct.Struct('<BBBHI9f')
+# Loop profiler (see main/loop_profiler.h; only in LOOP_PROFILER builds)
+CMD_PROFILE_GET = 0x31
+PROFILE_FLAG_CLEAR = 0x01
+# Session recording (see main/session_record.h): starts at the next reset
+CMD_RECORD = 0x32
+RECORD_FLAG_ON = 0x01
+# Capture buffer (see main/capture_buffer.h; only in CAPTURE_BUFFER builds)
+CMD_CAPTURE = 0x33
+CMD_CAPTURE_DUMP = 0x34
+CAPTURE_FLAG_ON, CAPTURE_FLAG_RING = 0x01, 0x02
+# type, index, count, timestamp_us, pulses, reference, measured, state[2], u_k, controller
+CAPTURE_STRUCT = struct.Struct('<BHHIi5fB')
+CAPTURE_FIELDS = ['timestamp_us', 'pulses', 'reference_rpm', 'measured_rpm', 'state0', 'state1',
+                  'u_k', 'controller']
+METRICS_FIELDS = ['t_start', 'duration', 'mse', 'iae', 'itae', 'max_error', 'overshoot',
+                  'settling_time', 'reference_end']
+
+def cobs_encode(data):
+    """Consistent Overhead Byte Stuffing, same as cobs_encode() on the ESP32."""
+    out = bytearray([0])
+    code_pos, code = 0, 1
+    for byte in data:
+        if byte == 0:
+            out[code_pos] = code
+            code_pos, code = len(out), 1
+            out.append(0)
+        else:
+            out.append(byte)
+            code += 1
+            if code == 0xFF:
+                out[code_pos] = code
+                code_pos, code = len(out), 1
+                out.append(0)
+    out[code_pos] = code
+    return bytes(out)
+
+def encode_frame(payload):
+    """Payload -> CRC -> COBS -> 0x00 delimiter."""
+    return cobs_encode(payload + struct.pack('<H', crc16_ccitt(payload))) + b'\x00'
+
+def parse_command(text):
+    """'get', 'metrics', 'profile [clear]', 'capture on [ring]|off', 'select <controller> [axis]' or 'name=value ...' -> command payload.
+    Raises ValueError on bad input."""
+    text = text.strip()
+    if text == 'get':
+        return bytes([CMD_PARAM_GET])
+    if text == 'metrics':
+        return bytes([CMD_METRICS_GET, METRICS_WHOLE_RUN])
+    if text in ('capture on', 'capture on ring', 'capture off'):
+        flags = 0 if text.endswith('off') else CAPTURE_FLAG_ON | (CAPTURE_FLAG_RING if text.endswith('ring') else 0)
+        return bytes([CMD_CAPTURE, flags])
+    if text in ('profile', 'profile clear'):
+        return bytes([CMD_PROFILE_GET, PROFILE_FLAG_CLEAR if text.endswith('clear') else 0])
+    if text.startswith('select'):
+        words = text.split()
+        if len(words) not in (2, 3) or words[1] not in CONTROLLER_IDS:
+            raise ValueError("usage: select pid|fuzzy [axis]")
+        axis = int(words[2]) if len(words) == 3 else 0xFF
+        return bytes([CMD_SELECT_CONTROLLER, axis, CONTROLLER_IDS[words[1]]])
+    payload = bytearray([CMD_PARAM_SET])
+    for item in text.split():
+        name, _, value = item.partition('=')
+        if name not in PARAM_NAMES or not value:
+            raise ValueError(f"unknown parameter or missing value: {item}")
+        payload += bytes([PARAM_NAMES.index(name)]) + struct.pack('<f', float(value))
+    if len(payload) == 1:
+        raise ValueError("nothing to set")
+    return bytes(payload)
+
+def load_trajectory(path, replace=False):
+    """Reads a profile file and returns the command payloads that upload it.
+    One segment per line: 'hold <s> <rpm>', 'bezier <s> <from> <to>' or
+    'poly <s> <c0> ... <cN>' (powers of the progress 0..1); '#' starts a comment.
+    The segments are sent in banks of TRAJ_BANK_SEGMENTS; only the first bank
+    may replace the running profile, the others follow it."""
+    segments = []
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            words = line.split('#')[0].split()
+            if not words:
+                continue
+            if words[0] not in TRAJ_SEGMENT_KINDS:
+                raise ValueError(f"{path}:{number}: unknown segment '{words[0]}'")
+            kind, count = TRAJ_SEGMENT_KINDS[words[0]]
+            values = [float(w) for w in words[1:]]
+            if len(values) < 2 or (count is not None and len(values) != count + 1) or len(values) > 12:
+                raise ValueError(f"{path}:{number}: wrong number of values")
+            payload = bytes([CMD_TRAJ_SEGMENT, kind]) + struct.pack('<f', values[0])
+            if count is None:
+                payload += bytes([len(values) - 2])
+            segments.append(payload + struct.pack(f'<{len(values) - 1}f', *values[1:]))
+    if not segments:
+        raise ValueError(f"{path}: no segments")
+
+    payloads = []
+    for start in range(0, len(segments), TRAJ_BANK_SEGMENTS):
+        flags = TRAJ_FLAG_REPLACE if replace and start == 0 else 0
+        payloads.append(bytes([CMD_TRAJ_BEGIN]))
+        payloads.extend(segments[start:start + TRAJ_BANK_SEGMENTS])
+        payloads.append(bytes([CMD_TRAJ_COMMIT, flags]))
+    return payloads
+
+def cobs_decode(data):
+    """Reverses Consistent Overhead Byte Stuffing. Returns None if malformed."""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data) + 1:
+            return None
+        out.extend(data[i + 1:i + code])
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+def crc16_ccitt(data):
+    """CRC-16/CCITT-FALSE, same as telemetry_crc16() on the ESP32."""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+def decode_frame(packet):
+    """Returns the payload of a COBS packet (without delimiter) or None if it is corrupt."""
+    raw = cobs_decode(packet)
+    if raw is None or len(raw) < 3:
+        return None
+    payload, crc = raw[:-2], raw[-2] | (raw[-1] << 8)
+    if crc16_ccitt(payload) != crc:
+        return None
+    return payload
+# ====================================================================
+
 # Thread to read serial port without blocking the GUI
 class SerialReader(QtCore.QThread):
     # Signal now emits three values: ref, med, control
@@ -16,6 +197,8 @@ class SerialReader(QtCore.QThread):
     reset_signal = QtCore.pyqtSignal()
     # --- NEW SIGNAL for MSE ---
     mse_received = QtCore.pyqtSignal(float) # Carries the MSE value
+    ack_received = QtCore.pyqtSignal(int, int) # opcode, status
+    metrics_received = QtCore.pyqtSignal(int, int, object) # index, segments stored, {field: value}
 
     def __init__(self, port, baud):
         super().__init__()
@@ -23,6 +206,11 @@ class SerialReader(QtCore.QThread):
         self.baud = baud
         self.running = True
         self.ser = None
+        self.last_seq = None
+        # Open session log while recording: RECORD frames are written to it as received
+        self.record_file = None
+        # CSV file of a capture dump in progress
+        self.capture_file = None
 
     def run(self):
         print(f"Attempting to connect to {self.port} at {self.baud} baud...")
@@ -33,38 +221,81 @@ class SerialReader(QtCore.QThread):
             print(f"Error: Could not open serial port: {e}")
             return
 
+        buffer = bytearray()
         while self.running and self.ser.is_open:
             try:
-                line = self.ser.readline().decode('utf-8').strip()
-                if line:
-                    # --- CHECK FOR MSE RESULT FIRST ---
-                    if line.startswith("MSE_RESULT:"):
-                        try:
-                            mse_value = float(line.split(":")[1])
-                            self.mse_received.emit(mse_value) # Emit the MSE value
-                        except (IndexError, ValueError):
-                            print(f"Warning: Could not parse MSE line: {line}")
-                        continue # Skip processing this line as telemetry
-                    # --- END OF MSE CHECK ---
-
-                    elif "RESET" in line: # Check for RESET signal
-                        self.reset_signal.emit()
-                        continue # Skip processing this line as telemetry
-
-                    # --- Process normal telemetry data ---
-                    parts = line.split(',')
-                    if len(parts) == 3:
-                        ref = float(parts[0])
-                        med = float(parts[1])
-                        ctrl = float(parts[2])
-                        self.data_received.emit(ref, med, ctrl)
-            except (serial.SerialException, UnicodeDecodeError, ValueError):
+                chunk = self.ser.read(self.ser.in_waiting or 1)
+            except serial.SerialException:
                 continue # Ignore errors and continue reading
+            buffer.extend(chunk)
+
+            # Every frame ends with a 0x00 delimiter
+            while True:
+                end = buffer.find(b'\x00')
+                if end < 0:
+                    break
+                packet = bytes(buffer[:end])
+                del buffer[:end + 1]
+                self.handle_packet(packet)
 
         if self.ser.is_open:
             self.ser.close()
         print("Serial reader thread has stopped.")
 
+    def handle_packet(self, packet):
+        frame = decode_frame(packet)
+        if frame is None and b'\n' in packet:
+            # Text printed by the firmware (boot log, TICK_STATS...) ends up in front of
+            # the next frame; print it and retry with whatever follows the last newline.
+            text, _, packet = packet.rpartition(b'\n')
+            for line in text.decode('utf-8', errors='replace').splitlines():
+                if line.strip():
+                    print(line.strip())
+            frame = decode_frame(packet)
+        if frame is None:
+            return
+
+        frame_type = frame[0]
+        if frame_type == FRAME_SAMPLE and len(frame) == SAMPLE_STRUCT.size:
+            _, seq, _timestamp_us, ref, med, u_k = SAMPLE_STRUCT.unpack(frame)
+            if self.last_seq is not None and seq != (self.last_seq + 1) & 0xFFFF:
+                print(f"Warning: {(seq - self.last_seq - 1) & 0xFFFF} telemetry frame(s) lost")
+            self.last_seq = seq
+            self.data_received.emit(ref * RPM_SCALE, med * RPM_SCALE, u_k / 65535.0)
+        elif frame_type == FRAME_STATES and len(frame) == STATES_STRUCT.size:
+            pass  # Not plotted
+        elif frame_type == FRAME_RESET:
+            self.last_seq = None
+            self.reset_signal.emit()
+        elif frame_type == FRAME_MSE and len(frame) == 5:
+            self.mse_received.emit(struct.unpack_from('<f', frame, 1)[0])
+        elif frame_type == FRAME_PARAMS and len(frame) >= 6:
+            version, count = struct.unpack_from('<IB', frame, 1)
+            values = struct.unpack_from(f'<{count}f', frame, 6)
+            listing = ' '.join(f"{PARAM_NAMES[i] if i < len(PARAM_NAMES) else i}={v:g}"
+                               for i, v in enumerate(values))
+            print(f"PARAMS v{version}: {listing}")
+        elif frame_type == FRAME_ACK and len(frame) == 3:
+            self.ack_received.emit(frame[1], frame[2])
+        elif frame_type == FRAME_METRICS and len(frame) == METRICS_STRUCT.size:
+            _, index, stored, number, samples, *values = METRICS_STRUCT.unpack(frame)
+            fields = dict(zip(METRICS_FIELDS, values), number=number, samples=samples)
+            self.metrics_received.emit(index, stored, fields)
+        elif frame_type == FRAME_CAPTURE and len(frame) == CAPTURE_STRUCT.size:
+            capture_file = self.capture_file
+            if capture_file is not None:
+                _, index, count, *values = CAPTURE_STRUCT.unpack(frame)
+                capture_file.write(','.join(f"{v:.9g}" if isinstance(v, float) else str(v) for v in values) + '\n')
+        elif frame_type == FRAME_RECORD:
+            record_file = self.record_file
+            if record_file is not None:
+                record_file.write(encode_frame(frame))
+
+    def send_frame(self, payload):
+        """Sends one command frame to the ESP32."""
+        if self.ser is not None and self.ser.is_open:
+            self.ser.write(encode_frame(payload))
+
     def stop(self):
         self.running = False
         self.wait()
@@ -103,6 +334,12 @@ class MainWindow(QtWidgets.QMainWindow):
         self.control_curve = self.control_plot.plot(pen='c', name="Control (u_k)")
         self.control_plot.setXLink(self.velocity_plot)
 
+        # --- Command line: 'get', 'select fuzzy' or 'pid_kp=0.02 pid_ki=1.5 ...' ---
+        self.command_edit = QtWidgets.QLineEdit()
+        self.command_edit.setPlaceholderText("get | metrics | profile [clear] | select pid|fuzzy [axis] | traj <file> [now] | record on <file>|off | capture on [ring]|off|dump <file> | " + " ".join(f"{n}=..." for n in PARAM_NAMES[:3]) + " ...")
+        self.command_edit.returnPressed.connect(self.send_command)
+        layout.addWidget(self.command_edit)
+
         # --- Data Buffers (no changes) ---
         self.time_data = []
         self.ref_data = []
@@ -115,6 +352,12 @@ class MainWindow(QtWidgets.QMainWindow):
         self.serial_reader.reset_signal.connect(self.reset_plots)
         # --- CONNECT NEW MSE SIGNAL ---
         self.serial_reader.mse_received.connect(self.display_mse) # Connect to the new slot
+        self.serial_reader.ack_received.connect(self.handle_ack)
+        self.serial_reader.metrics_received.connect(self.handle_metrics)
+        # Segments still to request after a 'metrics' command
+        self.metrics_pending = []
+        # Pending trajectory upload: sent one frame at a time, paced by the ACKs
+        self.upload = []
         self.serial_reader.start()
 
     # --- Slot for updating plots (no changes) ---
@@ -150,10 +393,102 @@ class MainWindow(QtWidgets.QMainWindow):
         print(f"Run Complete. Mean Squared Error (MSE): {mse_value:.4f}")
         print("===================================\n")
 
+    def send_command(self):
+        """Parses the command line and sends the command (or starts a trajectory upload)."""
+        text = self.command_edit.text().strip()
+        try:
+            if text.startswith('traj'):
+                words = text.split()
+                if len(words) not in (2, 3) or (len(words) == 3 and words[2] != 'now'):
+                    raise ValueError("usage: traj <file> [now]")
+                self.upload = load_trajectory(words[1], replace=len(words) == 3)
+                print(f"Uploading {words[1]} ({len(self.upload)} frames)...")
+                payload = self.upload[0]
+            elif text.startswith('capture dump'):
+                payload = self.capture_dump(text.split())
+            elif text.startswith('record'):
+                payload = self.record_command(text.split())
+            else:
+                payload = parse_command(text)
+        except (ValueError, OSError) as e:
+            print(f"Command error: {e}")
+            return
+        self.serial_reader.send_frame(payload)
+        self.command_edit.clear()
+
+    def record_command(self, words):
+        """'record on <file>' opens the session log and arms a recording, 'record off' stops it.
+        Replay the file with host/session_replay."""
+        if words == ['record', 'off']:
+            record_file, self.serial_reader.record_file = self.serial_reader.record_file, None
+            if record_file is not None:
+                record_file.close()
+                print(f"Session log {record_file.name} closed.")
+            return bytes([CMD_RECORD, 0])
+        if len(words) != 3 or words[1] != 'on':
+            raise ValueError("usage: record on <file> | record off")
+        if self.serial_reader.record_file is not None:
+            raise ValueError("already recording, 'record off' first")
+        self.serial_reader.record_file = open(words[2], 'wb')
+        print(f"Recording to {words[2]} from the next reset...")
+        return bytes([CMD_RECORD, RECORD_FLAG_ON])
+
+    def capture_dump(self, words):
+        """'capture dump <file.csv>': writes every entry of the capture buffer to the file."""
+        if len(words) != 3:
+            raise ValueError("usage: capture dump <file.csv>")
+        if self.serial_reader.capture_file is not None:
+            raise ValueError("a dump is already in progress")
+        capture_file = open(words[2], 'w')
+        capture_file.write(','.join(CAPTURE_FIELDS) + '\n')
+        self.serial_reader.capture_file = capture_file
+        print(f"Dumping the capture buffer to {words[2]}...")
+        return bytes([CMD_CAPTURE_DUMP])
+
+    def handle_ack(self, opcode, status):
+        """Prints command results and drives a pending trajectory upload."""
+        if opcode == CMD_CAPTURE_DUMP and self.serial_reader.capture_file is not None:
+            # The ACK follows the last entry
+            capture_file, self.serial_reader.capture_file = self.serial_reader.capture_file, None
+            capture_file.close()
+            print(f"Capture dump {capture_file.name}: {ACK_STATUS.get(status, status)}")
+            return
+        if not self.upload or opcode != self.upload[0][0]:
+            print(f"Command 0x{opcode:02x}: {ACK_STATUS.get(status, status)}")
+            return
+        if status == ACK_BUSY and opcode == CMD_TRAJ_BEGIN:
+            # Both banks are in use: try again once the device has played one.
+            QtCore.QTimer.singleShot(200, lambda: self.serial_reader.send_frame(self.upload[0]))
+            return
+        if status != ACK_OK:
+            print(f"Upload aborted, command 0x{opcode:02x}: {ACK_STATUS.get(status, status)}")
+            self.upload = []
+            return
+        self.upload.pop(0)
+        if self.upload:
+            self.serial_reader.send_frame(self.upload[0])
+        else:
+            print("Upload complete.")
+
+    def handle_metrics(self, index, stored, m):
+        """Prints one METRICS reply; after the whole run, requests every stored segment."""
+        name = 'run' if index == METRICS_WHOLE_RUN else f"segment {m['number']}"
+        print(f"METRICS {name}: t={m['t_start']:.2f}+{m['duration']:.2f}s samples={m['samples']} "
+              f"mse={m['mse']:.2f} iae={m['iae']:.2f} itae={m['itae']:.2f} max_error={m['max_error']:.1f} "
+              f"overshoot={m['overshoot']:.1f} settling={m['settling_time']:.2f}s ref_end={m['reference_end']:.1f}")
+        if index == METRICS_WHOLE_RUN:
+            self.metrics_pending = list(range(stored))
+        elif self.metrics_pending and self.metrics_pending[0] == index:
+            self.metrics_pending.pop(0)
+        if self.metrics_pending:
+            self.serial_reader.send_frame(bytes([CMD_METRICS_GET, self.metrics_pending[0]]))
+
     # --- Close event (no changes) ---
     def closeEvent(self, event):
         print("Window closed. Stopping serial reader thread...")
         self.serial_reader.stop()
+        if self.serial_reader.record_file is not None:
+            self.serial_reader.record_file.close()
         event.accept()
 
 # --- Main entry point (no changes) ---